@@ -1,4 +1,5 @@
 #include "Game.hpp"
+#include "../../common/utils/Trace.hpp"
 #include <iostream>
 
 Game::Game() : m_pWindow(nullptr), m_pStateMachine(nullptr), m_bRunning(false) {}
@@ -27,6 +28,7 @@ bool Game::init(const char* title, int width, int height) {
 }
 
 void Game::handleEvents() {
+    Trace::Span span("handle_events", "client");
     // Delegate event handling to Window (which calls InputHandler)
     m_pWindow->handleEvents();
     // Check window turn off
@@ -36,11 +38,13 @@ void Game::handleEvents() {
 }
 
 void Game::update() {
+    Trace::Span span("update", "client");
     // Delegate logic updates to the current State
     m_pStateMachine->update();
 }
 
 void Game::render() {
+    Trace::Span span("render", "client");
     // 1. Clear Screen
     m_pWindow->clear();
 
@@ -0,0 +1,523 @@
+#include "network/IngameClient.hpp"
+#include "../common/utils/ProcStat.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Headless load generator for the ingame server. Every match is one server process
+// (each hosts a single room) with INGAME_MAX_PLAYERS bot clients that play like the
+// SDL client: STOP every frame while waiting, and during their turn walk, hold the
+// angle key, charge and fire.
+//
+// Usage: ingame_load [--matches N] [--host H] [--port P] [--duration S] [--warmup S]
+//                    [--map NAME] [--spawn SERVER_BIN] [--server-pid PID]... [--out FILE]
+//
+// Match i connects to port P + i. With --spawn the tool starts those servers itself
+// (each in its own scratch directory, so their recordings don't collide) and stops
+// them at the end; otherwise pass --server-pid for each running server to get CPU use.
+//
+// Reported: input -> state latency (an angle step until a snapshot shows it), input ->
+// ack round trips (the seq echoed in snapshots), ping RTT, snapshot inter-arrival times
+// and RFC 3550 jitter, server tick rate, bandwidth and server CPU.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+constexpr double kFrameSeconds = 1.0 / 60.0;
+constexpr double kNominalIntervalMs = 1000.0 / 60.0;
+constexpr float kAngleStep = 0.5f;
+constexpr std::chrono::seconds kProbeTimeout(2);
+
+struct LoadConfig {
+    std::string host = "127.0.0.1";
+    int port = 9090;
+    int matches = 1;
+    double duration = 30.0;
+    double warmup = 2.0;
+    std::string map;
+    std::string spawn;
+    std::vector<int> serverPids;
+    std::string outPath;
+};
+
+std::atomic<bool> g_measuring(false);
+std::atomic<bool> g_stop(false);
+
+double Ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+struct Bot {
+    IngameClient client;
+    int match = 0;
+    std::mt19937 rng;
+
+    // Shared with the receiver thread.
+    std::mutex stateMutex;
+    ResIngameState state{};
+    bool hasState = false;
+    struct Probe {
+        Clock::time_point sent;
+        float expected; // angle once this step is applied
+        float direction;
+    };
+    std::deque<Probe> probes;
+    std::vector<double> latencyMs;
+
+    // Receiver thread only (read once the client is closed).
+    Clock::time_point lastArrival;
+    bool hasArrival = false;
+    std::vector<double> intervalsMs;
+    double jitterMs = 0.0;
+    uint32_t firstTick = 0, lastTick = 0;
+    Clock::time_point firstTickAt, lastTickAt;
+
+    // Driver thread only.
+    enum Phase { WAITING, WALKING, AIMING, CHARGING, FIRED };
+    Phase phase = WAITING;
+    bool walkRight = false;
+    float targetAngle = 0.0f;
+    Clock::time_point phaseEnd;
+    uint64_t bytesInStart = 0, bytesOutStart = 0;
+
+    void OnPacket(Packet& p) {
+        if (p.header.type != PacketType::RES_INGAME_STATE || p.payload.size() < sizeof(ResIngameState)) return;
+        const ResIngameState s = p.GetPayload<ResIngameState>();
+        const auto now = Clock::now();
+
+        if (g_measuring) {
+            if (hasArrival) {
+                const double interval = Ms(now - lastArrival);
+                intervalsMs.push_back(interval);
+                jitterMs += (std::fabs(interval - kNominalIntervalMs) - jitterMs) / 16.0;
+            }
+            if (firstTick == 0) {
+                firstTick = s.tick;
+                firstTickAt = now;
+            }
+            lastTick = s.tick;
+            lastTickAt = now;
+        }
+        lastArrival = now;
+        hasArrival = true;
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        state = s;
+        hasState = true;
+
+        // Angle steps show up in order; time each from its send to this arrival.
+        const NetPlayerState* me = nullptr;
+        for (uint8_t i = 0; i < s.playerCount && i < INGAME_MAX_PLAYERS; i++) {
+            if (s.players[i].id == client.GetPlayerId()) me = &s.players[i];
+        }
+        while (me && !probes.empty()) {
+            const Probe& p = probes.front();
+            const bool applied = (p.direction > 0.0f) ? me->angle >= p.expected - 1e-3f : me->angle <= p.expected + 1e-3f;
+            if (applied) {
+                if (g_measuring) latencyMs.push_back(Ms(now - p.sent));
+            } else if (now - p.sent < kProbeTimeout) {
+                break;
+            }
+            probes.pop_front();
+        }
+    }
+};
+
+struct ServerProcess {
+    pid_t pid = -1;
+    bool spawned = false;
+    double cpuStart = 0.0;
+    double cpuEnd = 0.0;
+};
+
+pid_t SpawnServer(const std::string& binary, int port, const std::string& workDir) {
+    const pid_t pid = fork();
+    if (pid != 0) return pid;
+
+    // Child: quiet, in its own directory, no server-side bots.
+    const int devNull = open("/dev/null", O_WRONLY);
+    if (devNull >= 0) {
+        dup2(devNull, STDOUT_FILENO);
+        dup2(devNull, STDERR_FILENO);
+    }
+    if (chdir(workDir.c_str()) != 0) _exit(127);
+    const std::string portArg = std::to_string(port);
+    execl(binary.c_str(), binary.c_str(), portArg.c_str(), "--bot-fill", "-1", (char*)nullptr);
+    _exit(127);
+}
+
+void StopServer(pid_t pid) {
+    kill(pid, SIGINT);
+    for (int i = 0; i < 30; i++) {
+        if (waitpid(pid, nullptr, WNOHANG) == pid) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+
+// One frame of a bot: sends what a player holding keys would send this frame.
+void Drive(Bot& bot, Clock::time_point now) {
+    ResIngameState s{};
+    float pendingAngle = 0.0f;
+    bool hasPending = false;
+    {
+        std::lock_guard<std::mutex> lock(bot.stateMutex);
+        if (!bot.hasState) return;
+        s = bot.state;
+        if (!bot.probes.empty()) {
+            pendingAngle = bot.probes.back().expected;
+            hasPending = true;
+        }
+    }
+
+    const NetPlayerState* me = nullptr;
+    for (uint8_t i = 0; i < s.playerCount && i < INGAME_MAX_PLAYERS; i++) {
+        if (s.players[i].id == bot.client.GetPlayerId()) me = &s.players[i];
+    }
+    if (!me) return;
+
+    // RoomState values: 0 waiting, 1 playing, 2 firing, 3 game over.
+    const bool canAct = s.roomState == 1u && me->isMyTurn;
+    if (!canAct) {
+        bot.phase = Bot::WAITING;
+        bot.client.SendInput(INGAME_CMD_STOP);
+        return;
+    }
+
+    auto seconds = [&](double lo, double hi) {
+        std::uniform_real_distribution<double> d(lo, hi);
+        return now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(d(bot.rng)));
+    };
+
+    if (bot.phase == Bot::WAITING) {
+        bot.phase = Bot::WALKING;
+        bot.walkRight = (bot.rng() & 1) != 0;
+        bot.phaseEnd = seconds(0.2, 1.0);
+        const float delta = std::uniform_real_distribution<float>(5.0f, 40.0f)(bot.rng);
+        bot.targetAngle = std::min(std::max(me->angle + ((bot.rng() & 1) ? delta : -delta), 10.0f), 170.0f);
+    }
+
+    switch (bot.phase) {
+        case Bot::WALKING:
+            if (now < bot.phaseEnd) {
+                bot.client.SendInput(bot.walkRight ? INGAME_CMD_MOVE_RIGHT : INGAME_CMD_MOVE_LEFT);
+                break;
+            }
+            bot.client.SendInput(INGAME_CMD_STOP);
+            bot.phase = Bot::AIMING;
+            break;
+
+        case Bot::AIMING: {
+            bot.client.SendInput(INGAME_CMD_STOP);
+            const float angle = hasPending ? pendingAngle : me->angle;
+            if (std::fabs(bot.targetAngle - angle) < kAngleStep) {
+                bot.phase = Bot::CHARGING;
+                bot.phaseEnd = seconds(0.3, 1.2);
+                break;
+            }
+            const float direction = (bot.targetAngle > angle) ? 1.0f : -1.0f;
+            // Queued before sending so the answer can never beat its probe.
+            {
+                std::lock_guard<std::mutex> lock(bot.stateMutex);
+                bot.probes.push_back({Clock::now(), angle + direction * kAngleStep, direction});
+            }
+            bot.client.SendInput(INGAME_CMD_ADJUST_ANGLE, direction * kAngleStep);
+        } break;
+
+        case Bot::CHARGING:
+            bot.client.SendInput(INGAME_CMD_STOP);
+            if (now < bot.phaseEnd) {
+                bot.client.SendInput(INGAME_CMD_ADJUST_POWER, (float)(60.0 * kFrameSeconds));
+                break;
+            }
+            bot.client.SendInput(INGAME_CMD_FIRE);
+            bot.phase = Bot::FIRED;
+            break;
+
+        default:
+            bot.client.SendInput(INGAME_CMD_STOP);
+            break;
+    }
+}
+
+double Percentile(std::vector<double>& v, double q) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t i = std::min(v.size() - 1, (size_t)(q * (double)(v.size() - 1) + 0.5));
+    return v[i];
+}
+
+bool ParseArgs(int argc, char** argv, LoadConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--matches") == 0 && hasValue) {
+            config.matches = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--host") == 0 && hasValue) {
+            config.host = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && hasValue) {
+            config.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--duration") == 0 && hasValue) {
+            config.duration = std::max(1.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            config.warmup = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--map") == 0 && hasValue) {
+            config.map = argv[++i];
+        } else if (std::strcmp(argv[i], "--spawn") == 0 && hasValue) {
+            config.spawn = argv[++i];
+        } else if (std::strcmp(argv[i], "--server-pid") == 0 && hasValue) {
+            config.serverPids.push_back(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            config.outPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--matches N] [--host H] [--port P] [--duration S] [--warmup S] [--map NAME]"
+                         " [--spawn SERVER_BIN] [--server-pid PID]... [--out FILE]" << std::endl;
+            return false;
+        }
+    }
+    if (config.port <= 0) {
+        std::cerr << "ingame_load: invalid port" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void HandleSigInt(int) {
+    g_stop = true;
+}
+}
+
+int main(int argc, char** argv) {
+    LoadConfig config;
+    if (!ParseArgs(argc, argv, config)) return 1;
+    std::signal(SIGINT, HandleSigInt);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Spawned servers run elsewhere, so file maps must be absolute.
+    std::string mapName = config.map;
+    std::error_code ec;
+    if (!mapName.empty() && std::filesystem::exists(mapName, ec)) {
+        mapName = std::filesystem::absolute(mapName, ec).string();
+    }
+
+    std::vector<ServerProcess> servers;
+    std::string scratch;
+    if (!config.spawn.empty()) {
+        const std::string binary = std::filesystem::absolute(config.spawn, ec).string();
+        char dirTemplate[] = "/tmp/ingame_load.XXXXXX";
+        if (!mkdtemp(dirTemplate)) {
+            std::cerr << "ingame_load: cannot create a scratch directory" << std::endl;
+            return 1;
+        }
+        scratch = dirTemplate;
+        for (int m = 0; m < config.matches; m++) {
+            const std::string dir = scratch + "/" + std::to_string(config.port + m);
+            std::filesystem::create_directories(dir, ec);
+            ServerProcess server;
+            server.pid = SpawnServer(binary, config.port + m, dir);
+            server.spawned = true;
+            if (server.pid < 0) {
+                std::cerr << "ingame_load: fork failed" << std::endl;
+                return 1;
+            }
+            servers.push_back(server);
+        }
+    }
+    for (int pid : config.serverPids) {
+        ServerProcess server;
+        server.pid = pid;
+        servers.push_back(server);
+    }
+
+    // Connect and join; spawned servers need a moment to start listening.
+    std::vector<std::unique_ptr<Bot>> bots;
+    bool failed = false;
+    for (int m = 0; m < config.matches && !failed; m++) {
+        for (int p = 0; p < INGAME_MAX_PLAYERS; p++) {
+            std::unique_ptr<Bot> bot(new Bot());
+            bot->match = m;
+            bot->rng.seed((uint32_t)(m * 7919 + p));
+
+            bool connected = false;
+            for (int attempt = 0; attempt < 50 && !connected && !g_stop; attempt++) {
+                std::cerr.setstate(std::ios::failbit);
+                connected = bot->client.Connect(config.host, config.port + m);
+                std::cerr.clear();
+                if (!connected) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+
+            ResIngameJoin joined{};
+            if (!connected || !bot->client.Join(0, mapName, joined)) {
+                std::cerr << "ingame_load: match " << m << " player " << p << " could not join "
+                          << config.host << ":" << config.port + m << " " << joined.message << std::endl;
+                failed = true;
+                break;
+            }
+            Bot* raw = bot.get();
+            bot->client.Start([raw](Packet& packet) { raw->OnPacket(packet); });
+            bots.push_back(std::move(bot));
+        }
+    }
+
+    auto shutdown = [&] {
+        for (auto& bot : bots) bot->client.Close();
+        for (auto& server : servers) {
+            if (server.spawned) StopServer(server.pid);
+        }
+    };
+    if (failed) {
+        shutdown();
+        return 1;
+    }
+    std::printf("%d matches, %zu clients joined; warming up %.1f s, measuring %.1f s\n",
+                config.matches, bots.size(), config.warmup, config.duration);
+    std::fflush(stdout);
+
+    const auto frame = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(kFrameSeconds));
+    const auto start = Clock::now();
+    const auto measureStart = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.warmup));
+    const auto measureEnd = measureStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.duration));
+
+    auto nextFrame = start;
+    while (!g_stop) {
+        const auto now = Clock::now();
+        if (now >= measureEnd) break;
+        if (!g_measuring && now >= measureStart) {
+            for (auto& bot : bots) {
+                bot->bytesInStart = bot->client.GetBytesReceived();
+                bot->bytesOutStart = bot->client.GetBytesSent();
+            }
+            for (auto& server : servers) server.cpuStart = ProcStat::CpuSeconds(server.pid);
+            g_measuring = true;
+        }
+
+        for (auto& bot : bots) Drive(*bot, now);
+
+        nextFrame += frame;
+        if (nextFrame < Clock::now()) nextFrame = Clock::now();
+        std::this_thread::sleep_until(nextFrame);
+    }
+
+    const double measured = std::max(1e-3, std::chrono::duration<double>(Clock::now() - measureStart).count());
+    for (auto& server : servers) server.cpuEnd = ProcStat::CpuSeconds(server.pid);
+    g_measuring = false;
+
+    uint64_t bytesIn = 0, bytesOut = 0;
+    for (auto& bot : bots) {
+        bytesIn += bot->client.GetBytesReceived() - bot->bytesInStart;
+        bytesOut += bot->client.GetBytesSent() - bot->bytesOutStart;
+    }
+    shutdown();
+
+    // Aggregate.
+    std::vector<double> intervals, latency, tickRates;
+    double jitter = 0.0;
+    int finished = 0;
+    for (size_t i = 0; i < bots.size(); i++) {
+        Bot& bot = *bots[i];
+        intervals.insert(intervals.end(), bot.intervalsMs.begin(), bot.intervalsMs.end());
+        latency.insert(latency.end(), bot.latencyMs.begin(), bot.latencyMs.end());
+        jitter += bot.jitterMs / (double)bots.size();
+        if (i % INGAME_MAX_PLAYERS == 0) {
+            const double span = std::chrono::duration<double>(bot.lastTickAt - bot.firstTickAt).count();
+            if (span > 0.0) tickRates.push_back((double)(bot.lastTick - bot.firstTick) / span);
+            if (bot.hasState && bot.state.roomState == 3u) finished++;
+        }
+    }
+
+    double cpuTotal = 0.0, cpuMax = 0.0;
+    int cpuCount = 0;
+    for (const auto& server : servers) {
+        if (server.cpuStart < 0.0 || server.cpuEnd < 0.0) continue;
+        const double share = (server.cpuEnd - server.cpuStart) / measured;
+        cpuTotal += share;
+        cpuMax = std::max(cpuMax, share);
+        cpuCount++;
+    }
+
+    const double tickMean = tickRates.empty() ? 0.0 : [&] {
+        double sum = 0.0;
+        for (double r : tickRates) sum += r;
+        return sum / (double)tickRates.size();
+    }();
+    const double tickMin = tickRates.empty() ? 0.0 : *std::min_element(tickRates.begin(), tickRates.end());
+    const size_t latencySamples = latency.size();
+    const size_t intervalSamples = intervals.size();
+
+    const double intervalP50 = Percentile(intervals, 0.50), intervalP99 = Percentile(intervals, 0.99);
+    const double intervalP999 = Percentile(intervals, 0.999), intervalMax = intervals.empty() ? 0.0 : intervals.back();
+    const double latencyP50 = Percentile(latency, 0.50), latencyP99 = Percentile(latency, 0.99);
+    const double latencyP999 = Percentile(latency, 0.999), latencyMax = latency.empty() ? 0.0 : latency.back();
+
+    std::printf("\nmeasured %.1f s, %d matches (%d finished), %zu clients\n", measured, config.matches, finished, bots.size());
+    std::printf("input->state latency ms   p50 %7.2f  p99 %7.2f  p99.9 %7.2f  max %7.2f  (%zu samples)\n",
+                latencyP50, latencyP99, latencyP999, latencyMax, latencySamples);
+    // Seq-echo round trips, warm-up included (the clients' histograms cannot be reset).
+    LatencyHistogram ack, serverDelay;
+    for (const auto& bot : bots) {
+        ack.merge(bot->client.GetInputAckLatency());
+        serverDelay.merge(bot->client.GetServerInputDelay());
+    }
+    std::printf("input->ack rtt ms         p50 %7.2f  p99 %7.2f  p99.9 %7.2f  max %7.2f  (%llu samples, server p50 %.2f)\n",
+                ack.percentile(0.50) / 1e6, ack.percentile(0.99) / 1e6, ack.percentile(0.999) / 1e6, ack.max() / 1e6,
+                (unsigned long long)ack.count(), serverDelay.percentile(0.50) / 1e6);
+    double srttMs = 0.0, pingJitterMs = 0.0;
+    for (const auto& bot : bots) {
+        srttMs += bot->client.GetRtt().srttUs() / 1e3 / (double)bots.size();
+        pingJitterMs += bot->client.GetRtt().jitterUs() / 1e3 / (double)bots.size();
+    }
+    std::printf("ping rtt ms               srtt %6.2f  jitter %6.2f  (client mean)\n", srttMs, pingJitterMs);
+    std::printf("snapshot interval ms      p50 %7.2f  p99 %7.2f  p99.9 %7.2f  max %7.2f  jitter %.2f\n",
+                intervalP50, intervalP99, intervalP999, intervalMax, jitter);
+    std::printf("server tick rate Hz       mean %6.2f  min %6.2f\n", tickMean, tickMin);
+    std::printf("bandwidth                 down %.1f kB/s per client (%.2f MB/s total), up %.1f kB/s per client\n",
+                bytesIn / measured / 1024.0 / std::max<size_t>(1, bots.size()), bytesIn / measured / (1024.0 * 1024.0),
+                bytesOut / measured / 1024.0 / std::max<size_t>(1, bots.size()));
+    if (cpuCount > 0) {
+        std::printf("server cpu                %.1f%% per process avg, %.1f%% max, %.2f cores total\n",
+                    100.0 * cpuTotal / cpuCount, 100.0 * cpuMax, cpuTotal);
+    }
+    if (!scratch.empty()) std::printf("server recordings in %s\n", scratch.c_str());
+
+    if (!config.outPath.empty()) {
+        std::ofstream out(config.outPath);
+        char json[2048];
+        std::snprintf(json, sizeof(json),
+                      "{\n  \"matches\": %d,\n  \"clients\": %zu,\n  \"measured_s\": %.3f,\n  \"finished\": %d,\n"
+                      "  \"latency_ms\": {\"p50\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f, \"samples\": %zu},\n"
+                      "  \"snapshot_interval_ms\": {\"p50\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f, \"samples\": %zu},\n"
+                      "  \"jitter_ms\": %.3f,\n  \"tick_rate_hz\": {\"mean\": %.3f, \"min\": %.3f},\n"
+                      "  \"bytes_per_s\": {\"down\": %.1f, \"up\": %.1f},\n"
+                      "  \"server_cpu\": {\"processes\": %d, \"total_cores\": %.4f, \"max_cores\": %.4f}\n}\n",
+                      config.matches, bots.size(), measured, finished,
+                      latencyP50, latencyP99, latencyP999, latencyMax, latencySamples,
+                      intervalP50, intervalP99, intervalP999, intervalMax, intervalSamples,
+                      jitter, tickMean, tickMin, bytesIn / measured, bytesOut / measured,
+                      cpuCount, cpuTotal, cpuMax);
+        if (!out || !(out << json)) {
+            std::cerr << "ingame_load: failed to write " << config.outPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,18 +1,36 @@
 #include "core/Game.hpp"
 #include "scenes/SceneGameNet.hpp"
+#include "../common/utils/Trace.hpp"
 
 #include <cstdlib>
+#include <cstring>
 #include <string>
 
 const int FPS = 60;
 const int DELAY_TIME = 1000.0f / FPS;
 
 int main(int argc, char* argv[]) {
+    // Usage: net_game_client [ip] [port] [--trace FILE]
+    //   --trace records Chrome trace spans and writes them to FILE on exit.
     std::string ip = "127.0.0.1";
     int port = 9090;
+    const char* tracePath = nullptr;
+
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (positional++ == 0) {
+            ip = argv[i];
+        } else {
+            port = std::atoi(argv[i]);
+        }
+    }
 
-    if (argc >= 2) ip = argv[1];
-    if (argc >= 3) port = std::atoi(argv[2]);
+    if (tracePath) {
+        Trace::start(tracePath, "net_game_client");
+        Trace::setThreadName("main");
+    }
 
     if (!Game::getInstance()->init("Gummy Network Client", 1280, 720)) {
         return -1;
@@ -36,5 +54,6 @@ int main(int argc, char* argv[]) {
     }
 
     Game::getInstance()->clean();
+    Trace::stop();
     return 0;
 }
@@ -0,0 +1,216 @@
+#include "IngameClient.hpp"
+#include "../../common/utils/Trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+int64_t SteadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+int64_t IngameClient::NowUs() {
+    return SteadyNanos() / 1000;
+}
+
+IngameClient::IngameClient()
+    : m_socket(nullptr),
+      m_running(false),
+      m_matchId(0),
+      m_playerId(UINT32_MAX),
+      m_seq(0),
+      m_lastAckedSeq(0),
+      m_pingId(0),
+      m_lastPingUs(0),
+      m_bytesReceived(0),
+      m_bytesSent(0),
+      m_packetsReceived(0) {}
+
+IngameClient::~IngameClient() {
+    Close();
+}
+
+bool IngameClient::Connect(const std::string& ip, int port) {
+    Close();
+    try {
+        m_socket = new TCPSocket();
+        m_socket->Connect(ip, port);
+        // Inputs are a few bytes each, several per frame; don't let them queue behind ACKs.
+        m_socket->SetNoDelay(true);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "IngameClient: connection to " << ip << ":" << port << " failed: " << e.what() << std::endl;
+        delete m_socket;
+        m_socket = nullptr;
+        return false;
+    }
+}
+
+bool IngameClient::Join(uint32_t matchId, const std::string& mapName, ResIngameJoin& out) {
+    std::memset(&out, 0, sizeof(out));
+    if (!IsConnected()) return false;
+
+    ReqIngameJoin join{};
+    join.matchId = matchId;
+    join.userId = 0;
+    std::snprintf(join.mapName, sizeof(join.mapName), "%s", mapName.c_str());
+    if (!Send(PacketType::REQ_INGAME_JOIN, join)) {
+        std::cerr << "IngameClient: failed to send join" << std::endl;
+        return false;
+    }
+
+    // Broadcasts to the new connection can arrive ahead of the join response. Terrain
+    // diffs among them are kept for the handler: the snapshot a late joiner gets may be
+    // older than they are.
+    m_earlyPackets.clear();
+    Packet resp;
+    while (true) {
+        if (!PacketUtils::ReceivePacket(m_socket, resp)) {
+            std::cerr << "IngameClient: join failed (no response)" << std::endl;
+            return false;
+        }
+        m_bytesReceived += sizeof(Header) + resp.payload.size();
+        m_packetsReceived++;
+        if (resp.header.type == PacketType::RES_INGAME_JOIN) break;
+        if (resp.header.type == PacketType::RES_INGAME_TERRAIN_DIFF) {
+            m_earlyPackets.push_back(std::move(resp));
+        }
+    }
+
+    if (resp.payload.size() < sizeof(ResIngameJoin)) return false;
+    out = resp.GetPayload<ResIngameJoin>();
+    out.message[sizeof(out.message) - 1] = '\0';
+    out.mapName[sizeof(out.mapName) - 1] = '\0';
+    if (!out.isSuccess) return false;
+
+    m_matchId = out.matchId;
+    m_playerId = out.playerId;
+    return true;
+}
+
+void IngameClient::Start(PacketHandler handler) {
+    if (m_running || !IsConnected()) return;
+    m_handler = std::move(handler);
+    m_running = true;
+    m_receiverThread = std::thread(&IngameClient::ReceiverLoop, this);
+}
+
+void IngameClient::Close() {
+    m_running = false;
+
+    if (m_socket) {
+        m_socket->Close();
+    }
+
+    if (m_receiverThread.joinable()) {
+        m_receiverThread.join();
+    }
+
+    if (m_socket) {
+        delete m_socket;
+        m_socket = nullptr;
+    }
+    m_playerId = UINT32_MAX;
+}
+
+bool IngameClient::SendInput(uint32_t command, float value) {
+    if (m_playerId == UINT32_MAX) return false;
+
+    ReqIngameInput in{};
+    in.matchId = m_matchId;
+    in.playerId = m_playerId;
+    in.seq = ++m_seq;
+    in.command = command;
+    in.value = value;
+
+    SentInput& slot = m_sentInputs[in.seq % kInputWindow];
+    slot.sentNs.store(SteadyNanos(), std::memory_order_relaxed);
+    slot.seq.store(in.seq, std::memory_order_release);
+    return Send(PacketType::REQ_INGAME_INPUT, in);
+}
+
+// Receiver thread. Every input the snapshot newly covers gets a round trip sample; the
+// server-side delay is only known for the newest one.
+void IngameClient::TrackInputAck(const ResIngameState& state) {
+    const NetPlayerState* me = nullptr;
+    for (uint8_t i = 0; i < state.playerCount && i < INGAME_MAX_PLAYERS; i++) {
+        if (state.players[i].id == m_playerId) me = &state.players[i];
+    }
+    if (!me || me->lastInputSeq <= m_lastAckedSeq) return;
+
+    const int64_t now = SteadyNanos();
+    uint32_t seq = m_lastAckedSeq + 1;
+    if (me->lastInputSeq - seq >= kInputWindow) seq = me->lastInputSeq - kInputWindow + 1;
+    for (; seq <= me->lastInputSeq; seq++) {
+        const SentInput& slot = m_sentInputs[seq % kInputWindow];
+        // A slot already reused (or never written, after a seat takeover) has another seq.
+        if (slot.seq.load(std::memory_order_acquire) != seq) continue;
+        m_inputAckLatency.record((uint64_t)std::max<int64_t>(0, now - slot.sentNs.load(std::memory_order_relaxed)));
+    }
+    if (me->inputAppliedUs >= me->inputReceivedUs) {
+        m_serverInputDelay.record((uint64_t)(me->inputAppliedUs - me->inputReceivedUs) * 1000);
+    }
+    m_lastAckedSeq = me->lastInputSeq;
+}
+
+// Receiver thread: answers the server's pings, takes in pongs and sends the next ping
+// once kPingIntervalUs has passed. Snapshots arrive every tick, so that is often enough.
+void IngameClient::HandlePing(const Packet& p, int64_t receivedUs) {
+    if (p.header.type == PacketType::REQ_INGAME_PING && p.payload.size() >= sizeof(ReqIngamePing)) {
+        const ReqIngamePing ping = p.GetPayload<ReqIngamePing>();
+        ResIngamePong pong{};
+        pong.id = ping.id;
+        pong.sentUs = ping.sentUs;
+        pong.replyUs = NowUs();
+        Send(PacketType::RES_INGAME_PONG, pong);
+    } else if (p.header.type == PacketType::RES_INGAME_PONG && p.payload.size() >= sizeof(ResIngamePong)) {
+        const ResIngamePong pong = p.GetPayload<ResIngamePong>();
+        m_rtt.addSample(pong.sentUs, receivedUs, pong.replyUs);
+    }
+
+    if (receivedUs - m_lastPingUs >= kPingIntervalUs) {
+        ReqIngamePing ping{};
+        ping.id = ++m_pingId;
+        ping.sentUs = NowUs();
+        m_lastPingUs = ping.sentUs;
+        Send(PacketType::REQ_INGAME_PING, ping);
+    }
+}
+
+bool IngameClient::Send(const Packet& packet) {
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    if (!IsConnected()) return false;
+    if (!PacketUtils::SendPacket(m_socket, packet)) return false;
+    m_bytesSent += sizeof(Header) + packet.payload.size();
+    return true;
+}
+
+void IngameClient::ReceiverLoop() {
+    Trace::setThreadName("receiver");
+    for (auto& p : m_earlyPackets) {
+        if (m_handler) m_handler(p);
+    }
+    m_earlyPackets.clear();
+
+    while (m_running && m_socket && m_socket->IsValid()) {
+        Packet p;
+        if (!PacketUtils::ReceivePacket(m_socket, p)) {
+            break;
+        }
+        m_bytesReceived += sizeof(Header) + p.payload.size();
+        m_packetsReceived++;
+        const int64_t receivedUs = NowUs();
+        if (p.header.type == PacketType::RES_INGAME_STATE && p.payload.size() >= sizeof(ResIngameState)) {
+            TrackInputAck(p.GetPayload<ResIngameState>());
+        }
+        HandlePing(p, receivedUs);
+        if (m_handler) m_handler(p);
+    }
+
+    m_running = false;
+}
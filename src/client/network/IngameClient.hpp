@@ -0,0 +1,116 @@
+#ifndef INGAME_CLIENT_HPP
+#define INGAME_CLIENT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../common/network/TCPSocket.hpp"
+#include "../../common/network/Packet.hpp"
+#include "../../common/network/PacketType.hpp"
+#include "../../common/network/PacketStructs.hpp"
+#include "../../common/network/PacketUtils.hpp"
+#include "../../common/utils/LatencyHistogram.hpp"
+#include "../../common/utils/RttEstimator.hpp"
+
+// Connection to the ingame server without any rendering: join, a receiver thread that
+// hands every packet to a callback, and input sending. SceneGameNet draws on top of it;
+// headless tools (the load generator) use it directly.
+class IngameClient {
+public:
+    // Runs on the receiver thread for every packet after the join.
+    using PacketHandler = std::function<void(Packet& packet)>;
+
+    IngameClient();
+    ~IngameClient();
+
+    bool Connect(const std::string& ip, int port);
+
+    // Sends REQ_INGAME_JOIN and waits for the answer. Terrain diffs that arrive ahead of
+    // it go to the handler once Start() runs; other broadcasts are dropped. Fills `out`
+    // (including the rejection message) either way.
+    bool Join(uint32_t matchId, const std::string& mapName, ResIngameJoin& out);
+
+    // Starts the receiver thread. Call once, after Join().
+    void Start(PacketHandler handler);
+
+    // Closes the connection and waits for the receiver thread.
+    void Close();
+
+    // Queues one command for this player's next tick (seq is assigned here).
+    bool SendInput(uint32_t command, float value = 0.0f);
+    bool Send(const Packet& packet);
+
+    template <typename T>
+    bool Send(PacketType type, const T& payload) {
+        Packet packet(type);
+        packet.SetPayload(payload);
+        return Send(packet);
+    }
+
+    bool IsConnected() const { return m_socket && m_socket->IsValid(); }
+    uint32_t GetMatchId() const { return m_matchId; }
+    uint32_t GetPlayerId() const { return m_playerId; }
+    uint32_t GetLastSeq() const { return m_seq; }
+
+    // Totals including packet headers; safe to read from any thread.
+    uint64_t GetBytesReceived() const { return m_bytesReceived; }
+    uint64_t GetBytesSent() const { return m_bytesSent; }
+    uint64_t GetPacketsReceived() const { return m_packetsReceived; }
+
+    // Input -> ack round trips: from SendInput to the first snapshot whose lastInputSeq
+    // covers the input. The server delay is the part spent between its arrival and the
+    // tick that applied it. Written by the receiver thread, readable from any thread.
+    const LatencyHistogram& GetInputAckLatency() const { return m_inputAckLatency; }
+    const LatencyHistogram& GetServerInputDelay() const { return m_serverInputDelay; }
+
+    // Ping RTT, jitter and server clock offset. The receiver thread pings every
+    // kPingInterval while packets arrive and answers the server's pings; readable from any
+    // thread.
+    const RttEstimator& GetRtt() const { return m_rtt; }
+    // Steady-clock microseconds, the clock ping timestamps use on both ends.
+    static int64_t NowUs();
+
+private:
+    void ReceiverLoop();
+    void TrackInputAck(const ResIngameState& state);
+    void HandlePing(const Packet& p, int64_t receivedUs);
+
+    TCPSocket* m_socket;
+    std::atomic<bool> m_running;
+    std::thread m_receiverThread;
+    PacketHandler m_handler;
+    std::vector<Packet> m_earlyPackets;   // received during Join(), handed over by ReceiverLoop
+    std::mutex m_sendMutex;
+
+    uint32_t m_matchId;
+    uint32_t m_playerId;
+    uint32_t m_seq;
+
+    // Send times of the last kInputWindow inputs, by seq. Written by the sending thread,
+    // read by the receiver thread.
+    static constexpr uint32_t kInputWindow = 256;
+    struct SentInput {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<int64_t> sentNs{0};
+    };
+    SentInput m_sentInputs[kInputWindow];
+    uint32_t m_lastAckedSeq;   // receiver thread only
+    LatencyHistogram m_inputAckLatency;
+    LatencyHistogram m_serverInputDelay;
+
+    static constexpr int64_t kPingIntervalUs = 500000;
+    RttEstimator m_rtt;
+    uint32_t m_pingId;        // receiver thread only
+    int64_t m_lastPingUs;
+
+    std::atomic<uint64_t> m_bytesReceived;
+    std::atomic<uint64_t> m_bytesSent;
+    std::atomic<uint64_t> m_packetsReceived;
+};
+
+#endif // INGAME_CLIENT_HPP
@@ -0,0 +1,122 @@
+#include "MovementPredictor.hpp"
+#include "../../ingame_server/logic/PhysicsEngine.hpp"
+
+#include <cmath>
+
+namespace {
+// GameServer's kTickSeconds: the server steps once per tick, we once per frame.
+constexpr float kTickSeconds = 1.0f / 60.0f;
+// Share of the correction offset left after each frame.
+constexpr float kErrorDecay = 0.85f;
+// Corrections larger than this (a respawn, a knockback we did not predict) snap.
+constexpr float kMaxSmoothedError = 48.0f;
+}
+
+MovementPredictor::MovementPredictor()
+    : m_player(0, "", 0.0f, 0.0f, false),
+      m_hasState(false),
+      m_ackedSeq(0),
+      m_gravity(PhysicsEngine().getGravity()),
+      m_errorX(0.0f),
+      m_errorY(0.0f),
+      m_lastCorrection(0.0f) {
+    m_frames.emplace_back();
+}
+
+void MovementPredictor::Reset() {
+    m_hasState = false;
+    m_ackedSeq = 0;
+    m_frames.clear();
+    m_frames.emplace_back();
+    m_errorX = 0.0f;
+    m_errorY = 0.0f;
+    m_lastCorrection = 0.0f;
+}
+
+void MovementPredictor::AddInput(uint32_t seq, uint32_t command) {
+    Frame& frame = m_frames.back();
+    // Later commands override earlier ones, so a full frame keeps the newest.
+    const int slot = frame.count < kMaxFrameInputs ? frame.count++ : kMaxFrameInputs - 1;
+    frame.inputs[slot] = {seq, command};
+}
+
+void MovementPredictor::Step(const MapLoader& map) {
+    // Frames are kept even before the first Reconcile: they are in flight and get
+    // replayed on top of the first acknowledged state.
+    if (m_hasState) ApplyFrame(m_frames.back(), m_ackedSeq, map);
+    m_frames.emplace_back();
+    if (m_frames.size() > kMaxFrames) m_frames.pop_front();
+
+    m_errorX *= kErrorDecay;
+    m_errorY *= kErrorDecay;
+}
+
+void MovementPredictor::Reconcile(const NetPlayerState& acked, const MapLoader& map) {
+    const Position before = GetDrawPosition();
+
+    m_player.setPosition({acked.x, acked.y, acked.orient != 0});
+    m_player.setVelocity({acked.vx, acked.vy});
+    if (acked.isAsleep) m_player.sleep();
+    m_ackedSeq = acked.lastInputSeq;
+
+    // The current frame (back) has not been stepped yet and always stays.
+    while (m_frames.size() > 1) {
+        const Frame& front = m_frames.front();
+        if (front.count > 0 && front.inputs[front.count - 1].seq > m_ackedSeq) break;
+        m_frames.pop_front();
+    }
+    for (size_t i = 0; i + 1 < m_frames.size(); i++) {
+        ApplyFrame(m_frames[i], m_ackedSeq, map);
+    }
+
+    if (m_hasState) {
+        const Position after = m_player.getPosition();
+        const float dx = before.x - after.x;
+        const float dy = before.y - after.y;
+        m_lastCorrection = std::sqrt(dx * dx + dy * dy);
+        if (m_lastCorrection > kMaxSmoothedError) {
+            m_errorX = 0.0f;
+            m_errorY = 0.0f;
+        } else {
+            m_errorX = dx;
+            m_errorY = dy;
+        }
+    }
+    m_hasState = true;
+}
+
+Position MovementPredictor::GetDrawPosition() const {
+    Position pos = m_player.getPosition();
+    pos.x += m_errorX;
+    pos.y += m_errorY;
+    return pos;
+}
+
+// Inputs the server has already applied (seq <= afterSeq) are skipped.
+void MovementPredictor::ApplyFrame(const Frame& frame, uint32_t afterSeq, const MapLoader& map) {
+    // As GameRoom::handleInput.
+    for (int i = 0; i < frame.count; i++) {
+        if (frame.inputs[i].seq <= afterSeq) continue;
+        switch (frame.inputs[i].command) {
+            case INGAME_CMD_MOVE_LEFT:
+                m_player.moveLeft();
+                m_player.setOrient(0);
+                break;
+            case INGAME_CMD_MOVE_RIGHT:
+                m_player.moveRight();
+                m_player.setOrient(1);
+                break;
+            case INGAME_CMD_STOP:
+                m_player.stopMoving();
+                break;
+            default:
+                break;
+        }
+    }
+
+    // As PhysicsEngine::update, including waking up when the ground went away.
+    if (m_player.isAsleep() && !PhysicsEngine::isSupported(&m_player, map)) m_player.wake();
+    if (!m_player.isAsleep()) {
+        PhysicsEngine::stepPlayer(&m_player, PhysicsEngine::toSimDt(kTickSeconds), m_gravity, map);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef MOVEMENT_PREDICTOR_HPP
+#define MOVEMENT_PREDICTOR_HPP
+
+#include <cstdint>
+#include <deque>
+
+#include "../../common/network/PacketStructs.hpp"
+#include "../../ingame_server/logic/MapLoader.hpp"
+#include "../../ingame_server/logic/Player.hpp"
+
+// Client-side prediction of the local player's movement. Every frame's movement inputs
+// are applied at once and followed by one PhysicsEngine::stepPlayer tick, as the server
+// does with the inputs that reach it between two ticks. When a snapshot acknowledges
+// inputs (NetPlayerState::lastInputSeq), the prediction restarts from that authoritative
+// state and replays the frames the server has not seen yet.
+//
+// A reconciliation that moves the player leaves the difference as a display offset that
+// fades over a few frames, so small corrections do not show as jumps.
+class MovementPredictor {
+public:
+    // Frames kept for replay; a round trip longer than this and prediction gives up on the
+    // oldest inputs.
+    static constexpr size_t kMaxFrames = 120;
+    static constexpr int kMaxFrameInputs = 8;
+
+    MovementPredictor();
+
+    // Drops the prediction; the next Reconcile starts over.
+    void Reset();
+
+    // A movement command (MOVE_LEFT / MOVE_RIGHT / STOP) sent this frame with its seq.
+    void AddInput(uint32_t seq, uint32_t command);
+
+    // Ends the frame: applies its inputs and steps once. No-op before the first Reconcile.
+    void Step(const MapLoader& map);
+
+    // Rewinds to the state the server reported after applying `acked.lastInputSeq` and
+    // replays every later frame.
+    void Reconcile(const NetPlayerState& acked, const MapLoader& map);
+
+    bool HasState() const { return m_hasState; }
+    uint32_t GetAckedSeq() const { return m_ackedSeq; }
+    // Where to draw the player: the prediction plus what is left of the correction offset.
+    Position GetDrawPosition() const;
+    // Distance the last reconciliation moved the prediction, in pixels.
+    float GetLastCorrection() const { return m_lastCorrection; }
+
+private:
+    struct Input {
+        uint32_t seq;
+        uint32_t command;
+    };
+    struct Frame {
+        Input inputs[kMaxFrameInputs];
+        int count = 0;
+    };
+
+    Player m_player;
+    bool m_hasState;
+    uint32_t m_ackedSeq;
+    float m_gravity;
+
+    std::deque<Frame> m_frames;   // sent, not yet acknowledged; back() is the current frame
+    float m_errorX;
+    float m_errorY;
+    float m_lastCorrection;
+
+    void ApplyFrame(const Frame& frame, uint32_t afterSeq, const MapLoader& map);
+};
+
+#endif // MOVEMENT_PREDICTOR_HPP
@@ -0,0 +1,120 @@
+#include "SnapshotBuffer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+// Further behind the newest snapshot than this and the server must have restarted.
+constexpr uint32_t kRestartTicks = 600;
+// How fast the mapping follows arrivals that got later for good (a slower route).
+constexpr int64_t kOffsetCreep = 1024;
+}
+
+SnapshotBuffer::SnapshotBuffer() {
+    Clear();
+}
+
+void SnapshotBuffer::Clear() {
+    m_head = 0;
+    m_count = 0;
+    m_offsetUs = 0;
+    m_latenessUs = 0;
+    m_gapUs = kTickUs;
+    m_gapSamples = 0;
+    m_networkJitterUs = 0;
+    m_delayUs = 0;
+    m_lastSampleUs = 0;
+    m_starved = 0;
+}
+
+void SnapshotBuffer::Push(const ResIngameState& state, int64_t arrivalUs) {
+    const int64_t offset = arrivalUs - TickUs(state);
+    if (m_count > 0) {
+        const ResIngameState& newest = Latest();
+        if (state.tick + kRestartTicks < newest.tick) {
+            Clear();
+        } else if (state.tick <= newest.tick) {
+            return;
+        }
+    }
+
+    if (m_count == 0) {
+        m_offsetUs = offset;
+    } else {
+        const int64_t gap = (int64_t)(state.tick - Latest().tick) * kTickUs;
+        m_gapUs = m_gapSamples++ == 0 ? gap : m_gapUs + (gap - m_gapUs) / 16;
+        // The earliest arrivals define the mapping; later ones only nudge it upward.
+        if (offset < m_offsetUs) {
+            m_offsetUs = offset;
+        } else {
+            m_offsetUs += (offset - m_offsetUs) / kOffsetCreep;
+        }
+        m_latenessUs += (std::llabs(offset - m_offsetUs) - m_latenessUs) / 16;
+    }
+
+    if (m_count == kCapacity) {
+        m_head = (m_head + 1) % kCapacity;
+        m_count--;
+    }
+    m_states[(m_head + m_count) % kCapacity] = state;
+    m_count++;
+}
+
+bool SnapshotBuffer::Sample(int64_t nowUs, ResIngameState& out) {
+    if (m_count == 0) return false;
+
+    const int64_t target = std::min(kMaxDelayUs, m_gapUs + std::max(3 * m_latenessUs, m_networkJitterUs));
+    if (m_lastSampleUs == 0) {
+        m_delayUs = target;
+    } else {
+        // Drawn time slows to 0.75x while the delay grows and speeds up to 1.1x while it
+        // shrinks: running dry is worse than drawing a little later.
+        const int64_t elapsed = std::max<int64_t>(0, nowUs - m_lastSampleUs);
+        m_delayUs += std::max(-elapsed / 10, std::min(elapsed / 4, target - m_delayUs));
+    }
+    m_lastSampleUs = nowUs;
+
+    const int64_t renderUs = nowUs - m_offsetUs - m_delayUs;
+
+    // Keep one snapshot at or before the drawn time; older ones are done with.
+    while (m_count > 1 && TickUs(At(1)) <= renderUs) {
+        m_head = (m_head + 1) % kCapacity;
+        m_count--;
+    }
+
+    const ResIngameState& a = At(0);
+    if (m_count == 1 || renderUs <= TickUs(a)) {
+        if (renderUs > TickUs(a)) m_starved++;
+        out = a;
+        return true;
+    }
+
+    const ResIngameState& b = At(1);
+    const float t = (float)(renderUs - TickUs(a)) / (float)(TickUs(b) - TickUs(a));
+    Interpolate(a, b, t, out);
+    return true;
+}
+
+void SnapshotBuffer::Interpolate(const ResIngameState& a, const ResIngameState& b, float t, ResIngameState& out) {
+    out = a;
+    auto lerp = [t](float from, float to) { return from + (to - from) * t; };
+
+    for (uint8_t i = 0; i < a.playerCount && i < b.playerCount && i < INGAME_MAX_PLAYERS; i++) {
+        const NetPlayerState& pa = a.players[i];
+        const NetPlayerState& pb = b.players[i];
+        if (pa.id != pb.id || !pa.isAlive || !pb.isAlive) continue;
+        out.players[i].x = lerp(pa.x, pb.x);
+        out.players[i].y = lerp(pa.y, pb.y);
+        out.players[i].angle = lerp(pa.angle, pb.angle);
+        out.players[i].power = lerp(pa.power, pb.power);
+    }
+
+    // Projectiles keep their index for the whole turn.
+    for (uint8_t i = 0; i < a.projectileCount && i < b.projectileCount && i < INGAME_MAX_PROJECTILES; i++) {
+        const NetProjectileState& pa = a.projectiles[i];
+        const NetProjectileState& pb = b.projectiles[i];
+        if (!pa.isActive || !pb.isActive) continue;
+        out.projectiles[i].x = lerp(pa.x, pb.x);
+        out.projectiles[i].y = lerp(pa.y, pb.y);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef SNAPSHOT_BUFFER_HPP
+#define SNAPSHOT_BUFFER_HPP
+
+#include <cstdint>
+
+#include "../../common/network/PacketStructs.hpp"
+
+// Recent RES_INGAME_STATE snapshots, sampled a little in the past so there is (almost)
+// always a snapshot on either side of the drawn time.
+//
+// Snapshot ticks are mapped to local time by the offset of the earliest-arriving ones:
+// a snapshot that came in later than that was delayed on the way. The render delay is
+// the usual gap between snapshots plus three times the mean lateness (or the ping jitter
+// if that is larger), and follows changes in it gradually so drawn time never runs
+// backwards. Positions are interpolated; everything else comes from the older snapshot.
+//
+// Not thread-safe; SceneGameNet uses it from the main thread only.
+class SnapshotBuffer {
+public:
+    // GameServer's kTickSeconds.
+    static constexpr int64_t kTickUs = 1000000 / 60;
+    static constexpr int kCapacity = 32;
+    static constexpr int64_t kMaxDelayUs = 250000;
+
+    SnapshotBuffer();
+
+    // Snapshots not newer than the newest one are dropped; a tick far behind it means the
+    // server restarted and starts the buffer over.
+    void Push(const ResIngameState& state, int64_t arrivalUs);
+    void Clear();
+
+    // Ping jitter (RttEstimator::jitterUs) to size the delay with before arrivals alone
+    // have shown much.
+    void SetNetworkJitterUs(int64_t jitterUs) { m_networkJitterUs = jitterUs; }
+
+    // State to draw at local time nowUs; false until the first snapshot arrived.
+    bool Sample(int64_t nowUs, ResIngameState& out);
+
+    bool HasState() const { return m_count > 0; }
+    const ResIngameState& Latest() const { return At(m_count - 1); }
+    int64_t GetDelayUs() const { return m_delayUs; }
+    int64_t GetLatenessUs() const { return m_latenessUs; }
+    // Times Sample() ran past the newest snapshot and had to hold it.
+    uint64_t GetStarvedSamples() const { return m_starved; }
+
+private:
+    ResIngameState m_states[kCapacity];
+    int m_head;
+    int m_count;
+
+    int64_t m_offsetUs;     // local time of tick 0, from the least delayed arrivals
+    int64_t m_latenessUs;   // mean arrival lateness against m_offsetUs
+    int64_t m_gapUs;        // mean spacing of consecutive snapshots
+    uint32_t m_gapSamples;
+    int64_t m_networkJitterUs;
+    int64_t m_delayUs;
+    int64_t m_lastSampleUs;
+    uint64_t m_starved;
+
+    const ResIngameState& At(int i) const { return m_states[(m_head + i) % kCapacity]; }
+    static int64_t TickUs(const ResIngameState& s) { return (int64_t)s.tick * kTickUs; }
+    static void Interpolate(const ResIngameState& a, const ResIngameState& b, float t, ResIngameState& out);
+};
+
+#endif // SNAPSHOT_BUFFER_HPP
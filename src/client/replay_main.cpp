@@ -0,0 +1,39 @@
+#include "core/Game.hpp"
+#include "scenes/SceneReplay.hpp"
+
+#include <iostream>
+#include <string>
+
+const int FPS = 60;
+const int DELAY_TIME = 1000.0f / FPS;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <replay.grp>" << std::endl;
+        return -1;
+    }
+
+    if (!Game::getInstance()->init("Gummy Replay Viewer", 1280, 720)) {
+        return -1;
+    }
+
+    Game::getInstance()->getStateMachine()->pushState(new SceneReplay(argv[1]));
+
+    Uint32 frameStart, frameTime;
+
+    while (Game::getInstance()->running()) {
+        frameStart = SDL_GetTicks();
+
+        Game::getInstance()->handleEvents();
+        Game::getInstance()->update();
+        Game::getInstance()->render();
+
+        frameTime = SDL_GetTicks() - frameStart;
+        if (frameTime < DELAY_TIME) {
+            SDL_Delay((int)(DELAY_TIME - frameTime));
+        }
+    }
+
+    Game::getInstance()->clean();
+    return 0;
+}
@@ -41,7 +41,7 @@ bool SceneGame::onEnter() {
     std::cout << "Background loaded." << std::endl;
     m_mapLoader = new MapLoader();
     std::cout << "Loading map: " << m_mapToLoad << std::endl;
-    if (!m_mapLoader->loadMap(m_mapToLoad)) {
+    if (!MapGenerator::Load(*m_mapLoader, m_mapToLoad, (uint32_t)std::time(nullptr))) {
         std::cout << "Failed to load map!" << std::endl;
         return false;
     }
@@ -173,7 +173,7 @@ void SceneGame::update() {
 
     if (m_gameRoom) {
         m_gameRoom->update(dt);
-        if (m_gameRoom->consumeTerrainModified()) {
+        if (m_mapLoader->hasDirtyRects()) {
             m_mapModified = true;
         }
     }
@@ -310,50 +310,34 @@ void SceneGame::createMapTexture() {
 
     SDL_SetTextureBlendMode(m_mapTexture, SDL_BLENDMODE_BLEND); 
 
-    // 2. Lock and Write Pixels
-    void* pixels = nullptr;
-    int pitch = 0;
-    if (SDL_LockTexture(m_mapTexture, NULL, &pixels, &pitch) != 0 || !pixels) {
-        std::cerr << "Failed to lock map texture: " << SDL_GetError() << std::endl;
-        return;
-    }
-
-    for (int y = 0; y < height; y++) {
-        auto* row = reinterpret_cast<Uint32*>(reinterpret_cast<Uint8*>(pixels) + y * pitch);
-        for (int x = 0; x < width; x++) {
-            row[x] = m_mapLoader->isSolid((float)x, (float)y)
-                ? 0x3C280DFF  // Solid (brown)
-                : 0x00000000; // Air (transparent)
-        }
-    }
-
-    SDL_UnlockTexture(m_mapTexture);
+    // 2. Write Pixels: the whole map is one dirty region
+    m_mapLoader->markDirty(0, 0, width, height);
+    updateMapTexture();
 }
 
 void SceneGame::updateMapTexture() {
     if (!m_mapTexture || !m_mapLoader) return;
-    
-    int width = m_mapLoader->getWidth();
-    int height = m_mapLoader->getHeight();
 
-    // Lock and update pixels
-    void* pixels = nullptr;
-    int pitch = 0;
-    if (SDL_LockTexture(m_mapTexture, NULL, &pixels, &pitch) != 0 || !pixels) {
-        std::cerr << "Failed to lock map texture: " << SDL_GetError() << std::endl;
-        return;
-    }
+    // Only the regions changed since the last refresh are re-uploaded.
+    m_dirtyRects.clear();
+    m_mapLoader->drainDirtyRects(m_dirtyRects);
+
+    for (const auto& r : m_dirtyRects) {
+        SDL_Rect rect = {r.x, r.y, r.w, r.h};
+        void* pixels = nullptr;
+        int pitch = 0;
+        if (SDL_LockTexture(m_mapTexture, &rect, &pixels, &pitch) != 0 || !pixels) {
+            std::cerr << "Failed to lock map texture: " << SDL_GetError() << std::endl;
+            return;
+        }
 
-    for (int y = 0; y < height; y++) {
-        auto* row = reinterpret_cast<Uint32*>(reinterpret_cast<Uint8*>(pixels) + y * pitch);
-        for (int x = 0; x < width; x++) {
-            row[x] = m_mapLoader->isSolid((float)x, (float)y)
-                ? 0x3C280DFF
-                : 0x00000000;
+        for (int y = 0; y < r.h; y++) {
+            auto* row = reinterpret_cast<Uint32*>(reinterpret_cast<Uint8*>(pixels) + y * pitch);
+            m_mapLoader->expandRow(r.y + y, r.x, r.w, 0x3C280DFF, 0x00000000, row);
         }
-    }
 
-    SDL_UnlockTexture(m_mapTexture);
+        SDL_UnlockTexture(m_mapTexture);
+    }
 }
 
 void SceneGame::renderHealthBar(Position playerPos, Player* player) {
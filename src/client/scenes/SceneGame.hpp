@@ -3,10 +3,12 @@
 #include "../core/Game.hpp"
 #include "../core/TextureManager.hpp"
 #include "../core/InputHandler.hpp"
+#include "../../ingame_server/logic/MapGenerator.hpp"
 #include "../../ingame_server/logic/MapLoader.hpp"
 #include "../../ingame_server/logic/Player.hpp"
 #include "../../ingame_server/logic/GameRoom.hpp"
 #include <string>
+#include <vector>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
@@ -35,6 +37,7 @@ private:
     GameRoom* m_gameRoom;
     MapLoader* m_mapLoader;
     SDL_Texture* m_mapTexture;
+    std::vector<TerrainRect> m_dirtyRects;
     Player* m_player;
     std::vector<Player*> m_players;
     TTF_Font* m_font;
@@ -1,18 +1,20 @@
 #include "SceneGameNet.hpp"
+#include "../../common/utils/Trace.hpp"
 
 #include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 
 SceneGameNet::SceneGameNet(std::string serverIp, int serverPort)
     : m_serverIp(std::move(serverIp)),
       m_serverPort(serverPort),
-      m_running(false),
-      m_socket(nullptr),
       m_matchId(1),
       m_playerId(UINT32_MAX),
-      m_seq(0),
-      m_hasState(false),
+      m_terrainVersion(0),
+      m_syncingTerrain(false),
+      m_terrainRepairPending(false),
+      m_lastHashCheckTick(0),
       m_bgTextureID(""),
       m_playerID(""),
       m_bulletID(""),
@@ -21,9 +23,7 @@ SceneGameNet::SceneGameNet(std::string serverIp, int serverPort)
             m_mapTexture(nullptr),
             m_mapModified(true),
             m_font(nullptr),
-      m_lastTick(0) {
-    std::memset(&m_lastState, 0, sizeof(m_lastState));
-}
+      m_lastTick(0) {}
 
 bool SceneGameNet::onEnter() {
     m_lastTick = SDL_GetTicks();
@@ -50,7 +50,9 @@ bool SceneGameNet::onEnter() {
         std::cout << "SceneGameNet: Warning: Failed to load font (assets/font.ttf)" << std::endl;
     }
 
-    // Local terrain (visual only). Server-side terrain deformation is not replicated yet.
+    // Local terrain, drawn and used by MovementPredictor for collision. Replaced by the
+    // server's terrain snapshot after joining and kept in sync by its RES_INGAME_TERRAIN_DIFF
+    // stream.
     m_mapLoader = new MapLoader();
     if (!m_mapLoader->loadMap(m_mapPath)) {
         std::cerr << "SceneGameNet: failed to load map (visual layer): " << m_mapPath << std::endl;
@@ -59,62 +61,39 @@ bool SceneGameNet::onEnter() {
         m_mapModified = false;
     }
 
-    try {
-        m_socket = new TCPSocket();
-        m_socket->Connect(m_serverIp, m_serverPort);
-        std::cout << "SceneGameNet connected to " << m_serverIp << ":" << m_serverPort << std::endl;
-
-        ReqIngameJoin join{};
-        join.matchId = m_matchId;
-        join.userId = 0;
-        join.mapName[0] = '\0';
-
-        if (!PacketUtils::SendPacket(m_socket, PacketType::REQ_INGAME_JOIN, join)) {
-            std::cerr << "SceneGameNet: failed to send join" << std::endl;
-            return false;
-        }
-
-        Packet resp;
-        if (!PacketUtils::ReceivePacket(m_socket, resp) || resp.header.type != PacketType::RES_INGAME_JOIN) {
-            std::cerr << "SceneGameNet: join failed (no response)" << std::endl;
-            return false;
-        }
-
-        ResIngameJoin joined = resp.GetPayload<ResIngameJoin>();
-        if (!joined.isSuccess) {
-            std::cerr << "SceneGameNet: join rejected: " << joined.message << std::endl;
-            return false;
-        }
-
-        m_matchId = joined.matchId;
-        m_playerId = joined.playerId;
-        std::cout << "SceneGameNet: joined match " << m_matchId << " as player " << m_playerId << std::endl;
-
-        m_running = true;
-        m_receiverThread = std::thread(&SceneGameNet::ReceiverLoop, this);
-        return true;
+    if (!m_client.Connect(m_serverIp, m_serverPort)) {
+        std::cerr << "SceneGameNet: failed to connect to " << m_serverIp << ":" << m_serverPort << std::endl;
+        return false;
+    }
+    std::cout << "SceneGameNet connected to " << m_serverIp << ":" << m_serverPort << std::endl;
 
-    } catch (const std::exception& e) {
-        std::cerr << "SceneGameNet: exception connecting: " << e.what() << std::endl;
+    ResIngameJoin joined{};
+    if (!m_client.Join(m_matchId, "", joined)) {
+        std::cerr << "SceneGameNet: join failed: " << joined.message << std::endl;
         return false;
     }
-}
 
-bool SceneGameNet::onExit() {
-    m_running = false;
+    m_matchId = joined.matchId;
+    m_playerId = joined.playerId;
+    std::cout << "SceneGameNet: joined match " << m_matchId << " as player " << m_playerId << std::endl;
 
-    if (m_socket) {
-        m_socket->Close();
+    // Untouched generated maps are rebuilt from the seed; anything else arrives as a
+    // terrain snapshot, and diffs wait for it.
+    int mapWidth = 0, mapHeight = 0;
+    if (MapGenerator::ParseName(joined.mapName, mapWidth, mapHeight)) {
+        MapGenerator::Generate(*m_mapLoader, joined.mapSeed, mapWidth, mapHeight);
+        createMapTexture();
+        m_mapModified = false;
+    } else {
+        m_syncingTerrain = true;
     }
 
-    if (m_receiverThread.joinable()) {
-        m_receiverThread.join();
-    }
+    m_client.Start([this](Packet& p) { HandlePacket(p); });
+    return true;
+}
 
-    if (m_socket) {
-        delete m_socket;
-        m_socket = nullptr;
-    }
+bool SceneGameNet::onExit() {
+    m_client.Close();
 
     if (m_mapTexture) {
         SDL_DestroyTexture(m_mapTexture);
@@ -158,80 +137,265 @@ void SceneGameNet::createMapTexture() {
     }
 
     SDL_SetTextureBlendMode(m_mapTexture, SDL_BLENDMODE_BLEND);
+    m_mapLoader->markDirty(0, 0, width, height);
+    updateMapTexture();
+}
 
-    void* pixels = nullptr;
-    int pitch = 0;
-    if (SDL_LockTexture(m_mapTexture, NULL, &pixels, &pitch) != 0 || !pixels) {
-        std::cerr << "SceneGameNet: failed to lock map texture: " << SDL_GetError() << std::endl;
-        return;
+void SceneGameNet::updateMapTexture() {
+    if (!m_mapTexture || !m_mapLoader) return;
+
+    // Only the regions changed since the last refresh are re-uploaded.
+    m_dirtyRects.clear();
+    m_mapLoader->drainDirtyRects(m_dirtyRects);
+
+    for (const auto& r : m_dirtyRects) {
+        SDL_Rect rect = {r.x, r.y, r.w, r.h};
+        void* pixels = nullptr;
+        int pitch = 0;
+        if (SDL_LockTexture(m_mapTexture, &rect, &pixels, &pitch) != 0 || !pixels) {
+            std::cerr << "SceneGameNet: failed to lock map texture: " << SDL_GetError() << std::endl;
+            return;
+        }
+
+        for (int y = 0; y < r.h; y++) {
+            auto* row = reinterpret_cast<Uint32*>(reinterpret_cast<Uint8*>(pixels) + y * pitch);
+            m_mapLoader->expandRow(r.y + y, r.x, r.w, 0x3C280DFF, 0x00000000, row);
+        }
+
+        SDL_UnlockTexture(m_mapTexture);
     }
+}
 
-    for (int y = 0; y < height; y++) {
-        auto* row = reinterpret_cast<Uint32*>(reinterpret_cast<Uint8*>(pixels) + y * pitch);
-        for (int x = 0; x < width; x++) {
-            row[x] = m_mapLoader->isSolid((float)x, (float)y) ? 0x3C280DFF : 0x00000000;
+// Applies terrain packets in arrival order. Diffs carry absolute cell contents for
+// the changed regions, so no local explosion replay is needed; while a snapshot is
+// still streaming, diffs are held back and applied on top of it. A diff that skips
+// versions means a snapshot of a touched generated map is on its way.
+void SceneGameNet::applyTerrainUpdates() {
+    std::vector<Packet> packets;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        packets.swap(m_pendingTerrainPackets);
+    }
+    if (!m_mapLoader) return;
+
+    for (auto& p : packets) {
+        if (p.header.type == PacketType::RES_INGAME_TERRAIN_SNAPSHOT) {
+            receiveTerrainSnapshotChunk(p);
+        } else if (p.header.type == PacketType::RES_INGAME_TERRAIN_HASHES) {
+            requestDivergentChunks(p);
+        } else if (p.header.type == PacketType::RES_INGAME_TERRAIN_CHUNKS) {
+            applyTerrainChunks(p);
+        } else {
+            ResIngameTerrainDiff header;
+            std::memcpy(&header, p.payload.data(), sizeof(header));
+            if (header.version > m_terrainVersion + 1) m_syncingTerrain = true;
+            if (m_syncingTerrain) {
+                m_deferredTerrainDiffs.push_back(std::move(p));
+            } else {
+                applyTerrainDiff(p);
+            }
         }
     }
+}
+
+void SceneGameNet::applyTerrainDiff(const Packet& p) {
+    ResIngameTerrainDiff header;
+    std::memcpy(&header, p.payload.data(), sizeof(header));
+    // Already covered by a newer snapshot.
+    if (header.version <= m_terrainVersion) return;
+    if (header.version != m_terrainVersion + 1) {
+        std::cerr << "SceneGameNet: terrain diff version " << header.version
+                  << " after " << m_terrainVersion << std::endl;
+    }
 
-    SDL_UnlockTexture(m_mapTexture);
+    const auto* begin = reinterpret_cast<const unsigned char*>(p.payload.data()) + sizeof(header);
+    const auto* end = reinterpret_cast<const unsigned char*>(p.payload.data()) + p.payload.size();
+    if (!TerrainDiff::Apply(*m_mapLoader, begin, end)) {
+        std::cerr << "SceneGameNet: malformed terrain diff " << header.version << std::endl;
+    }
+    m_terrainVersion = header.version;
+    m_mapModified = true;
 }
 
-void SceneGameNet::updateMapTexture() {
-    if (!m_mapTexture || !m_mapLoader) return;
+// Compares the periodic root hash at matching versions; a mismatch starts a repair
+// (chunk hashes -> divergent chunks) unless one is already in flight.
+void SceneGameNet::checkTerrainHash(const ResIngameState& state) {
+    if (!state.hasTerrainHash || m_syncingTerrain || !m_mapLoader) return;
+    if (state.terrainVersion != m_terrainVersion || state.tick == m_lastHashCheckTick) return;
+    m_lastHashCheckTick = state.tick;
 
-    const int width = m_mapLoader->getWidth();
-    const int height = m_mapLoader->getHeight();
-    if (width <= 0 || height <= 0) return;
+    if (m_mapLoader->getTerrainHash() == state.terrainHash) {
+        m_terrainRepairPending = false;
+        return;
+    }
+    if (m_terrainRepairPending || !m_client.IsConnected()) return;
+
+    std::cerr << "SceneGameNet: terrain desync at version " << m_terrainVersion << ", requesting chunk hashes" << std::endl;
+    ReqIngameTerrainHashes req{};
+    req.matchId = m_matchId;
+    if (m_client.Send(PacketType::REQ_INGAME_TERRAIN_HASHES, req)) {
+        m_terrainRepairPending = true;
+    }
+}
+
+void SceneGameNet::requestDivergentChunks(const Packet& p) {
+    ResIngameTerrainHashes header;
+    std::memcpy(&header, p.payload.data(), sizeof(header));
 
-    void* pixels = nullptr;
-    int pitch = 0;
-    if (SDL_LockTexture(m_mapTexture, NULL, &pixels, &pitch) != 0 || !pixels) {
-        std::cerr << "SceneGameNet: failed to lock map texture: " << SDL_GetError() << std::endl;
+    const auto& local = m_mapLoader->getChunkHashes();
+    const size_t count = (size_t)header.chunksX * header.chunksY;
+    // Stale reply or a different layout: retry on the next periodic hash.
+    if (header.version != m_terrainVersion || header.chunkSize != (uint32_t)MapLoader::kHashChunkSize ||
+        count != local.size() || p.payload.size() < sizeof(header) + count * sizeof(uint64_t)) {
+        m_terrainRepairPending = false;
         return;
     }
 
-    for (int y = 0; y < height; y++) {
-        auto* row = reinterpret_cast<Uint32*>(reinterpret_cast<Uint8*>(pixels) + y * pitch);
-        for (int x = 0; x < width; x++) {
-            row[x] = m_mapLoader->isSolid((float)x, (float)y) ? 0x3C280DFF : 0x00000000;
-        }
+    std::vector<uint32_t> divergent;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t remote;
+        std::memcpy(&remote, p.payload.data() + sizeof(header) + i * sizeof(uint64_t), sizeof(remote));
+        if (remote != local[i]) divergent.push_back((uint32_t)i);
+    }
+    if (divergent.empty()) {
+        m_terrainRepairPending = false;
+        return;
     }
 
-    SDL_UnlockTexture(m_mapTexture);
+    ReqIngameTerrainChunks req{};
+    req.matchId = m_matchId;
+    req.version = m_terrainVersion;
+    req.count = (uint32_t)divergent.size();
+    std::vector<char> indices(divergent.size() * sizeof(uint32_t));
+    std::memcpy(indices.data(), divergent.data(), indices.size());
+
+    Packet packet(PacketType::REQ_INGAME_TERRAIN_CHUNKS);
+    packet.SetPayload(req);
+    packet.AppendPayload(indices);
+    std::cerr << "SceneGameNet: requesting " << divergent.size() << " of " << count << " terrain chunks" << std::endl;
+    if (!m_client.Send(packet)) {
+        m_terrainRepairPending = false;
+    }
 }
 
-void SceneGameNet::ReceiverLoop() {
-    while (m_running && m_socket && m_socket->IsValid()) {
-        Packet p;
-        if (!PacketUtils::ReceivePacket(m_socket, p)) {
-            break;
-        }
-        if (p.header.type != PacketType::RES_INGAME_STATE) {
-            continue;
-        }
+void SceneGameNet::applyTerrainChunks(const Packet& p) {
+    ResIngameTerrainChunks header;
+    std::memcpy(&header, p.payload.data(), sizeof(header));
+    m_terrainRepairPending = false;
+    if (header.version != m_terrainVersion) return;
 
-        ResIngameState s = p.GetPayload<ResIngameState>();
-        {
-            std::lock_guard<std::mutex> lock(m_stateMutex);
-            m_lastState = s;
-            m_hasState = true;
+    const auto* begin = reinterpret_cast<const unsigned char*>(p.payload.data()) + sizeof(header);
+    const auto* end = reinterpret_cast<const unsigned char*>(p.payload.data()) + p.payload.size();
+    if (!TerrainDiff::Apply(*m_mapLoader, begin, end)) {
+        std::cerr << "SceneGameNet: malformed terrain chunks" << std::endl;
+    }
+    m_mapModified = true;
+}
+
+void SceneGameNet::receiveTerrainSnapshotChunk(const Packet& p) {
+    ResIngameTerrainSnapshot header;
+    std::memcpy(&header, p.payload.data(), sizeof(header));
+
+    if (header.offset == 0) {
+        m_terrainSnapshot.clear();
+        m_syncingTerrain = true;
+    }
+    if (!m_syncingTerrain || header.offset != m_terrainSnapshot.size()) {
+        std::cerr << "SceneGameNet: unexpected terrain snapshot chunk at " << header.offset << std::endl;
+        return;
+    }
+
+    m_terrainSnapshot.insert(m_terrainSnapshot.end(), p.payload.begin() + sizeof(header), p.payload.end());
+    if (m_terrainSnapshot.size() < header.totalSize) return;
+
+    m_syncingTerrain = false;
+    std::vector<Packet> deferred;
+    deferred.swap(m_deferredTerrainDiffs);
+
+    // The diffs already applied lead past this snapshot; keep them.
+    if (header.version < m_terrainVersion) {
+        m_terrainSnapshot.clear();
+        for (const auto& diff : deferred) {
+            applyTerrainDiff(diff);
         }
+        return;
+    }
+
+    const size_t bitmapSize = ((size_t)header.width * header.height + 7) / 8;
+    std::vector<uint8_t> bits;
+    const auto* begin = reinterpret_cast<const unsigned char*>(m_terrainSnapshot.data());
+    if (!LZ::Decompress(begin, begin + m_terrainSnapshot.size(), bitmapSize, bits) ||
+        !m_mapLoader->unpackCells((int)header.width, (int)header.height, bits.data(), bits.size())) {
+        std::cerr << "SceneGameNet: failed to decode terrain snapshot" << std::endl;
+        return;
     }
+    m_terrainSnapshot.clear();
+    m_terrainVersion = header.version;
+    std::cout << "SceneGameNet: terrain synced at version " << m_terrainVersion << std::endl;
 
-    m_running = false;
+    // The size may have changed; rebuild the texture from scratch. Diffs newer than the
+    // snapshot, including any that arrived before the join response, go on top.
+    createMapTexture();
+    for (const auto& diff : deferred) {
+        applyTerrainDiff(diff);
+    }
+}
+
+// Runs on the client's receiver thread.
+void SceneGameNet::HandlePacket(Packet& p) {
+    size_t terrainHeaderSize = 0;
+    switch (p.header.type) {
+        case PacketType::RES_INGAME_TERRAIN_DIFF: terrainHeaderSize = sizeof(ResIngameTerrainDiff); break;
+        case PacketType::RES_INGAME_TERRAIN_SNAPSHOT: terrainHeaderSize = sizeof(ResIngameTerrainSnapshot); break;
+        case PacketType::RES_INGAME_TERRAIN_HASHES: terrainHeaderSize = sizeof(ResIngameTerrainHashes); break;
+        case PacketType::RES_INGAME_TERRAIN_CHUNKS: terrainHeaderSize = sizeof(ResIngameTerrainChunks); break;
+        default: break;
+    }
+    if (terrainHeaderSize > 0) {
+        if (p.payload.size() < terrainHeaderSize) return;
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_pendingTerrainPackets.push_back(std::move(p));
+        return;
+    }
+    if (p.header.type != PacketType::RES_INGAME_STATE || p.payload.size() < sizeof(ResIngameState)) {
+        return;
+    }
+
+    // Decoded straight into the slot the main thread will read it from.
+    ReceivedSnapshot& slot = m_received.writeBuffer();
+    std::memcpy(&slot.state, p.payload.data(), sizeof(ResIngameState));
+    slot.arrivalUs = IngameClient::NowUs();
+
+    Trace::Span span("receive_snapshot", "client");
+    if (span.active()) {
+        span.arg("tick", slot.state.tick);
+        Trace::flowEnd("snapshot", Trace::snapshotFlowId(m_playerId, slot.state.tick));
+    }
+    m_received.publish();
+}
+
+// Moves the newest received snapshot into the interpolation buffer, once per frame. Both
+// run at 60 Hz, so a frame rarely sees two snapshots; when it does, the older one is
+// skipped and SnapshotBuffer interpolates across the gap.
+void SceneGameNet::consumeSnapshot() {
+    if (!m_received.update()) return;
+    const ReceivedSnapshot& received = m_received.read();
+    m_snapshots.Push(received.state, received.arrivalUs);
 }
 
 void SceneGameNet::SendInput(uint32_t command, float value) {
-    if (!m_socket || !m_socket->IsValid()) return;
-    if (m_playerId == UINT32_MAX) return;
-
-    ReqIngameInput in{};
-    in.matchId = m_matchId;
-    in.playerId = m_playerId;
-    in.seq = ++m_seq;
-    in.command = command;
-    in.value = value;
-    PacketUtils::SendPacket(m_socket, PacketType::REQ_INGAME_INPUT, in);
+    Trace::Span span("send_input", "client");
+    if (!m_client.SendInput(command, value)) return;
+
+    const uint32_t seq = m_client.GetLastSeq();
+    if (command == INGAME_CMD_MOVE_LEFT || command == INGAME_CMD_MOVE_RIGHT || command == INGAME_CMD_STOP) {
+        m_predictor.AddInput(seq, command);
+    }
+    if (!span.active()) return;
+
+    span.arg("seq", seq);
+    span.arg("command", command);
+    Trace::flowStart("input", Trace::inputFlowId(m_playerId, seq));
 }
 
 void SceneGameNet::update() {
@@ -240,16 +404,9 @@ void SceneGameNet::update() {
         return;
     }
 
-    // Keep a local copy of server state for decision-making.
-    ResIngameState state{};
-    bool hasState = false;
-    {
-        std::lock_guard<std::mutex> lock(m_stateMutex);
-        if (m_hasState) {
-            state = m_lastState;
-            hasState = true;
-        }
-    }
+    // Decisions use the newest snapshot, not the delayed one being drawn.
+    consumeSnapshot();
+    const bool hasState = m_snapshots.HasState();
 
     // Compute dt for power charging.
     Uint32 now = SDL_GetTicks();
@@ -260,11 +417,14 @@ void SceneGameNet::update() {
 
     bool isMyTurn = false;
     uint32_t roomState = 0;
+    const NetPlayerState* me = nullptr;
     if (hasState) {
+        const ResIngameState& state = m_snapshots.Latest();
         roomState = state.roomState;
         for (uint8_t i = 0; i < state.playerCount && i < INGAME_MAX_PLAYERS; i++) {
             if (state.players[i].id == m_playerId) {
                 isMyTurn = (state.players[i].isMyTurn != 0);
+                me = &state.players[i];
                 break;
             }
         }
@@ -274,12 +434,18 @@ void SceneGameNet::update() {
     // RoomState values currently: 0 waiting, 1 playing, 2 firing, 3 game over.
     const bool canAct = hasState && (roomState == 1u) && isMyTurn;
 
-    if (!canAct) {
+    if (!canAct || !me || !me->isAlive || !m_mapLoader) {
         // Still send STOP to avoid leaving stale velocity.
+        m_predictor.Reset();
         SendInput(INGAME_CMD_STOP);
         return;
     }
 
+    // Movement is predicted from the last acknowledged state; see MovementPredictor.
+    if (!m_predictor.HasState() || me->lastInputSeq > m_predictor.GetAckedSeq()) {
+        m_predictor.Reconcile(*me, *m_mapLoader);
+    }
+
     bool moving = false;
 
     if (InputHandler::getInstance()->isKeyDown(SDL_SCANCODE_A)) {
@@ -311,6 +477,8 @@ void SceneGameNet::update() {
         SendInput(INGAME_CMD_FIRE);
     }
     wasEnterPressed = isEnterPressed;
+
+    m_predictor.Step(*m_mapLoader);
 }
 
 void SceneGameNet::render() {
@@ -322,28 +490,26 @@ void SceneGameNet::render() {
         720,
         Game::getInstance()->getRenderer());
 
-    // Visual terrain layer (updated via server explosion events).
+    // Terrain layer, refreshed from RES_INGAME_TERRAIN_DIFF / RES_INGAME_TERRAIN_SNAPSHOT packets.
     if (m_mapTexture) {
         SDL_RenderCopy(Game::getInstance()->getRenderer(), m_mapTexture, NULL, NULL);
     }
 
-    ResIngameState state{};
-    bool hasState = false;
-    {
-        std::lock_guard<std::mutex> lock(m_stateMutex);
-        if (m_hasState) {
-            state = m_lastState;
-            hasState = true;
-        }
-    }
+    // The newest snapshot drives terrain checks and the HUD; players and projectiles are
+    // drawn from the interpolated one, a little in the past.
+    if (!m_snapshots.HasState()) return;
+    const ResIngameState& state = m_snapshots.Latest();
+    ResIngameState drawn{};
+    m_snapshots.SetNetworkJitterUs(m_client.GetRtt().jitterUs());
+    m_snapshots.Sample(IngameClient::NowUs(), drawn);
+    const int64_t interpDelayUs = m_snapshots.GetDelayUs();
 
-    if (!hasState) return;
+    // The tick on screen, to line the frame up with the snapshot flow that delivered it.
+    Trace::Span span("draw_state", "client");
+    span.arg("tick", drawn.tick);
 
-    // Apply explosion events from server to our local terrain.
-    if (state.hasExplosion && m_mapLoader) {
-        m_mapLoader->applyExplosion(state.explosionX, state.explosionY, state.explosionRadius);
-        m_mapModified = true;
-    }
+    applyTerrainUpdates();
+    checkTerrainHash(state);
 
     if (m_mapModified) {
         updateMapTexture();
@@ -351,15 +517,19 @@ void SceneGameNet::render() {
     }
 
     // Draw players.
-    for (uint8_t i = 0; i < state.playerCount && i < INGAME_MAX_PLAYERS; i++) {
-        const auto& pl = state.players[i];
+    for (uint8_t i = 0; i < drawn.playerCount && i < INGAME_MAX_PLAYERS; i++) {
+        const auto& pl = drawn.players[i];
         if (!pl.isAlive) continue;
 
-        SDL_RendererFlip flip = (pl.orient == 0) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+        // Our own player is drawn where the prediction has it, ahead of the snapshots.
+        Position pos{pl.x, pl.y, pl.orient != 0};
+        if (pl.id == m_playerId && m_predictor.HasState()) pos = m_predictor.GetDrawPosition();
+
+        SDL_RendererFlip flip = pos.orient ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL;
         TextureManager::getInstance()->drawScaled(
             m_playerID,
-            (int)pl.x,
-            (int)pl.y,
+            (int)pos.x,
+            (int)pos.y,
             32,
             32,
             Game::getInstance()->getRenderer(),
@@ -368,8 +538,8 @@ void SceneGameNet::render() {
     }
 
     // Draw projectiles.
-    for (uint8_t i = 0; i < state.projectileCount && i < INGAME_MAX_PROJECTILES; i++) {
-        const auto& pr = state.projectiles[i];
+    for (uint8_t i = 0; i < drawn.projectileCount && i < INGAME_MAX_PROJECTILES; i++) {
+        const auto& pr = drawn.projectiles[i];
         if (!pr.isActive) continue;
 
         // Prefer sprite if loaded; otherwise (or additionally) draw a small rect.
@@ -423,6 +593,22 @@ void SceneGameNet::render() {
             drawText("Angle " + std::to_string(angleInt), 10, 10);
             drawText("Power " + std::to_string(powerInt), 10, 40);
             drawText("Time " + std::to_string(secondsLeft), 10, 70);
+
+            // Whole-session input -> ack distribution (seq echoed by the server).
+            const LatencyHistogram& rtt = m_client.GetInputAckLatency();
+            if (rtt.count() > 0) {
+                char line[64];
+                std::snprintf(line, sizeof(line), "Input RTT p50 %.0f p99 %.0f ms", rtt.percentile(0.50) / 1e6,
+                              rtt.percentile(0.99) / 1e6);
+                drawText(line, 10, 100);
+            }
+            const RttEstimator& ping = m_client.GetRtt();
+            if (ping.hasSample()) {
+                char line[64];
+                std::snprintf(line, sizeof(line), "Ping %.0f ms +/- %.0f, delay %.0f ms", ping.srttUs() / 1e3,
+                              ping.jitterUs() / 1e3, interpDelayUs / 1e3);
+                drawText(line, 10, 130);
+            }
         }
     }
 }
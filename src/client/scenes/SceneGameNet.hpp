@@ -5,16 +5,21 @@
 #include "../core/TextureManager.hpp"
 #include "../core/InputHandler.hpp"
 
-#include "../../common/network/TCPSocket.hpp"
+#include "../network/IngameClient.hpp"
+#include "../network/MovementPredictor.hpp"
+#include "../network/SnapshotBuffer.hpp"
 #include "../../common/network/PacketUtils.hpp"
 #include "../../common/network/PacketStructs.hpp"
 
+#include "../../ingame_server/logic/MapGenerator.hpp"
 #include "../../ingame_server/logic/MapLoader.hpp"
+#include "../../ingame_server/logic/TerrainDiff.hpp"
+#include "../../common/utils/LZ.hpp"
+#include "../../common/utils/TripleBuffer.hpp"
 
-#include <atomic>
 #include <mutex>
 #include <string>
-#include <thread>
+#include <vector>
 
 #include <SDL2/SDL_ttf.h>
 
@@ -30,27 +35,44 @@ public:
     std::string getStateID() const override { return "SCENE_GAME_NET"; }
 
 private:
-    void ReceiverLoop();
+    void HandlePacket(Packet& p);
     void SendInput(uint32_t command, float value = 0.0f);
 
+    void applyTerrainUpdates();
+    void applyTerrainDiff(const Packet& p);
+    void receiveTerrainSnapshotChunk(const Packet& p);
+    void checkTerrainHash(const ResIngameState& state);
+    void requestDivergentChunks(const Packet& p);
+    void applyTerrainChunks(const Packet& p);
+    void consumeSnapshot();
     void createMapTexture();
     void updateMapTexture();
 
     std::string m_serverIp;
     int m_serverPort;
 
-    std::atomic<bool> m_running;
-    std::thread m_receiverThread;
-
-    TCPSocket* m_socket;
+    IngameClient m_client;
 
     uint32_t m_matchId;
     uint32_t m_playerId;
-    uint32_t m_seq;
 
-    std::mutex m_stateMutex;
-    ResIngameState m_lastState;
-    bool m_hasState;
+    struct ReceivedSnapshot {
+        ResIngameState state;
+        int64_t arrivalUs;
+    };
+    // Receiver thread -> main thread, newest snapshot only.
+    TripleBuffer<ReceivedSnapshot> m_received;
+    SnapshotBuffer m_snapshots;      // main thread only
+    MovementPredictor m_predictor;   // main thread only
+
+    std::mutex m_stateMutex;   // m_pendingTerrainPackets
+    std::vector<Packet> m_pendingTerrainPackets;
+    uint32_t m_terrainVersion;
+    bool m_syncingTerrain;
+    bool m_terrainRepairPending;
+    uint32_t m_lastHashCheckTick;
+    std::vector<char> m_terrainSnapshot;
+    std::vector<Packet> m_deferredTerrainDiffs;
 
     std::string m_bgTextureID;
     std::string m_playerID;
@@ -60,6 +82,7 @@ private:
     MapLoader* m_mapLoader;
     SDL_Texture* m_mapTexture;
     bool m_mapModified;
+    std::vector<TerrainRect> m_dirtyRects;
 
     TTF_Font* m_font;
 
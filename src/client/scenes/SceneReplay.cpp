@@ -0,0 +1,289 @@
+#include "SceneReplay.hpp"
+
+#include <iostream>
+
+SceneReplay::SceneReplay(std::string replayPath)
+    : m_replayPath(std::move(replayPath)),
+      m_pristineMap(nullptr),
+      m_mapLoader(nullptr),
+      m_mapTexture(nullptr),
+      m_mapModified(true),
+      m_playing(true),
+      m_tickAccumulator(0.0f),
+      m_prevKeys(SDL_NUM_SCANCODES, false),
+      m_bgTextureID(""),
+      m_playerID(""),
+      m_bulletID(""),
+      m_font(nullptr),
+      m_lastTick(0) {}
+
+bool SceneReplay::onEnter() {
+    m_lastTick = SDL_GetTicks();
+
+    if (!m_reader.open(m_replayPath)) {
+        std::cerr << "SceneReplay: failed to open replay: " << m_replayPath << std::endl;
+        return false;
+    }
+
+    const ReplayFileHeader& header = m_reader.getHeader();
+    std::cout << "SceneReplay: match " << header.matchId << " on " << header.mapName << ", ticks "
+              << m_reader.getFirstTick() << ".." << m_reader.getLastTick() << ", "
+              << m_reader.getKeyframeCount() << " keyframes" << std::endl;
+
+    m_bgTextureID = "background";
+    m_playerID = "player";
+    m_bulletID = "bullet";
+
+    if (!TextureManager::getInstance()->load("assets/gameplay_background.png", m_bgTextureID, Game::getInstance()->getRenderer())) {
+        std::cerr << "SceneReplay: failed to load background" << std::endl;
+        return false;
+    }
+    if (!TextureManager::getInstance()->load("assets/player.png", m_playerID, Game::getInstance()->getRenderer())) {
+        std::cerr << "SceneReplay: failed to load player texture" << std::endl;
+        return false;
+    }
+    if (!TextureManager::getInstance()->load("assets/bullet.png", m_bulletID, Game::getInstance()->getRenderer())) {
+        std::cerr << "SceneReplay: failed to load bullet texture" << std::endl;
+    }
+
+    m_font = TTF_OpenFont("assets/font.ttf", 20);
+    if (!m_font) {
+        std::cout << "SceneReplay: Warning: Failed to load font (assets/font.ttf)" << std::endl;
+    }
+
+    // Replay terrain is stored as diffs against the pristine map.
+    m_pristineMap = new MapLoader();
+    if (!MapGenerator::Load(*m_pristineMap, header.mapName, header.seed)) {
+        std::cerr << "SceneReplay: failed to load map: " << header.mapName << std::endl;
+        return false;
+    }
+    m_mapLoader = new MapLoader(*m_pristineMap);
+    createMapTexture();
+
+    seekTo(m_reader.getFirstTick());
+    return true;
+}
+
+bool SceneReplay::onExit() {
+    m_reader.close();
+
+    if (m_mapTexture) {
+        SDL_DestroyTexture(m_mapTexture);
+        m_mapTexture = nullptr;
+    }
+
+    delete m_mapLoader;
+    m_mapLoader = nullptr;
+    delete m_pristineMap;
+    m_pristineMap = nullptr;
+
+    if (m_font) {
+        TTF_CloseFont(m_font);
+        m_font = nullptr;
+    }
+
+    TextureManager::getInstance()->clearFromTextureMap(m_bgTextureID);
+    TextureManager::getInstance()->clearFromTextureMap(m_playerID);
+    TextureManager::getInstance()->clearFromTextureMap(m_bulletID);
+
+    return true;
+}
+
+void SceneReplay::seekTo(uint32_t tick) {
+    if (!m_reader.isOpen() || !m_pristineMap) return;
+
+    if (!m_reader.seek(tick, m_spans)) {
+        std::cerr << "SceneReplay: seek to tick " << tick << " failed" << std::endl;
+        return;
+    }
+
+    *m_mapLoader = *m_pristineMap;
+    ReplayCodec::ApplySpans(*m_mapLoader, m_spans);
+    // The reset to the pristine map touched everything, not just the spans.
+    m_mapLoader->markDirty(0, 0, m_mapLoader->getWidth(), m_mapLoader->getHeight());
+    m_mapModified = true;
+    m_tickAccumulator = 0.0f;
+}
+
+void SceneReplay::stepForward() {
+    m_spans.clear();
+    if (!m_reader.step(m_spans)) {
+        m_playing = false;
+        return;
+    }
+    if (!m_spans.empty()) {
+        ReplayCodec::ApplySpans(*m_mapLoader, m_spans);
+        m_mapModified = true;
+    }
+}
+
+bool SceneReplay::wasKeyPressed(SDL_Scancode key) {
+    const bool down = InputHandler::getInstance()->isKeyDown(key);
+    const bool pressed = down && !m_prevKeys[key];
+    m_prevKeys[key] = down;
+    return pressed;
+}
+
+void SceneReplay::update() {
+    if (InputHandler::getInstance()->isKeyDown(SDL_SCANCODE_ESCAPE)) {
+        Game::getInstance()->quit();
+        return;
+    }
+    if (!m_reader.isOpen()) return;
+
+    Uint32 now = SDL_GetTicks();
+    float dt = (m_lastTick == 0) ? 0.0f : (float)(now - m_lastTick) / 1000.0f;
+    m_lastTick = now;
+    if (dt < 0.0f) dt = 0.0f;
+    if (dt > 0.1f) dt = 0.1f;
+
+    const float tickSeconds = m_reader.getHeader().tickSeconds > 0.0f ? m_reader.getHeader().tickSeconds : (1.0f / 60.0f);
+    const int ticksPerSecond = (int)(1.0f / tickSeconds + 0.5f);
+    const int64_t current = m_reader.getFrame().tick;
+    const int64_t first = m_reader.getFirstTick();
+    const int64_t last = m_reader.getLastTick();
+
+    auto clampTick = [&](int64_t t) -> uint32_t {
+        if (t < first) t = first;
+        if (t > last) t = last;
+        return (uint32_t)t;
+    };
+
+    if (wasKeyPressed(SDL_SCANCODE_SPACE)) {
+        if (!m_playing && current >= last) seekTo((uint32_t)first);
+        m_playing = !m_playing;
+    }
+    if (wasKeyPressed(SDL_SCANCODE_LEFT)) seekTo(clampTick(current - ticksPerSecond));
+    if (wasKeyPressed(SDL_SCANCODE_RIGHT)) seekTo(clampTick(current + ticksPerSecond));
+    if (wasKeyPressed(SDL_SCANCODE_DOWN)) seekTo(clampTick(current - 10 * ticksPerSecond));
+    if (wasKeyPressed(SDL_SCANCODE_UP)) seekTo(clampTick(current + 10 * ticksPerSecond));
+    if (wasKeyPressed(SDL_SCANCODE_HOME)) seekTo((uint32_t)first);
+    if (wasKeyPressed(SDL_SCANCODE_END)) seekTo((uint32_t)last);
+
+    const SDL_Scancode digits[10] = {
+        SDL_SCANCODE_0, SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3, SDL_SCANCODE_4,
+        SDL_SCANCODE_5, SDL_SCANCODE_6, SDL_SCANCODE_7, SDL_SCANCODE_8, SDL_SCANCODE_9,
+    };
+    for (int i = 0; i < 10; i++) {
+        if (wasKeyPressed(digits[i])) {
+            seekTo(clampTick(first + (last - first) * i / 10));
+        }
+    }
+
+    if (m_playing) {
+        m_tickAccumulator += dt;
+        while (m_playing && m_tickAccumulator >= tickSeconds) {
+            m_tickAccumulator -= tickSeconds;
+            stepForward();
+        }
+    }
+}
+
+void SceneReplay::createMapTexture() {
+    if (!m_mapLoader) return;
+
+    SDL_Renderer* renderer = Game::getInstance()->getRenderer();
+    const int width = m_mapLoader->getWidth();
+    const int height = m_mapLoader->getHeight();
+    if (width <= 0 || height <= 0) return;
+
+    m_mapTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!m_mapTexture) {
+        std::cerr << "SceneReplay: failed to create map texture: " << SDL_GetError() << std::endl;
+        return;
+    }
+
+    SDL_SetTextureBlendMode(m_mapTexture, SDL_BLENDMODE_BLEND);
+    m_mapLoader->markDirty(0, 0, width, height);
+    updateMapTexture();
+}
+
+void SceneReplay::updateMapTexture() {
+    if (!m_mapTexture || !m_mapLoader) return;
+
+    // Only the regions changed since the last refresh are re-uploaded.
+    m_dirtyRects.clear();
+    m_mapLoader->drainDirtyRects(m_dirtyRects);
+
+    for (const auto& r : m_dirtyRects) {
+        SDL_Rect rect = {r.x, r.y, r.w, r.h};
+        void* pixels = nullptr;
+        int pitch = 0;
+        if (SDL_LockTexture(m_mapTexture, &rect, &pixels, &pitch) != 0 || !pixels) {
+            std::cerr << "SceneReplay: failed to lock map texture: " << SDL_GetError() << std::endl;
+            return;
+        }
+
+        for (int y = 0; y < r.h; y++) {
+            auto* row = reinterpret_cast<Uint32*>(reinterpret_cast<Uint8*>(pixels) + y * pitch);
+            m_mapLoader->expandRow(r.y + y, r.x, r.w, 0x3C280DFF, 0x00000000, row);
+        }
+
+        SDL_UnlockTexture(m_mapTexture);
+    }
+}
+
+void SceneReplay::render() {
+    SDL_Renderer* renderer = Game::getInstance()->getRenderer();
+
+    TextureManager::getInstance()->drawScaled(m_bgTextureID, 0, 0, 1280, 720, renderer);
+
+    if (m_mapModified) {
+        updateMapTexture();
+        m_mapModified = false;
+    }
+    if (m_mapTexture) {
+        SDL_RenderCopy(renderer, m_mapTexture, NULL, NULL);
+    }
+
+    if (!m_reader.isOpen()) return;
+    const ReplayFrame& frame = m_reader.getFrame();
+
+    for (uint8_t i = 0; i < frame.playerCount && i < INGAME_MAX_PLAYERS; i++) {
+        const auto& pl = frame.players[i];
+        if (!pl.isAlive) continue;
+
+        SDL_RendererFlip flip = (pl.orient == 0) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+        TextureManager::getInstance()->drawScaled(m_playerID, (int)pl.x, (int)pl.y, 32, 32, renderer, 0.0, flip);
+    }
+
+    for (uint8_t i = 0; i < frame.projectileCount && i < INGAME_MAX_PROJECTILES; i++) {
+        const auto& pr = frame.projectiles[i];
+        if (!pr.isActive) continue;
+        TextureManager::getInstance()->drawScaled(m_bulletID, (int)pr.x - 8, (int)pr.y - 8, 16, 16, renderer);
+    }
+
+    // Timeline.
+    const uint32_t first = m_reader.getFirstTick();
+    const uint32_t last = m_reader.getLastTick();
+    const float progress = (last > first) ? (float)(frame.tick - first) / (float)(last - first) : 1.0f;
+
+    SDL_Rect bar = {20, 690, 1240, 10};
+    SDL_SetRenderDrawColor(renderer, 40, 40, 40, 255);
+    SDL_RenderFillRect(renderer, &bar);
+    SDL_Rect filled = {20, 690, (int)(1240 * progress), 10};
+    SDL_SetRenderDrawColor(renderer, 230, 200, 60, 255);
+    SDL_RenderFillRect(renderer, &filled);
+
+    if (m_font) {
+        const float tickSeconds = m_reader.getHeader().tickSeconds;
+        const int seconds = (int)((frame.tick - first) * tickSeconds);
+        const int total = (int)((last - first) * tickSeconds);
+        std::string text = std::string(m_playing ? "Playing " : "Paused ") +
+                           std::to_string(seconds / 60) + ":" + (seconds % 60 < 10 ? "0" : "") + std::to_string(seconds % 60) +
+                           " / " + std::to_string(total / 60) + ":" + (total % 60 < 10 ? "0" : "") + std::to_string(total % 60) +
+                           "  tick " + std::to_string(frame.tick);
+
+        SDL_Color textColor = {255, 255, 255, 255};
+        SDL_Surface* surface = TTF_RenderText_Solid(m_font, text.c_str(), textColor);
+        if (surface) {
+            SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, surface);
+            if (tex) {
+                SDL_Rect rect = {20, 660, surface->w, surface->h};
+                SDL_RenderCopy(renderer, tex, NULL, &rect);
+                SDL_DestroyTexture(tex);
+            }
+            SDL_FreeSurface(surface);
+        }
+    }
+}
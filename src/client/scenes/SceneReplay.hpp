@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../core/GameState.hpp"
+#include "../core/Game.hpp"
+#include "../core/TextureManager.hpp"
+#include "../core/InputHandler.hpp"
+
+#include "../../ingame_server/logic/MapGenerator.hpp"
+#include "../../ingame_server/logic/MapLoader.hpp"
+#include "../../ingame_server/logic/ReplayFile.hpp"
+
+#include <string>
+#include <vector>
+
+#include <SDL2/SDL_ttf.h>
+
+// Plays back a replay file (ReplayFile.hpp) with instant seeking.
+// Controls: SPACE play/pause, LEFT/RIGHT -/+1s, DOWN/UP -/+10s, HOME/END, 0-9 jump to 0%..90%.
+class SceneReplay : public GameState {
+public:
+    SceneReplay(std::string replayPath);
+
+    bool onEnter() override;
+    bool onExit() override;
+    void update() override;
+    void render() override;
+
+    std::string getStateID() const override { return "SCENE_REPLAY"; }
+
+private:
+    void seekTo(uint32_t tick);
+    void stepForward();
+    bool wasKeyPressed(SDL_Scancode key);
+
+    void createMapTexture();
+    void updateMapTexture();
+
+    std::string m_replayPath;
+    ReplayReader m_reader;
+
+    MapLoader* m_pristineMap;
+    MapLoader* m_mapLoader;
+    SDL_Texture* m_mapTexture;
+    bool m_mapModified;
+    std::vector<ReplayTerrainSpan> m_spans;
+    std::vector<TerrainRect> m_dirtyRects;
+
+    bool m_playing;
+    float m_tickAccumulator;
+    std::vector<bool> m_prevKeys;
+
+    std::string m_bgTextureID;
+    std::string m_playerID;
+    std::string m_bulletID;
+    TTF_Font* m_font;
+
+    Uint32 m_lastTick;
+};
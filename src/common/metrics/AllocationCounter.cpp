@@ -0,0 +1,80 @@
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+struct alignas(64) AllocationShard {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> frees;
+    std::atomic<uint64_t> allocatedBytes;
+    std::atomic<uint64_t> freedBytes;
+};
+
+// Zero-initialised before any constructor runs, so allocations made during static
+// initialisation land here too. A CounterSet would not exist yet at that point.
+AllocationShard g_shards[Metrics::kShards];
+
+void* CountedAlloc(std::size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) return nullptr;
+    AllocationShard& shard = g_shards[Metrics::shardIndex()];
+    shard.allocations.fetch_add(1, std::memory_order_relaxed);
+    shard.allocatedBytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+    return p;
+}
+
+void CountedFree(void* p) {
+    if (!p) return;
+    AllocationShard& shard = g_shards[Metrics::shardIndex()];
+    shard.frees.fetch_add(1, std::memory_order_relaxed);
+    shard.freedBytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+    std::free(p);
+}
+}
+
+void* operator new(std::size_t size) {
+    void* p = CountedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = CountedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+
+void operator delete(void* p) noexcept { CountedFree(p); }
+void operator delete[](void* p) noexcept { CountedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { CountedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { CountedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { CountedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { CountedFree(p); }
+
+void Metrics::WriteAllocationMetrics(PrometheusText& out) {
+    // Frees first: a block freed after its allocation was summed would make live bytes
+    // go negative.
+    uint64_t allocations = 0, frees = 0, allocatedBytes = 0, freedBytes = 0;
+    for (const AllocationShard& s : g_shards) {
+        frees += s.frees.load(std::memory_order_relaxed);
+        freedBytes += s.freedBytes.load(std::memory_order_relaxed);
+    }
+    for (const AllocationShard& s : g_shards) {
+        allocations += s.allocations.load(std::memory_order_relaxed);
+        allocatedBytes += s.allocatedBytes.load(std::memory_order_relaxed);
+    }
+
+    out.Family("gummy_allocations_total", "counter", "operator new calls.");
+    out.Sample("gummy_allocations_total", "", (double)allocations);
+    out.Family("gummy_frees_total", "counter", "operator delete calls on non-null pointers.");
+    out.Sample("gummy_frees_total", "", (double)frees);
+    out.Family("gummy_allocated_bytes_total", "counter", "Usable bytes handed out by operator new.");
+    out.Sample("gummy_allocated_bytes_total", "", (double)allocatedBytes);
+    out.Family("gummy_heap_live_bytes", "gauge", "Bytes allocated through operator new and not yet freed.");
+    out.Sample("gummy_heap_live_bytes", "", allocatedBytes > freedBytes ? (double)(allocatedBytes - freedBytes) : 0.0);
+}
@@ -0,0 +1,12 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include "MetricsServer.hpp"
+
+// Linking AllocationCounter.cpp replaces the global operator new/delete with versions
+// that count calls and usable bytes per thread shard. Only the servers link it.
+namespace Metrics {
+void WriteAllocationMetrics(PrometheusText& out);
+}
+
+#endif // ALLOCATION_COUNTER_HPP
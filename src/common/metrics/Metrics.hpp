@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "../network/PacketType.hpp"
+#include "../utils/LatencyHistogram.hpp"
+
+// Counters for the /metrics endpoint (MetricsServer). Hot paths only touch their own
+// thread's shard; the scrape sums the shards, so reading never blocks a writer.
+namespace Metrics {
+
+// Threads are spread over the shards round-robin. Past kShards threads (the service
+// server runs one per client) shards are shared, which is why updates are fetch_adds.
+constexpr size_t kShards = 32;
+
+inline size_t shardIndex() {
+    static std::atomic<size_t> next{0};
+    static thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return index;
+}
+
+// `size` counters, one row of them per shard. Rows are padded to whole cache lines.
+class CounterSet {
+public:
+    explicit CounterSet(size_t size)
+        : m_size(size),
+          m_stride((size + 7) & ~(size_t)7),
+          m_cells(new std::atomic<uint64_t>[m_stride * kShards]) {
+        for (size_t i = 0; i < m_stride * kShards; i++) m_cells[i].store(0, std::memory_order_relaxed);
+    }
+
+    void add(size_t index, uint64_t n = 1) {
+        m_cells[shardIndex() * m_stride + index].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t sum(size_t index) const {
+        uint64_t total = 0;
+        for (size_t s = 0; s < kShards; s++) total += m_cells[s * m_stride + index].load(std::memory_order_relaxed);
+        return total;
+    }
+
+    size_t size() const { return m_size; }
+
+private:
+    size_t m_size;
+    size_t m_stride;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_cells;
+};
+
+// LatencyHistogram's buckets for any number of writing threads.
+class Histogram {
+public:
+    static constexpr int kBuckets = LatencyHistogram::kBuckets;
+
+    Histogram() : m_cells(kBuckets + 2) {}
+
+    void record(uint64_t ns) {
+        m_cells.add((size_t)LatencyHistogram::bucketOf(ns));
+        m_cells.add(kCount);
+        m_cells.add(kSum, ns);
+    }
+
+    uint64_t count() const { return m_cells.sum(kCount); }
+    uint64_t sum() const { return m_cells.sum(kSum); }
+    uint64_t bucketCount(int bucket) const { return m_cells.sum((size_t)bucket); }
+
+private:
+    static constexpr size_t kCount = kBuckets;
+    static constexpr size_t kSum = kBuckets + 1;
+    CounterSet m_cells;
+};
+
+// Packets and bytes (header included) per PacketType and direction, counted by
+// PacketUtils for every socket in the process. Types off the end of the enum (a
+// corrupt header) share the last slot.
+enum PacketDirection { PACKETS_IN, PACKETS_OUT };
+constexpr size_t kPacketSlots = (size_t)PACKET_TYPE_COUNT + 1;
+
+inline CounterSet& packetCounters() {
+    // [direction][type][packets, bytes]
+    static CounterSet counters(2 * kPacketSlots * 2);
+    return counters;
+}
+
+inline size_t packetSlot(PacketDirection direction, uint32_t type) {
+    const size_t t = type < (uint32_t)PACKET_TYPE_COUNT ? type : (size_t)PACKET_TYPE_COUNT;
+    return ((size_t)direction * kPacketSlots + t) * 2;
+}
+
+inline void countPacket(PacketDirection direction, uint32_t type, size_t bytes) {
+    const size_t slot = packetSlot(direction, type);
+    packetCounters().add(slot);
+    packetCounters().add(slot + 1, bytes);
+}
+
+}
@@ -0,0 +1,205 @@
+#include "MetricsServer.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+// Bucket boundaries are the histograms' powers of two from ~1 us to ~68 s; every series
+// gets the same set so rates can be taken per `le`.
+constexpr int kFirstLeBits = 10;
+constexpr int kMaxRequestBytes = 8 * 1024;
+// A scraper that connects and says nothing must not hold the only serving thread.
+constexpr int kRequestTimeoutMs = 1000;
+constexpr int kAcceptPollMs = 200;
+
+void AppendLabels(std::string& out, const std::string& labels, const char* extra) {
+    if (labels.empty() && !extra) return;
+    out += '{';
+    out += labels;
+    if (extra) {
+        if (!labels.empty()) out += ',';
+        out += extra;
+    }
+    out += '}';
+}
+
+bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+}
+
+void PrometheusText::Family(const char* name, const char* type, const char* help) {
+    mOut += "# HELP ";
+    mOut += name;
+    mOut += ' ';
+    mOut += help;
+    mOut += "\n# TYPE ";
+    mOut += name;
+    mOut += ' ';
+    mOut += type;
+    mOut += '\n';
+}
+
+void PrometheusText::Sample(const char* name, const std::string& labels, double value) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), " %.15g\n", value);
+    mOut += name;
+    AppendLabels(mOut, labels, nullptr);
+    mOut += buf;
+}
+
+template <typename H>
+void PrometheusText::HistogramLines(const char* name, const std::string& labels, const H& hist) {
+    const std::string bucketName = std::string(name) + "_bucket";
+    char le[48];
+    uint64_t cumulative = 0;
+    for (int b = 0; b < LatencyHistogram::kBuckets; b++) {
+        cumulative += hist.bucketCount(b);
+        // The last sub-bucket of each power of two ends just below the next power.
+        if ((b & (LatencyHistogram::kSub - 1)) != LatencyHistogram::kSub - 1) continue;
+        const uint64_t bound = LatencyHistogram::upperBound(b) + 1;
+        if (bound < ((uint64_t)1 << kFirstLeBits)) continue;
+        std::snprintf(le, sizeof(le), "le=\"%.9g\"", bound / 1e9);
+        mOut += bucketName;
+        AppendLabels(mOut, labels, le);
+        mOut += ' ' + std::to_string(cumulative) + '\n';
+    }
+    mOut += bucketName;
+    AppendLabels(mOut, labels, "le=\"+Inf\"");
+    mOut += ' ' + std::to_string(hist.count()) + '\n';
+    Sample((std::string(name) + "_sum").c_str(), labels, hist.sum() / 1e9);
+    Sample((std::string(name) + "_count").c_str(), labels, (double)hist.count());
+}
+
+void PrometheusText::Histogram(const char* name, const std::string& labels, const LatencyHistogram& hist) {
+    HistogramLines(name, labels, hist);
+}
+
+void PrometheusText::Histogram(const char* name, const std::string& labels, const Metrics::Histogram& hist) {
+    HistogramLines(name, labels, hist);
+}
+
+MetricsServer::MetricsServer() : mListenFd(-1), mIsRunning(false) {}
+
+MetricsServer::~MetricsServer() {
+    Stop();
+}
+
+bool MetricsServer::Start(int port, RenderFn render) {
+    if (mIsRunning) return false;
+
+    mListenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (mListenFd < 0) {
+        std::cerr << "MetricsServer: socket failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int opt = 1;
+    setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // Local scrapers only; nothing here is meant for players.
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(mListenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(mListenFd, 16) < 0) {
+        std::cerr << "MetricsServer: cannot listen on 127.0.0.1:" << port << ": " << std::strerror(errno) << std::endl;
+        close(mListenFd);
+        mListenFd = -1;
+        return false;
+    }
+
+    mRender = std::move(render);
+    mIsRunning = true;
+    mThread = std::thread(&MetricsServer::Serve, this);
+    std::cout << "MetricsServer: serving http://127.0.0.1:" << port << "/metrics" << std::endl;
+    return true;
+}
+
+void MetricsServer::Stop() {
+    mIsRunning = false;
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    if (mListenFd >= 0) {
+        close(mListenFd);
+        mListenFd = -1;
+    }
+}
+
+void MetricsServer::Serve() {
+    while (mIsRunning) {
+        pollfd pfd{mListenFd, POLLIN, 0};
+        if (poll(&pfd, 1, kAcceptPollMs) <= 0) continue;
+
+        const int fd = accept(mListenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        timeval timeout{kRequestTimeoutMs / 1000, (kRequestTimeoutMs % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        HandleRequest(fd);
+        close(fd);
+    }
+}
+
+void MetricsServer::HandleRequest(int fd) {
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < (size_t)kMaxRequestBytes) {
+        const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        request.append(buf, (size_t)n);
+    }
+
+    std::string body;
+    const char* status = "200 OK";
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0) {
+        PrometheusText text;
+        mRender(text);
+        body = text.Str();
+    } else {
+        status = "404 Not Found";
+        body = "try GET /metrics\n";
+    }
+
+    std::string response = "HTTP/1.1 ";
+    response += status;
+    response += "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: ";
+    response += std::to_string(body.size());
+    response += "\r\nConnection: close\r\n\r\n";
+    response += body;
+    SendAll(fd, response);
+}
+
+void Metrics::WritePacketMetrics(PrometheusText& out) {
+    const CounterSet& counters = packetCounters();
+    const char* families[2][3] = {
+        {"gummy_packets_total", "counter", "Packets sent and received, by type."},
+        {"gummy_packet_bytes_total", "counter", "Packet bytes (header included) sent and received, by type."}};
+
+    for (int field = 0; field < 2; field++) {
+        out.Family(families[field][0], families[field][1], families[field][2]);
+        for (int dir = PACKETS_IN; dir <= PACKETS_OUT; dir++) {
+            for (size_t type = 0; type < kPacketSlots; type++) {
+                const uint64_t value = counters.sum(packetSlot((PacketDirection)dir, (uint32_t)type) + field);
+                if (value == 0) continue;
+                std::string labels = std::string("direction=\"") + (dir == PACKETS_IN ? "in" : "out") +
+                                     "\",type=\"" + PacketTypeName((int)type) + "\"";
+                out.Sample(families[field][0], labels, (double)value);
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "Metrics.hpp"
+
+// Builds a Prometheus text exposition (format 0.0.4). Durations are written in seconds.
+class PrometheusText {
+private:
+    std::string mOut;
+
+    template <typename H>
+    void HistogramLines(const char* name, const std::string& labels, const H& hist);
+
+public:
+    // Writes the # HELP / # TYPE lines; call once per metric name, before its samples.
+    void Family(const char* name, const char* type, const char* help);
+    // `labels` is the inside of the braces, e.g. state="PLAYING_TURN"; empty for none.
+    void Sample(const char* name, const std::string& labels, double value);
+    void Histogram(const char* name, const std::string& labels, const LatencyHistogram& hist);
+    void Histogram(const char* name, const std::string& labels, const Metrics::Histogram& hist);
+
+    const std::string& Str() const { return mOut; }
+};
+
+// Serves GET /metrics on 127.0.0.1 from its own thread. The render callback runs on that
+// thread for every scrape, so it must only read atomics (or take locks the hot paths
+// never wait on).
+class MetricsServer {
+public:
+    using RenderFn = std::function<void(PrometheusText&)>;
+
+    MetricsServer();
+    ~MetricsServer();
+
+    bool Start(int port, RenderFn render);
+    void Stop();
+
+private:
+    int mListenFd;
+    std::atomic<bool> mIsRunning;
+    std::thread mThread;
+    RenderFn mRender;
+
+    void Serve();
+    void HandleRequest(int fd);
+};
+
+namespace Metrics {
+// gummy_packets_total / gummy_packet_bytes_total from packetCounters().
+void WritePacketMetrics(PrometheusText& out);
+}
+
+#endif // METRICS_SERVER_HPP
@@ -38,6 +38,12 @@ public:
         header.length = static_cast<uint32_t>(size);
     }
 
+    // Append raw bytes after the struct (variable-length packets)
+    void AppendPayload(const std::vector<char>& bytes) {
+        payload.insert(payload.end(), bytes.begin(), bytes.end());
+        header.length = static_cast<uint32_t>(payload.size());
+    }
+
     // Convert payload bytes into struct
     template<typename T>
     T GetPayload() const {
@@ -142,6 +142,8 @@ typedef struct {
     uint32_t matchId;
     uint32_t playerId;
     char message[100];
+    char mapName[64]; // map file path, or "procedural[:WxH]" generated from mapSeed
+    uint32_t mapSeed;
 } ResIngameJoin;
 
 typedef struct {
@@ -162,6 +164,15 @@ typedef struct {
     float y;
     float angle;
     float power;
+    // Movement state, so a client can replay its unacknowledged inputs from here.
+    float vx;
+    float vy;
+    uint8_t isAsleep;
+    // Newest REQ_INGAME_INPUT seq of this player the room has applied (0 for none), with
+    // the server's steady-clock times of its arrival and of the tick that applied it.
+    uint32_t lastInputSeq;
+    int64_t inputReceivedUs;
+    int64_t inputAppliedUs;
 } NetPlayerState;
 
 typedef struct {
@@ -177,16 +188,83 @@ typedef struct {
     uint32_t tick;
     uint32_t roomState;
     float turnTimer;
-    uint8_t terrainModified;
-    uint8_t hasExplosion;
-    float explosionX;
-    float explosionY;
-    float explosionRadius;
+    uint32_t terrainVersion; // last RES_INGAME_TERRAIN_DIFF version sent before this snapshot
+    uint8_t hasTerrainHash;  // set every few ticks; terrainHash is MapLoader::getTerrainHash at terrainVersion
+    uint64_t terrainHash;
     uint8_t playerCount;
     uint8_t projectileCount;
     NetPlayerState players[INGAME_MAX_PLAYERS];
     NetProjectileState projectiles[INGAME_MAX_PROJECTILES];
 } ResIngameState;
+
+// Followed by TerrainDiff-encoded regions (TerrainDiff.hpp) up to header.length.
+// Sent before the RES_INGAME_STATE of the same tick; version increases by one per diff.
+typedef struct {
+    uint32_t matchId;
+    uint32_t tick;
+    uint32_t version;
+} ResIngameTerrainDiff;
+
+// Followed by one chunk of the LZ-compressed (LZ.hpp) packed terrain bitmap
+// (MapLoader::packCells). Chunks of a snapshot arrive in order, one per tick; diffs
+// with a version above `version` that arrive meanwhile apply on top of it.
+typedef struct {
+    uint32_t matchId;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t totalSize; // compressed bytes across all chunks
+    uint32_t offset;    // position of this chunk in the compressed stream
+} ResIngameTerrainSnapshot;
+
+// Desync repair: after a terrainHash mismatch the client asks for the per-chunk
+// hashes, compares them with its own and requests only the chunks that differ.
+typedef struct {
+    uint32_t matchId;
+} ReqIngameTerrainHashes;
+
+// Followed by chunksX * chunksY uint64_t hashes (MapLoader::getChunkHashes).
+typedef struct {
+    uint32_t matchId;
+    uint32_t version;
+    uint32_t chunkSize;
+    uint32_t chunksX;
+    uint32_t chunksY;
+} ResIngameTerrainHashes;
+
+// Followed by `count` uint32_t chunk indices.
+typedef struct {
+    uint32_t matchId;
+    uint32_t version;
+    uint32_t count;
+} ReqIngameTerrainChunks;
+
+// Followed by the requested chunks as TerrainDiff regions; only valid at `version`.
+typedef struct {
+    uint32_t matchId;
+    uint32_t version;
+} ResIngameTerrainChunks;
+
+// Either end may ping; the other answers at once with RES_INGAME_PONG echoing `id` and
+// `sentUs` and adding its own clock. Clocks are steady-clock microseconds of the sender
+// (RttEstimator turns an exchange into RTT, jitter and clock offset).
+typedef struct {
+    uint32_t id;
+    int64_t sentUs;
+} ReqIngamePing;
+
+typedef struct {
+    uint32_t id;
+    int64_t sentUs;  // from the ping
+    int64_t replyUs; // responder's clock when it answered
+} ResIngamePong;
 #pragma pack(pop)
 // --------------------------------------------------------
+// Ingame Server -> Service Server ------------------------
+// Sent once the match recording is closed; the service stores it in "Match".log_path.
+typedef struct {
+    uint32_t matchId;
+    char logPath[256];
+} ReqMatchLogPath;
+// --------------------------------------------------------
 #endif // PACKET_STRUCTS_H
\ No newline at end of file
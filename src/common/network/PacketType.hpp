@@ -33,6 +33,32 @@ enum PacketType {
     RES_INGAME_JOIN,
     REQ_INGAME_INPUT,
     RES_INGAME_STATE,
+    RES_INGAME_TERRAIN_DIFF,
+    RES_INGAME_TERRAIN_SNAPSHOT,
+    REQ_INGAME_TERRAIN_HASHES,
+    RES_INGAME_TERRAIN_HASHES,
+    REQ_INGAME_TERRAIN_CHUNKS,
+    RES_INGAME_TERRAIN_CHUNKS,
+    REQ_INGAME_PING,
+    RES_INGAME_PONG,
+
+    // Ingame server -> service server
+    REQ_MATCH_LOG_PATH,
+
+    PACKET_TYPE_COUNT // not a packet; new types go above and into PacketTypeName
 };
 
+inline const char* PacketTypeName(int type) {
+    static const char* const names[PACKET_TYPE_COUNT] = {
+        "REQ_AUTHENTICATE", "RES_AUTHENTICATE", "REQ_LOGOUT", "REQ_CHANGE_PASSWORD", "RES_CHANGE_PASSWORD",
+        "REQ_GET_PROFILE", "RES_GET_PROFILE", "REQ_UPDATE_PROFILE", "RES_UPDATE_PROFILE", "REQ_SEARCH_USER",
+        "RES_SEARCH_USER", "REQ_MATCH_FIND", "RES_MATCH_FIND", "REQ_MATCH_DECIDE_1", "RES_MATCH_DECIDE_1",
+        "RES_MATCH_DECIDE_2", "INIT_GAME", "REQ_PLAY", "RES_PLAY", "RES_EXECUTE_PLAY", "GAME_RESULT",
+        "REQ_INGAME_JOIN", "RES_INGAME_JOIN", "REQ_INGAME_INPUT", "RES_INGAME_STATE", "RES_INGAME_TERRAIN_DIFF",
+        "RES_INGAME_TERRAIN_SNAPSHOT", "REQ_INGAME_TERRAIN_HASHES", "RES_INGAME_TERRAIN_HASHES",
+        "REQ_INGAME_TERRAIN_CHUNKS", "RES_INGAME_TERRAIN_CHUNKS", "REQ_INGAME_PING", "RES_INGAME_PONG",
+        "REQ_MATCH_LOG_PATH"};
+    return (type >= 0 && type < PACKET_TYPE_COUNT) ? names[type] : "UNKNOWN";
+}
+
 #endif // PACKET_TYPE_HPP
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "Packet.hpp"
 #include "TCPSocket.hpp"
+#include "../utils/Log.hpp"
 #include <vector>
 #include <string>
 #include <cstdint>
@@ -25,6 +26,7 @@ namespace PacketUtils {
     template <typename T>
     bool SendPacket(TCPSocket* socket, PacketType type, const T& payloadStruct);
     bool SendPacket(TCPSocket* socket, PacketType type);
+    bool SendPacket(TCPSocket* socket, const Packet& packet);
     template <typename T>
     bool ReceivePacketPayload(TCPSocket* socket, T& outPayload);
     bool ReceivePacket(TCPSocket* socket, Packet& outPacket);
@@ -35,9 +37,7 @@ template <typename T>
 bool PacketUtils::SendPacket(TCPSocket* socket, PacketType type, const T& payloadStruct) {
     Packet packet(type);
     packet.SetPayload(payloadStruct);
-    std::vector<char> buffer;
-    PacketUtils::SerializePacket(packet, buffer);
-    return socket->Send(buffer.data(), buffer.size());
+    return SendPacket(socket, packet);
 }
 
 template <typename T>
@@ -51,7 +51,7 @@ bool PacketUtils::ReceivePacketPayload(TCPSocket* socket, T& outPayload) {
         outPayload = packet.GetPayload<T>();
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "PacketUtils: Failed to cast payload: " << e.what() << std::endl;
+        LOG_WARN("payload_cast_failed", "type", (int)packet.header.type, "error", e.what());
         return false;
     }
 }
@@ -1,6 +1,9 @@
 #include "TCPSocket.hpp"
 #include <cstring>
 #include <iostream>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
 
 TCPSocket::TCPSocket() {
     mSockFd = socket(AF_INET, SOCK_STREAM, 0);
@@ -106,3 +109,18 @@ void TCPSocket::SetNonBlocking(bool isNonBlocking) {
         fcntl(mSockFd, F_SETFL, flags & ~O_NONBLOCK);
     }
 }
+
+void TCPSocket::SetNoDelay(bool noDelay) {
+    int opt = noDelay ? 1 : 0;
+    setsockopt(mSockFd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+}
+
+int TCPSocket::GetSendQueueBytes() const {
+    int queued = 0;
+    if (ioctl(mSockFd, SIOCOUTQ, &queued) < 0) return -1;
+    return queued;
+}
+
+void TCPSocket::Shutdown() {
+    if (mSockFd >= 0) shutdown(mSockFd, SHUT_RDWR);
+}
@@ -32,7 +32,15 @@ public:
     int Receive(void* buffer, size_t size);
     // Utility Methods
     void Close();
+    // Ends the connection in both directions without releasing the fd: a thread blocked
+    // in Receive on it returns, and that thread stays the one to Close it.
+    void Shutdown();
     void SetNonBlocking(bool isNonBlocking);
+    // Disables Nagle's algorithm: small packets go out immediately instead of waiting
+    // for the previous one to be acknowledged.
+    void SetNoDelay(bool noDelay);
+    // Bytes written but not yet acknowledged by the peer (SIOCOUTQ), -1 on error.
+    int GetSendQueueBytes() const;
     int GetFd() const { return mSockFd; }
     bool IsValid() const { return mSockFd >= 0;}
 };
@@ -1,4 +1,5 @@
 #include "PacketUtils.hpp"
+#include "../metrics/Metrics.hpp"
 #include <cstring>
 #include <iostream>
 
@@ -110,10 +111,15 @@ namespace PacketUtils {
     // Template implementations moved to PacketUtils.hpp
 
     bool SendPacket(TCPSocket* socket, PacketType type) {
-        Packet packet(type);
+        return SendPacket(socket, Packet(type));
+    }
+
+    bool SendPacket(TCPSocket* socket, const Packet& packet) {
         std::vector<char> buffer;
         PacketUtils::SerializePacket(packet, buffer);
-        return socket->Send(buffer.data(), buffer.size());
+        if (!socket->Send(buffer.data(), buffer.size())) return false;
+        Metrics::countPacket(Metrics::PACKETS_OUT, packet.header.type, buffer.size());
+        return true;
     }
 
     bool ReceivePacket(TCPSocket* socket, Packet& outPacket) {
@@ -146,6 +152,7 @@ namespace PacketUtils {
 
         outPacket.header = header;
         outPacket.payload = payloadBuffer;
+        Metrics::countPacket(Metrics::PACKETS_IN, header.type, sizeof(Header) + header.length);
         return true;
     }
 
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Varint.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Small LZ77 byte compressor for bulk transfers (terrain snapshots).
+//
+//   sequence* : varint literalCount, literal bytes, varint matchLength [, varint offset]
+//
+// The last sequence has matchLength 0 and no offset. Matches are found through a
+// hash of the next 4 bytes and may overlap their source (offset < length), which
+// turns long runs of identical bytes into a few bytes of output.
+namespace LZ {
+    constexpr size_t kMinMatch = 4;
+    constexpr size_t kHashBits = 14;
+    constexpr size_t kMaxOffset = 1u << 20;
+
+    inline uint32_t Read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline void Compress(const uint8_t* in, size_t size, std::vector<char>& out) {
+        std::vector<int64_t> table(1u << kHashBits, -1);
+
+        size_t anchor = 0;
+        size_t i = 0;
+        while (i + kMinMatch <= size) {
+            const uint32_t word = Read32(in + i);
+            const uint32_t h = (word * 2654435761u) >> (32 - kHashBits);
+            const int64_t candidate = table[h];
+            table[h] = (int64_t)i;
+
+            if (candidate < 0 || i - (size_t)candidate > kMaxOffset || Read32(in + candidate) != word) {
+                i++;
+                continue;
+            }
+
+            size_t length = kMinMatch;
+            while (i + length < size && in[candidate + length] == in[i + length]) length++;
+
+            Varint::WriteVarint(out, (uint32_t)(i - anchor));
+            out.insert(out.end(), in + anchor, in + i);
+            Varint::WriteVarint(out, (uint32_t)length);
+            Varint::WriteVarint(out, (uint32_t)(i - (size_t)candidate));
+
+            i += length;
+            anchor = i;
+        }
+
+        Varint::WriteVarint(out, (uint32_t)(size - anchor));
+        out.insert(out.end(), in + anchor, in + size);
+        Varint::WriteVarint(out, 0);
+    }
+
+    // Fails on malformed input or when the output would not be exactly expectedSize bytes.
+    inline bool Decompress(const unsigned char* p, const unsigned char* end, size_t expectedSize, std::vector<uint8_t>& out) {
+        out.clear();
+        out.reserve(expectedSize);
+
+        while (true) {
+            uint32_t literals = 0, length = 0;
+            if (!Varint::ReadVarint(p, end, literals)) return false;
+            if ((size_t)(end - p) < literals || out.size() + literals > expectedSize) return false;
+            out.insert(out.end(), p, p + literals);
+            p += literals;
+
+            if (!Varint::ReadVarint(p, end, length)) return false;
+            if (length == 0) break;
+
+            uint32_t offset = 0;
+            if (!Varint::ReadVarint(p, end, offset)) return false;
+            if (offset == 0 || offset > out.size() || out.size() + length > expectedSize) return false;
+
+            size_t from = out.size() - offset;
+            for (uint32_t k = 0; k < length; k++) out.push_back(out[from + k]);
+        }
+        return p == end && out.size() == expectedSize;
+    }
+}
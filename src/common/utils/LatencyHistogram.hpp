@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Durations in nanoseconds, 8 buckets per power of two (percentiles within 12.5%) up to
+// ~68 s. One thread records and any thread may read at the same time: every counter is
+// a relaxed atomic, written without a read-modify-write since there is a single writer.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 3;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kMaxBits = 36;
+    static constexpr int kBuckets = (kMaxBits - kSubBits + 1) * kSub;
+
+    LatencyHistogram() {
+        for (auto& c : m_counts) c.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < (uint64_t)kSub) return (int)ns;
+        if (ns >> kMaxBits) return kBuckets - 1;
+        const int msb = 63 - __builtin_clzll(ns);
+        const int shift = msb - kSubBits;
+        return ((shift + 1) << kSubBits) + (int)((ns >> shift) & (kSub - 1));
+    }
+
+    // Largest value that lands in `bucket`.
+    static uint64_t upperBound(int bucket) {
+        if (bucket < kSub) return (uint64_t)bucket;
+        const int shift = (bucket >> kSubBits) - 1;
+        const uint64_t mantissa = (uint64_t)((bucket & (kSub - 1)) | kSub);
+        return (mantissa << shift) + ((uint64_t)1 << shift) - 1;
+    }
+
+    void record(uint64_t ns) {
+        bump(m_counts[bucketOf(ns)], 1);
+        bump(m_count, 1);
+        bump(m_sum, ns);
+        if (ns > m_max.load(std::memory_order_relaxed)) m_max.store(ns, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    uint64_t bucketCount(int bucket) const { return m_counts[bucket].load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the q-quantile (capped at the max), 0 when empty.
+    uint64_t percentile(double q) const {
+        const uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)(q * (double)n + 0.999999);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; b++) {
+            seen += bucketCount(b);
+            if (seen >= rank) return upperBound(b) < max() ? upperBound(b) : max();
+        }
+        return max();
+    }
+
+    // Adds `other` into this one; this histogram must have no other writer meanwhile.
+    void merge(const LatencyHistogram& other) {
+        for (int b = 0; b < kBuckets; b++) bump(m_counts[b], other.bucketCount(b));
+        bump(m_count, other.count());
+        bump(m_sum, other.sum());
+        if (other.max() > max()) m_max.store(other.max(), std::memory_order_relaxed);
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& counter, uint64_t by) {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> m_counts[kBuckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+};
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Structured asynchronous logging.
+//
+//   LOG_INFO("player_hit", "player", id, "hp", hp);
+//
+// records the event name, the key/value pairs (keys must be string literals) and a
+// timestamp into the calling thread's ring buffer. A background thread formats the
+// records as logfmt lines and writes them out every few milliseconds. The calling thread
+// never formats, never locks (after its first record) and never waits for the output:
+// when its ring is full the record is dropped and counted, and each call site is rate
+// limited to setSiteLimit() records per second.
+
+namespace Log {
+
+enum Level { LEVEL_DEBUG, LEVEL_INFO, LEVEL_WARN, LEVEL_ERROR, LEVEL_OFF };
+
+constexpr int kMaxFields = 6;
+constexpr size_t kTextBytes = 48;     // string values of one record share this, truncated
+constexpr size_t kRingRecords = 64;   // per thread; the service server has one per client
+constexpr auto kDrainInterval = std::chrono::milliseconds(10);
+
+enum FieldType : uint8_t { FIELD_INT, FIELD_UINT, FIELD_FLOAT, FIELD_BOOL, FIELD_TEXT };
+
+struct Field {
+    const char* key;
+    FieldType type;
+    uint8_t textOffset;
+    uint8_t textLength;
+    union {
+        int64_t i;
+        uint64_t u;
+        double f;
+    };
+};
+
+struct Record {
+    int64_t timeNs;        // system clock
+    const char* event;
+    Level level;
+    uint32_t suppressed;   // records this call site dropped to the rate limit before this one
+    uint8_t fieldCount;
+    uint8_t textUsed;
+    Field fields[kMaxFields];
+    char text[kTextBytes];
+};
+
+// Rate limit state of one LOG_* call site.
+struct Site {
+    std::atomic<int64_t> second{-1};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+// Single producer (the owning thread), single consumer (the writer).
+class Ring {
+public:
+    explicit Ring(uint32_t thread) : m_thread(thread) {}
+
+    Record* claim() {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= kRingRecords) {
+            m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &m_records[tail % kRingRecords];
+    }
+
+    void commit() { m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    bool pop(Record& out) {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        out = m_records[head % kRingRecords];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t thread() const { return m_thread; }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // Set by the owning thread as it exits; the writer frees the ring once it is empty.
+    std::atomic<bool> closed{false};
+    uint64_t droppedReported = 0;   // writer only
+
+private:
+    Record m_records[kRingRecords];
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<uint64_t> m_tail{0};
+    std::atomic<uint64_t> m_dropped{0};
+    uint32_t m_thread;
+};
+
+inline std::atomic<int>& minLevel() {
+    static std::atomic<int> level{LEVEL_INFO};
+    return level;
+}
+
+inline std::atomic<uint32_t>& siteLimit() {
+    static std::atomic<uint32_t> limit{20};
+    return limit;
+}
+
+inline bool enabled(Level level) { return (int)level >= minLevel().load(std::memory_order_relaxed); }
+inline void setLevel(Level level) { minLevel().store(level, std::memory_order_relaxed); }
+// Records per call site per second; 0 disables the limit.
+inline void setSiteLimit(uint32_t perSecond) { siteLimit().store(perSecond, std::memory_order_relaxed); }
+
+// "debug", "info", "warn", "error" or "off".
+inline bool parseLevel(const char* name, Level& out) {
+    static const char* const names[] = {"debug", "info", "warn", "error", "off"};
+    for (int i = 0; i <= LEVEL_OFF; i++) {
+        if (std::strcmp(name, names[i]) == 0) {
+            out = (Level)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+class Writer {
+public:
+    static Writer& instance() {
+        // Never destroyed: detached threads may still log while the process exits.
+        static Writer* writer = new Writer();
+        return *writer;
+    }
+
+    std::shared_ptr<Ring> registerThread() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto ring = std::make_shared<Ring>(++m_nextThread);
+        m_rings.push_back(ring);
+        if (!m_thread.joinable() && !m_stopped) {
+            m_running = true;
+            m_thread = std::thread(&Writer::run, this);
+            std::atexit([] { Writer::instance().shutdown(); });
+        }
+        return ring;
+    }
+
+    // Replaces the output (stderr by default). Takes ownership of `out` unless it is
+    // stdout or stderr.
+    void setOutput(std::FILE* out) {
+        std::lock_guard<std::mutex> lock(m_drainMutex);
+        if (m_out && m_out != stdout && m_out != stderr) std::fclose(m_out);
+        m_out = out;
+    }
+
+    // Writes everything logged so far. Blocks the caller; meant for shutdown paths.
+    void flush() { drain(); }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+            m_running = false;
+        }
+        m_wake.notify_all();
+        if (m_thread.joinable()) m_thread.join();
+        drain();
+        std::lock_guard<std::mutex> lock(m_drainMutex);
+        if (m_out) std::fflush(m_out);
+    }
+
+private:
+    std::mutex m_mutex;   // m_rings and the writer thread; producers only take it once
+    std::vector<std::shared_ptr<Ring>> m_rings;
+    uint32_t m_nextThread = 0;
+    std::thread m_thread;
+    std::condition_variable m_wake;
+    bool m_running = false;
+    bool m_stopped = false;
+
+    std::mutex m_drainMutex;   // output and the scratch buffers below
+    std::FILE* m_out = stderr;
+    std::vector<std::pair<uint32_t, Record>> m_batch;
+    std::string m_line;
+
+    Writer() = default;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_running) {
+            m_wake.wait_for(lock, kDrainInterval);
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+    void drain() {
+        std::vector<std::shared_ptr<Ring>> rings;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            rings = m_rings;
+        }
+
+        std::lock_guard<std::mutex> lock(m_drainMutex);
+        m_batch.clear();
+        Record record;
+        bool anyClosed = false;
+        for (auto& ring : rings) {
+            // Read before popping: a ring seen closed and then empty has nothing left to add.
+            anyClosed = ring->closed.load(std::memory_order_acquire) || anyClosed;
+            while (ring->pop(record)) m_batch.emplace_back(ring->thread(), record);
+
+            const uint64_t dropped = ring->dropped();
+            if (dropped != ring->droppedReported) {
+                Record note{};
+                note.timeNs = m_batch.empty() ? nowNs() : m_batch.back().second.timeNs;
+                note.event = "log_ring_full";
+                note.level = LEVEL_WARN;
+                note.fields[0].key = "dropped";
+                note.fields[0].type = FIELD_UINT;
+                note.fields[0].u = dropped - ring->droppedReported;
+                note.fieldCount = 1;
+                m_batch.emplace_back(ring->thread(), note);
+                ring->droppedReported = dropped;
+            }
+        }
+
+        if (!m_batch.empty() && m_out) {
+            std::stable_sort(m_batch.begin(), m_batch.end(),
+                             [](const std::pair<uint32_t, Record>& a, const std::pair<uint32_t, Record>& b) {
+                                 return a.second.timeNs < b.second.timeNs;
+                             });
+            m_line.clear();
+            for (const auto& entry : m_batch) format(entry.first, entry.second, m_line);
+            std::fwrite(m_line.data(), 1, m_line.size(), m_out);
+            std::fflush(m_out);
+        }
+
+        if (anyClosed) {
+            std::lock_guard<std::mutex> registry(m_mutex);
+            m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(),
+                                         [](const std::shared_ptr<Ring>& r) {
+                                             return r->closed.load(std::memory_order_acquire) && r->empty() &&
+                                                    r->dropped() == r->droppedReported;
+                                         }),
+                          m_rings.end());
+        }
+    }
+
+    static void format(uint32_t thread, const Record& r, std::string& out) {
+        static const char* const levels[] = {"DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+        char buf[96];
+        const time_t seconds = (time_t)(r.timeNs / 1000000000);
+        struct tm utc;
+        gmtime_r(&seconds, &utc);
+        const size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &utc);
+        std::snprintf(buf + n, sizeof(buf) - n, ".%06dZ %-5s t%u ", (int)(r.timeNs % 1000000000 / 1000),
+                      levels[r.level], thread);
+        out += buf;
+        out += r.event;
+
+        for (int i = 0; i < r.fieldCount; i++) {
+            const Field& f = r.fields[i];
+            out += ' ';
+            out += f.key;
+            out += '=';
+            switch (f.type) {
+                case FIELD_INT: std::snprintf(buf, sizeof(buf), "%lld", (long long)f.i); break;
+                case FIELD_UINT: std::snprintf(buf, sizeof(buf), "%llu", (unsigned long long)f.u); break;
+                case FIELD_FLOAT: std::snprintf(buf, sizeof(buf), "%.6g", f.f); break;
+                case FIELD_BOOL: std::snprintf(buf, sizeof(buf), "%s", f.u ? "true" : "false"); break;
+                case FIELD_TEXT: buf[0] = '\0'; appendText(r.text + f.textOffset, f.textLength, out); break;
+            }
+            out += buf;
+        }
+        if (r.suppressed) {
+            std::snprintf(buf, sizeof(buf), " suppressed=%u", r.suppressed);
+            out += buf;
+        }
+        out += '\n';
+    }
+
+    // Quoted when it would not read back as one logfmt value.
+    static void appendText(const char* text, size_t length, std::string& out) {
+        bool quote = length == 0;
+        for (size_t i = 0; i < length && !quote; i++) {
+            quote = text[i] == ' ' || text[i] == '=' || text[i] == '"' || (unsigned char)text[i] < 0x20;
+        }
+        if (!quote) {
+            out.append(text, length);
+            return;
+        }
+        out += '"';
+        for (size_t i = 0; i < length; i++) {
+            if (text[i] == '"' || text[i] == '\\') out += '\\';
+            out += ((unsigned char)text[i] < 0x20) ? ' ' : text[i];
+        }
+        out += '"';
+    }
+
+public:
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Marks the thread's ring closed when the thread exits.
+struct ThreadRing {
+    std::shared_ptr<Ring> ring;
+    ~ThreadRing() {
+        if (ring) ring->closed.store(true, std::memory_order_release);
+    }
+};
+
+inline Ring& threadRing() {
+    static thread_local ThreadRing mine;
+    if (!mine.ring) mine.ring = Writer::instance().registerThread();
+    return *mine.ring;
+}
+
+inline bool admit(Site& site, int64_t second, uint32_t& suppressed) {
+    const uint32_t limit = siteLimit().load(std::memory_order_relaxed);
+    if (limit == 0) {
+        suppressed = 0;
+        return true;
+    }
+    int64_t current = site.second.load(std::memory_order_relaxed);
+    if (current != second && site.second.compare_exchange_strong(current, second, std::memory_order_relaxed)) {
+        site.count.store(0, std::memory_order_relaxed);
+    }
+    if (site.count.fetch_add(1, std::memory_order_relaxed) >= limit) {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+inline Field& nextField(Record& r, const char* key, FieldType type) {
+    Field& f = r.fields[r.fieldCount++];
+    f.key = key;
+    f.type = type;
+    return f;
+}
+
+inline void addField(Record& r, const char* key, bool v) { nextField(r, key, FIELD_BOOL).u = v ? 1 : 0; }
+inline void addField(Record& r, const char* key, int v) { nextField(r, key, FIELD_INT).i = v; }
+inline void addField(Record& r, const char* key, long v) { nextField(r, key, FIELD_INT).i = v; }
+inline void addField(Record& r, const char* key, long long v) { nextField(r, key, FIELD_INT).i = v; }
+inline void addField(Record& r, const char* key, unsigned v) { nextField(r, key, FIELD_UINT).u = v; }
+inline void addField(Record& r, const char* key, unsigned long v) { nextField(r, key, FIELD_UINT).u = v; }
+inline void addField(Record& r, const char* key, unsigned long long v) { nextField(r, key, FIELD_UINT).u = v; }
+inline void addField(Record& r, const char* key, double v) { nextField(r, key, FIELD_FLOAT).f = v; }
+
+inline void addField(Record& r, const char* key, const char* v) {
+    Field& f = nextField(r, key, FIELD_TEXT);
+    const size_t length = std::min(v ? std::strlen(v) : 0, kTextBytes - r.textUsed);
+    if (length) std::memcpy(r.text + r.textUsed, v, length);
+    f.textOffset = r.textUsed;
+    f.textLength = (uint8_t)length;
+    r.textUsed = (uint8_t)(r.textUsed + length);
+}
+
+inline void addField(Record& r, const char* key, const std::string& v) { addField(r, key, v.c_str()); }
+
+inline void addFields(Record&) {}
+
+template <typename V, typename... Rest>
+void addFields(Record& r, const char* key, const V& value, const Rest&... rest) {
+    if (r.fieldCount < kMaxFields) addField(r, key, value);
+    addFields(r, rest...);
+}
+
+template <typename... Fields>
+void write(Level level, Site& site, const char* event, const Fields&... fields) {
+    static_assert(sizeof...(Fields) % 2 == 0, "log fields are key/value pairs");
+    const int64_t now = Writer::nowNs();
+    uint32_t suppressed = 0;
+    if (!admit(site, now / 1000000000, suppressed)) return;
+
+    Ring& ring = threadRing();
+    Record* r = ring.claim();
+    if (!r) return;
+    r->timeNs = now;
+    r->event = event;
+    r->level = level;
+    r->suppressed = suppressed;
+    r->fieldCount = 0;
+    r->textUsed = 0;
+    addFields(*r, fields...);
+    ring.commit();
+}
+
+inline bool openFile(const char* path) {
+    std::FILE* out = std::fopen(path, "a");
+    if (!out) return false;
+    Writer::instance().setOutput(out);
+    return true;
+}
+
+inline void flush() { Writer::instance().flush(); }
+
+}
+
+// The first argument is the event name, then key/value pairs.
+#define LOG_AT(level, ...)                                           \
+    do {                                                             \
+        static ::Log::Site logSite_;                                 \
+        if (::Log::enabled(level)) ::Log::write(level, logSite_, __VA_ARGS__); \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(::Log::LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(::Log::LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(::Log::LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(::Log::LEVEL_ERROR, __VA_ARGS__)
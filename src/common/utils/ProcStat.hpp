@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+// Readers for /proc/<pid>/stat, used by the load tools to measure the servers they drive.
+namespace ProcStat {
+    // utime + stime of a process in seconds, or < 0 if it cannot be read.
+    inline double CpuSeconds(pid_t pid) {
+        std::ifstream in("/proc/" + std::to_string(pid) + "/stat");
+        std::string stat((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        const size_t paren = stat.rfind(')');
+        if (paren == std::string::npos || paren + 2 > stat.size()) return -1.0;
+
+        // Fields after "(comm)": state is field 3, utime and stime are fields 14 and 15.
+        std::istringstream fields(stat.substr(paren + 2));
+        std::string field;
+        unsigned long long utime = 0, stime = 0;
+        for (int i = 3; i <= 15 && fields >> field; i++) {
+            if (i == 14) utime = std::strtoull(field.c_str(), nullptr, 10);
+            if (i == 15) stime = std::strtoull(field.c_str(), nullptr, 10);
+        }
+        return (double)(utime + stime) / (double)sysconf(_SC_CLK_TCK);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+// Smoothed round trip time, jitter and remote clock offset from ping/pong exchanges
+// (REQ_INGAME_PING / RES_INGAME_PONG). Smoothing follows RFC 6298: srtt moves 1/8 and the
+// jitter (rttvar) 1/4 of the way toward each sample. The offset is the responder's clock
+// minus ours, assuming the reply was sent halfway through the round trip; samples slower
+// than the smoothed RTT queued somewhere on one leg, so they do not move it.
+//
+// One thread adds samples; any thread may read.
+class RttEstimator {
+public:
+    // sentUs and receivedUs are on our clock, remoteUs on the responder's.
+    void addSample(int64_t sentUs, int64_t receivedUs, int64_t remoteUs) {
+        const int64_t rtt = receivedUs - sentUs;
+        if (rtt < 0) return;
+        const int64_t offset = remoteUs - (sentUs + rtt / 2);
+
+        const uint64_t n = m_samples.load(std::memory_order_relaxed);
+        int64_t srtt = m_srttUs.load(std::memory_order_relaxed);
+        int64_t rttvar = m_rttvarUs.load(std::memory_order_relaxed);
+        if (n == 0) {
+            srtt = rtt;
+            rttvar = rtt / 2;
+            m_offsetUs.store(offset, std::memory_order_relaxed);
+        } else {
+            rttvar += (std::llabs(srtt - rtt) - rttvar) / 4;
+            if (rtt <= srtt) {
+                const int64_t current = m_offsetUs.load(std::memory_order_relaxed);
+                m_offsetUs.store(current + (offset - current) / 8, std::memory_order_relaxed);
+            }
+            srtt += (rtt - srtt) / 8;
+        }
+        m_lastRttUs.store(rtt, std::memory_order_relaxed);
+        m_srttUs.store(srtt, std::memory_order_relaxed);
+        m_rttvarUs.store(rttvar, std::memory_order_relaxed);
+        m_samples.store(n + 1, std::memory_order_relaxed);
+    }
+
+    bool hasSample() const { return samples() > 0; }
+    uint64_t samples() const { return m_samples.load(std::memory_order_relaxed); }
+    int64_t lastRttUs() const { return m_lastRttUs.load(std::memory_order_relaxed); }
+    int64_t srttUs() const { return m_srttUs.load(std::memory_order_relaxed); }
+    int64_t jitterUs() const { return m_rttvarUs.load(std::memory_order_relaxed); }
+    // Add to our clock to get the remote one.
+    int64_t clockOffsetUs() const { return m_offsetUs.load(std::memory_order_relaxed); }
+
+    // srtt + 4 * rttvar (RFC 6298's RTO), never below minUs; minUs before any sample.
+    int64_t timeoutUs(int64_t minUs) const {
+        if (!hasSample()) return minUs;
+        const int64_t rto = srttUs() + 4 * jitterUs();
+        return rto > minUs ? rto : minUs;
+    }
+
+private:
+    std::atomic<uint64_t> m_samples{0};
+    std::atomic<int64_t> m_lastRttUs{0};
+    std::atomic<int64_t> m_srttUs{0};
+    std::atomic<int64_t> m_rttvarUs{0};
+    std::atomic<int64_t> m_offsetUs{0};
+};
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// Opt-in span tracing in the Chrome trace event format (chrome://tracing, Perfetto).
+//
+//   Trace::start("server.trace.json", "ingame_server");
+//   { Trace::Span span("room_tick", "server"); span.arg("tick", tick); ... }
+//   Trace::stop();   // writes the file
+//
+// Spans and flow events go into a fixed-size buffer owned by the recording thread, so
+// recording takes no lock and never allocates after the thread's first event. With
+// tracing off every call is one relaxed load. Timestamps are steady_clock microseconds,
+// which on Linux is CLOCK_MONOTONIC and therefore comparable between the client and the
+// server when both run on one host. To look at both sides together, merge the files:
+//
+//   jq -s '{traceEvents: map(.traceEvents) | add}' client.json server.json > merged.json
+//
+// Flows link an input from the client's send to the tick that applied it
+// (inputFlowId, keyed by ReqIngameInput.seq) and a snapshot from the broadcast to its
+// arrival at the client (snapshotFlowId, keyed by ResIngameState.tick).
+
+namespace Trace {
+
+// Per thread; ~20 events per client frame fill this in about 15 minutes. Pages are only
+// touched as they are used.
+constexpr size_t kThreadEvents = 1 << 20;
+constexpr int kMaxArgs = 2;
+
+struct Event {
+    int64_t ts;            // us
+    int64_t dur;           // us, complete events only
+    const char* name;      // names, categories and arg keys must be string literals
+    const char* cat;
+    char phase;            // 'X' span, 's'/'t'/'f' flow start/step/end
+    uint8_t argCount;
+    uint64_t id;           // flows only
+    const char* argNames[kMaxArgs];
+    int64_t args[kMaxArgs];
+};
+
+// Written by its thread only; stop() reads the first `count` events.
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    const char* name = nullptr;
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+    std::unique_ptr<Event[]> events{new Event[kThreadEvents]};
+};
+
+struct State {
+    std::atomic<bool> enabled{false};
+    std::mutex mutex;   // everything below
+    std::string path;
+    std::string processName;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint32_t nextTid = 0;
+};
+
+inline State& state() {
+    // Never destroyed: detached threads may still trace while the process exits.
+    static State* s = new State();
+    return *s;
+}
+
+inline bool enabled() { return state().enabled.load(std::memory_order_relaxed); }
+
+inline int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline ThreadBuffer& threadBuffer() {
+    static thread_local std::shared_ptr<ThreadBuffer> mine;
+    if (!mine) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(state().mutex);
+        buffer->tid = ++state().nextTid;
+        state().buffers.push_back(buffer);
+        mine = buffer;
+    }
+    return *mine;
+}
+
+inline Event* claim() {
+    ThreadBuffer& buffer = threadBuffer();
+    const size_t n = buffer.count.load(std::memory_order_relaxed);
+    if (n >= kThreadEvents) {
+        buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &buffer.events[n];
+}
+
+inline void commit() {
+    ThreadBuffer& buffer = threadBuffer();
+    buffer.count.store(buffer.count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Shown as the thread's row label. Call from the thread itself; `name` must be a literal.
+inline void setThreadName(const char* name) {
+    if (enabled()) threadBuffer().name = name;
+}
+
+inline void flow(char phase, const char* name, uint64_t id) {
+    if (!enabled()) return;
+    Event* e = claim();
+    if (!e) return;
+    e->ts = nowUs();
+    e->dur = 0;
+    e->name = name;
+    e->cat = "flow";
+    e->phase = phase;
+    e->argCount = 0;
+    e->id = id;
+    commit();
+}
+
+// Flow events attach to the span that is open on the calling thread at the time.
+inline void flowStart(const char* name, uint64_t id) { flow('s', name, id); }
+inline void flowStep(const char* name, uint64_t id) { flow('t', name, id); }
+inline void flowEnd(const char* name, uint64_t id) { flow('f', name, id); }
+
+// Seqs are per connection and ticks are shared by every client, so both ids carry the
+// player; the top bit keeps the two kinds apart.
+inline uint64_t inputFlowId(uint32_t playerId, uint32_t seq) { return ((uint64_t)playerId << 32) | seq; }
+inline uint64_t snapshotFlowId(uint32_t playerId, uint32_t tick) {
+    return ((uint64_t)1 << 63) | ((uint64_t)playerId << 32) | tick;
+}
+
+// A complete ('X') event from construction to destruction, recorded only if tracing was
+// on when it opened.
+class Span {
+public:
+    Span(const char* name, const char* cat) : m_name(name), m_cat(cat), m_start(enabled() ? nowUs() : -1) {}
+    ~Span() { stop(); }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    bool active() const { return m_start >= 0; }
+
+    void arg(const char* key, int64_t value) {
+        if (!active() || m_argCount >= kMaxArgs) return;
+        m_argNames[m_argCount] = key;
+        m_args[m_argCount++] = value;
+    }
+
+    void stop() {
+        if (!active()) return;
+        Event* e = claim();
+        if (e) {
+            e->ts = m_start;
+            e->dur = nowUs() - m_start;
+            e->name = m_name;
+            e->cat = m_cat;
+            e->phase = 'X';
+            e->argCount = (uint8_t)m_argCount;
+            e->id = 0;
+            for (int i = 0; i < m_argCount; i++) {
+                e->argNames[i] = m_argNames[i];
+                e->args[i] = m_args[i];
+            }
+            commit();
+        }
+        m_start = -1;
+    }
+
+private:
+    const char* m_name;
+    const char* m_cat;
+    int64_t m_start;
+    int m_argCount = 0;
+    const char* m_argNames[kMaxArgs];
+    int64_t m_args[kMaxArgs];
+};
+
+// Starts recording; stop() writes everything to `path`. Only one trace per process.
+inline void start(const std::string& path, const std::string& processName) {
+    State& s = state();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.path = path;
+        s.processName = processName;
+    }
+    s.enabled.store(true, std::memory_order_relaxed);
+}
+
+// Stops recording and writes the trace. Threads that are still running may add a few
+// events meanwhile; those past the count read here are left out.
+inline bool stop() {
+    State& s = state();
+    if (!s.enabled.exchange(false, std::memory_order_relaxed)) return true;
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::FILE* out = std::fopen(s.path.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "Trace: cannot write %s\n", s.path.c_str());
+        return false;
+    }
+
+    const int pid = (int)getpid();
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"%s\"}}",
+                 pid, s.processName.c_str());
+
+    uint64_t written = 0, dropped = 0;
+    for (const auto& buffer : s.buffers) {
+        if (buffer->name) {
+            std::fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         pid, buffer->tid, buffer->name);
+        }
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const Event& e = buffer->events[i];
+            std::fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":%d,\"tid\":%u,\"ts\":%lld",
+                         e.name, e.cat, e.phase, pid, buffer->tid, (long long)e.ts);
+            if (e.phase == 'X') {
+                std::fprintf(out, ",\"dur\":%lld", (long long)e.dur);
+            } else {
+                // Ends bind to the enclosing span rather than the next one to start.
+                std::fprintf(out, ",\"id\":\"0x%llx\"%s", (unsigned long long)e.id, e.phase == 'f' ? ",\"bp\":\"e\"" : "");
+            }
+            if (e.argCount > 0) {
+                std::fprintf(out, ",\"args\":{");
+                for (int a = 0; a < e.argCount; a++) {
+                    std::fprintf(out, "%s\"%s\":%lld", a ? "," : "", e.argNames[a], (long long)e.args[a]);
+                }
+                std::fprintf(out, "}");
+            }
+            std::fprintf(out, "}");
+        }
+        written += count;
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    std::fprintf(out, "\n]}\n");
+    std::fclose(out);
+
+    std::fprintf(stderr, "Trace: wrote %llu events to %s", (unsigned long long)written, s.path.c_str());
+    if (dropped) std::fprintf(stderr, " (%llu dropped, buffers full)", (unsigned long long)dropped);
+    std::fprintf(stderr, "\n");
+    return true;
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands the newest value from one producer thread to one consumer thread without locks.
+// Three slots: the producer fills its back slot and publish() swaps it with the middle
+// one; the consumer's update() swaps its front slot with the middle one if something new
+// was published since. Neither side ever waits for the other or copies a value, and
+// values published faster than they are taken replace each other.
+//
+//   producer:  T& slot = buffer.writeBuffer(); fill(slot); buffer.publish();
+//   consumer:  if (buffer.update()) use(buffer.read());
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer side. The slot is the producer's until publish(); it holds stale data.
+    T& writeBuffer() { return m_slots[m_back]; }
+
+    void publish() {
+        const uint8_t previous = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel);
+        m_back = previous & kIndexMask;
+    }
+
+    // Consumer side. Takes the newest published value if there is one; read() keeps
+    // returning it until the next update() that returns true.
+    bool update() {
+        if (!(m_middle.load(std::memory_order_relaxed) & kFresh)) return false;
+        const uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & kIndexMask;
+        return true;
+    }
+
+    const T& read() const { return m_slots[m_front]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 3;
+    static constexpr uint8_t kFresh = 4;   // middle slot holds a value the consumer has not taken
+
+    T m_slots[3] = {};
+    // Each index on its own cache line so the two threads do not share one.
+    alignas(64) std::atomic<uint8_t> m_middle{1};
+    alignas(64) uint8_t m_back = 0;    // producer only
+    alignas(64) uint8_t m_front = 2;   // consumer only
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// LEB128-style unsigned varints shared by the replay container and the terrain
+// diff stream: 7 bits per byte, high bit set on every byte but the last.
+namespace Varint {
+    inline void WriteVarint(std::vector<char>& out, uint32_t v) {
+        while (v >= 0x80) {
+            out.push_back((char)((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        out.push_back((char)v);
+    }
+
+    inline bool ReadVarint(const unsigned char*& p, const unsigned char* end, uint32_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (p >= end) return false;
+            const unsigned char byte = *p++;
+            v |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one deque per worker.
+// Workers pop their own tasks LIFO (cache-warm) and steal FIFO from the others when
+// they run dry. Tasks submitted from inside a worker go to that worker's deque;
+// tasks submitted from outside are spread round-robin.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threadCount = 0)
+        : m_stopping(false), m_queued(0), m_pending(0), m_nextQueue(0) {
+        if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+
+        for (size_t i = 0; i < threadCount; i++) {
+            m_queues.emplace_back(new Queue());
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            m_threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto& t : m_threads) {
+            if (t.joinable()) t.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t size() const { return m_threads.size(); }
+
+    void submit(std::function<void()> task) {
+        size_t index;
+        if (t_pool == this) {
+            index = t_index;
+        } else {
+            index = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        }
+
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+            m_queues[index]->tasks.push_back(std::move(task));
+        }
+        m_queued.fetch_add(1, std::memory_order_release);
+
+        { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+        m_wake.notify_one();
+    }
+
+    // Blocks until every submitted task (including tasks they submit) has finished.
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_idle.wait(lock, [this] { return m_pending.load(std::memory_order_acquire) == 0; });
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool popLocal(size_t index, std::function<void()>& out) {
+        Queue& q = *m_queues[index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) return false;
+        out = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, std::function<void()>& out) {
+        const size_t count = m_queues.size();
+        for (size_t i = 1; i < count; i++) {
+            Queue& q = *m_queues[(thief + i) % count];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty()) continue;
+            out = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index) {
+        t_pool = this;
+        t_index = index;
+
+        while (true) {
+            std::function<void()> task;
+            if (popLocal(index, task) || steal(index, task)) {
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                task();
+                if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+                    m_idle.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this] {
+                return m_stopping || m_queued.load(std::memory_order_acquire) > 0;
+            });
+            if (m_stopping && m_queued.load(std::memory_order_acquire) == 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    bool m_stopping;
+    std::atomic<size_t> m_queued;
+    std::atomic<size_t> m_pending;
+    std::atomic<size_t> m_nextQueue;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+
+    static inline thread_local WorkStealingPool* t_pool = nullptr;
+    static inline thread_local size_t t_index = 0;
+};
@@ -0,0 +1,483 @@
+#include "core/GameServer.hpp"
+#include "logic/GameRoom.hpp"
+#include "logic/MapGenerator.hpp"
+#include "logic/MapLoader.hpp"
+#include "logic/PhysicsEngine.hpp"
+#include "logic/TerrainDiff.hpp"
+#include "../common/network/Packet.hpp"
+#include "../common/network/PacketStructs.hpp"
+#include "../common/network/PacketUtils.hpp"
+#include "../common/utils/Log.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Micro-benchmarks for the per-tick hot paths: packet (de)serialisation, terrain
+// loading/queries/explosions, the physics step and state snapshot encoding.
+//
+// Usage: micro_bench [--filter SUBSTR] [--min-time SECONDS] [--repeat N] [--out FILE]
+//
+// Each benchmark is calibrated to run for at least --min-time, then measured --repeat
+// times; the median ns/op is the headline number. Results are written as JSON (to
+// stdout unless --out is given) so runs can be diffed against a baseline.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    std::string filter;
+    double minTime = 0.2;
+    int repeat = 5;
+    std::string outPath;
+};
+
+// Passed to every benchmark body. Setup that must not be measured goes between
+// pause() and resume().
+class BenchState {
+public:
+    explicit BenchState(uint64_t iterations) : m_iterations(iterations), m_paused(0) {}
+
+    uint64_t iterations() const { return m_iterations; }
+    void pause() { m_pauseStart = Clock::now(); }
+    void resume() { m_paused += Clock::now() - m_pauseStart; }
+    Clock::duration paused() const { return m_paused; }
+
+    // Bytes produced per operation, reported alongside the timing when non-zero.
+    uint64_t bytesPerOp = 0;
+
+private:
+    uint64_t m_iterations;
+    Clock::duration m_paused;
+    Clock::time_point m_pauseStart;
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(BenchState&)> body;
+};
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations = 0;
+    double nsPerOp = 0.0; // median of the repeats
+    double minNsPerOp = 0.0;
+    double maxNsPerOp = 0.0;
+    uint64_t bytesPerOp = 0;
+};
+
+// Keeps the compiler from discarding a result that is otherwise unused.
+template <typename T>
+inline void KeepAlive(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+double RunOnce(const Benchmark& bench, uint64_t iterations, uint64_t& bytesPerOp) {
+    BenchState state(iterations);
+    const auto start = Clock::now();
+    bench.body(state);
+    const auto elapsed = Clock::now() - start - state.paused();
+    bytesPerOp = state.bytesPerOp;
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+BenchResult Measure(const Benchmark& bench, const BenchConfig& config) {
+    BenchResult result;
+    result.name = bench.name;
+
+    // Grow the iteration count until one run takes at least minTime.
+    uint64_t iterations = 1;
+    for (;;) {
+        const double seconds = RunOnce(bench, iterations, result.bytesPerOp);
+        if (seconds >= config.minTime || iterations >= (1ull << 40)) break;
+        const double scale = (seconds > 0.0) ? config.minTime * 1.4 / seconds : 100.0;
+        iterations = std::max(iterations + 1, (uint64_t)(iterations * std::min(scale, 100.0)));
+    }
+    result.iterations = iterations;
+
+    std::vector<double> samples;
+    for (int r = 0; r < config.repeat; r++) {
+        samples.push_back(RunOnce(bench, iterations, result.bytesPerOp) * 1e9 / (double)iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    result.nsPerOp = samples[samples.size() / 2];
+    result.minNsPerOp = samples.front();
+    result.maxNsPerOp = samples.back();
+    return result;
+}
+
+std::string JsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+std::string ToJson(const std::vector<BenchResult>& results, const BenchConfig& config) {
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::ostringstream out;
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"compiler\": \"" << JsonEscape(__VERSION__) << "\",\n"
+        << "    \"min_time_s\": " << config.minTime << ",\n"
+        << "    \"repeat\": " << config.repeat << "\n"
+        << "  },\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        char line[512];
+        std::snprintf(line, sizeof(line),
+                      "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, "
+                      "\"min_ns_per_op\": %.2f, \"max_ns_per_op\": %.2f, \"bytes_per_op\": %llu}%s\n",
+                      JsonEscape(r.name).c_str(), (unsigned long long)r.iterations, r.nsPerOp,
+                      r.minNsPerOp, r.maxNsPerOp, (unsigned long long)r.bytesPerOp,
+                      (i + 1 < results.size()) ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+// --- Fixtures -------------------------------------------------------------------------
+
+std::vector<std::string> MapFiles() {
+    std::vector<std::string> paths;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("assets/maps", ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Points scattered around the ground surface, where shots actually land.
+std::vector<std::pair<float, float>> SurfacePoints(const MapLoader& map, size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::pair<float, float>> points;
+    while (points.size() < count) {
+        const float x = (float)(rng() % (uint32_t)map.getWidth());
+        float y = 0.0f;
+        while (y < map.getHeight() && !map.isSolid(x, y)) y += 1.0f;
+        if (y >= map.getHeight()) continue;
+        points.push_back({x, y + (float)(rng() % 21) - 10.0f});
+    }
+    return points;
+}
+
+ResIngameState SampleSnapshot() {
+    ResIngameState s{};
+    s.matchId = 1;
+    s.tick = 12345;
+    s.roomState = (uint32_t)FIRING_PHASE;
+    s.turnTimer = 7.5f;
+    s.playerCount = INGAME_MAX_PLAYERS;
+    for (int i = 0; i < INGAME_MAX_PLAYERS; i++) {
+        s.players[i].id = (uint32_t)i;
+        s.players[i].hp = 100;
+        s.players[i].isAlive = 1;
+        s.players[i].x = 100.0f + 200.0f * i;
+        s.players[i].y = 400.0f;
+    }
+    s.projectileCount = 1;
+    s.projectiles[0].isActive = 1;
+    return s;
+}
+
+std::vector<Projectile> Salvo(const MapLoader& map, size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<Projectile> projectiles;
+    for (size_t i = 0; i < count; i++) {
+        Position from{(float)(64 + rng() % (uint32_t)(map.getWidth() - 128)), 200.0f, (rng() & 1) != 0};
+        projectiles.push_back(PhysicsEngine::launchProjectile(from, (float)(30 + rng() % 60), (float)(20 + rng() % 60)));
+    }
+    return projectiles;
+}
+
+std::vector<Benchmark> Benchmarks() {
+    std::vector<Benchmark> benches;
+
+    // Packets: the state snapshot is the largest packet sent every tick.
+    benches.push_back({"packet/set_payload/state", [](BenchState& state) {
+        const ResIngameState snapshot = SampleSnapshot();
+        Packet packet(PacketType::RES_INGAME_STATE);
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            packet.SetPayload(snapshot);
+            KeepAlive(packet.payload.data());
+        }
+        state.bytesPerOp = packet.payload.size();
+    }});
+    benches.push_back({"packet/get_payload/state", [](BenchState& state) {
+        Packet packet(PacketType::RES_INGAME_STATE);
+        packet.SetPayload(SampleSnapshot());
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            const ResIngameState s = packet.GetPayload<ResIngameState>();
+            KeepAlive(s.tick);
+        }
+    }});
+    benches.push_back({"packet/serialize/state", [](BenchState& state) {
+        Packet packet(PacketType::RES_INGAME_STATE);
+        packet.SetPayload(SampleSnapshot());
+        std::vector<char> buffer;
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            PacketUtils::SerializePacket(packet, buffer);
+            KeepAlive(buffer.data());
+        }
+        state.bytesPerOp = buffer.size();
+    }});
+    benches.push_back({"packet/deserialize/state", [](BenchState& state) {
+        Packet packet(PacketType::RES_INGAME_STATE);
+        packet.SetPayload(SampleSnapshot());
+        std::vector<char> buffer;
+        PacketUtils::SerializePacket(packet, buffer);
+        Packet out;
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            const bool ok = PacketUtils::DeserializePacket(buffer, out);
+            KeepAlive(ok);
+        }
+        state.bytesPerOp = buffer.size();
+    }});
+    benches.push_back({"packet/serialize/input", [](BenchState& state) {
+        ReqIngameInput input{};
+        input.command = INGAME_CMD_MOVE_LEFT;
+        std::vector<char> buffer;
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            Packet packet(PacketType::REQ_INGAME_INPUT);
+            input.seq = (uint32_t)i;
+            packet.SetPayload(input);
+            PacketUtils::SerializePacket(packet, buffer);
+            KeepAlive(buffer.data());
+        }
+        state.bytesPerOp = buffer.size();
+    }});
+
+    // Terrain.
+    for (const std::string& path : MapFiles()) {
+        const std::string name = std::filesystem::path(path).stem().string();
+        benches.push_back({"map/load/" + name, [path](BenchState& state) {
+            for (uint64_t i = 0; i < state.iterations(); i++) {
+                MapLoader map;
+                const bool ok = map.loadMap(path, 1);
+                KeepAlive(ok);
+            }
+        }});
+    }
+    for (const char* name : {"procedural", "procedural:8192x4096"}) {
+        benches.push_back({std::string("map/generate/") + name, [name](BenchState& state) {
+            MapLoader map;
+            for (uint64_t i = 0; i < state.iterations(); i++) {
+                MapGenerator::Load(map, name, (uint32_t)i);
+                KeepAlive(map.getTerrainHash());
+            }
+        }});
+    }
+    benches.push_back({"map/is_solid", [](BenchState& state) {
+        MapLoader map;
+        MapGenerator::Load(map, MapGenerator::kMapName, 1);
+        std::mt19937 rng(1);
+        std::vector<std::pair<float, float>> points(4096);
+        for (auto& p : points) p = {(float)(rng() % 1400) - 60.0f, (float)(rng() % 800) - 40.0f};
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            const auto& p = points[i & 4095];
+            const bool solid = map.isSolid(p.first, p.second);
+            KeepAlive(solid);
+        }
+    }});
+    // Cells to RGBA as the client's map texture refresh does: the whole map, and the
+    // region one explosion dirties.
+    for (int radius : {0, 30}) {
+        const std::string name = radius ? "r" + std::to_string(radius) : std::string("full");
+        benches.push_back({"map/expand_rows/" + name, [radius](BenchState& state) {
+            MapLoader map;
+            MapGenerator::Load(map, MapGenerator::kMapName, 1);
+            TerrainRect rect{0, 0, map.getWidth(), map.getHeight()};
+            if (radius) {
+                const auto points = SurfacePoints(map, 1, 5);
+                const int x = std::max((int)points[0].first - radius, 0);
+                const int y = std::max((int)points[0].second - radius, 0);
+                rect = {x, y, std::min(2 * radius + 1, map.getWidth() - x), std::min(2 * radius + 1, map.getHeight() - y)};
+            }
+            std::vector<uint32_t> pixels((size_t)rect.w * rect.h);
+            for (uint64_t i = 0; i < state.iterations(); i++) {
+                for (int y = 0; y < rect.h; y++) {
+                    map.expandRow(rect.y + y, rect.x, rect.w, 0x3C280DFF, 0x00000000, &pixels[(size_t)y * rect.w]);
+                }
+                KeepAlive(pixels.data());
+            }
+            state.bytesPerOp = pixels.size() * sizeof(uint32_t);
+        }});
+    }
+    for (float radius : {30.0f, 90.0f}) {
+        benches.push_back({"map/explosion/r" + std::to_string((int)radius), [radius](BenchState& state) {
+            MapLoader pristine;
+            MapGenerator::Load(pristine, MapGenerator::kMapName, 1);
+            const auto points = SurfacePoints(pristine, 64, 2);
+            MapLoader map = pristine;
+            for (uint64_t i = 0; i < state.iterations(); i++) {
+                // Restore the terrain once every point has been hit.
+                if (i % points.size() == 0) {
+                    state.pause();
+                    map = pristine;
+                    map.clearDirtyRects();
+                    state.resume();
+                }
+                const auto& p = points[i % points.size()];
+                map.applyExplosion(p.first, p.second, radius);
+            }
+        }});
+    }
+
+    // Physics: one fixed step with N projectiles in flight and two players, one of them walking.
+    for (size_t count : {0, 1, 8, 64, 256}) {
+        benches.push_back({"physics/update/projectiles:" + std::to_string(count), [count](BenchState& state) {
+            MapLoader pristine;
+            MapGenerator::Load(pristine, MapGenerator::kMapName, 1);
+            const std::vector<Projectile> salvo = Salvo(pristine, count, 3);
+            const auto& spawns = pristine.getSpawnPoints();
+
+            PhysicsEngine physics;
+            MapLoader map;
+            std::vector<Projectile> projectiles;
+            std::vector<Player*> players;
+            for (int p = 0; p < 2; p++) {
+                players.push_back(new Player(p, "Bench", spawns[p % spawns.size()].x, spawns[p % spawns.size()].y, true));
+            }
+
+            constexpr uint64_t kStepsPerVolley = 32;
+            for (uint64_t i = 0; i < state.iterations(); i++) {
+                if (i % kStepsPerVolley == 0) {
+                    state.pause();
+                    map = pristine;
+                    projectiles = salvo;
+                    players[0]->moveRight();
+                    state.resume();
+                }
+                physics.update(1.0f / 60.0f, players, projectiles, &map);
+            }
+            for (auto* p : players) delete p;
+        }});
+    }
+
+    // Snapshot: what BroadcastStateSnapshot does per tick and then per client.
+    benches.push_back({"snapshot/build", [](BenchState& state) {
+        MapLoader map;
+        MapGenerator::Load(map, MapGenerator::kMapName, 1);
+        std::vector<Player*> players;
+        for (int p = 0; p < INGAME_MAX_PLAYERS; p++) players.push_back(new Player(p, "Bench", 100.0f + 200.0f * p, 100.0f, true));
+        GameRoom room(players);
+        room.setMapLoader(&map);
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            ResIngameState snapshot{};
+            GameServer::FillStateSnapshot(&room, players, snapshot);
+            KeepAlive(snapshot.playerCount);
+        }
+        for (auto* p : players) delete p;
+    }});
+    benches.push_back({"snapshot/encode", [](BenchState& state) {
+        const ResIngameState snapshot = SampleSnapshot();
+        size_t bytes = 0;
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            // PacketUtils::SendPacket minus the socket write.
+            Packet packet(PacketType::RES_INGAME_STATE);
+            packet.SetPayload(snapshot);
+            std::vector<char> buffer;
+            PacketUtils::SerializePacket(packet, buffer);
+            bytes = buffer.size();
+            KeepAlive(buffer.data());
+        }
+        state.bytesPerOp = bytes;
+    }});
+    benches.push_back({"snapshot/terrain_diff", [](BenchState& state) {
+        MapLoader pristine;
+        MapGenerator::Load(pristine, MapGenerator::kMapName, 1);
+        const auto points = SurfacePoints(pristine, 64, 4);
+        MapLoader map;
+        std::vector<TerrainRect> rects;
+        std::vector<char> encoded;
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            state.pause();
+            if (i % points.size() == 0) map = pristine;
+            const auto& p = points[i % points.size()];
+            map.clearDirtyRects();
+            map.applyExplosion(p.first, p.second, 30.0f);
+            rects.clear();
+            map.drainDirtyRects(rects);
+            state.resume();
+
+            encoded.clear();
+            TerrainDiff::Encode(map, rects, encoded);
+            KeepAlive(encoded.data());
+        }
+        state.bytesPerOp = encoded.size();
+    }});
+
+    return benches;
+}
+
+bool ParseArgs(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            config.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            config.minTime = std::max(0.001, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && hasValue) {
+            config.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            config.outPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter SUBSTR] [--min-time SECONDS] [--repeat N] [--out FILE]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!ParseArgs(argc, argv, config)) return 1;
+
+    // The physics step logs hits and wind changes; keep that out of the measurements.
+    Log::setLevel(Log::LEVEL_OFF);
+
+    std::vector<BenchResult> results;
+    for (const Benchmark& bench : Benchmarks()) {
+        if (!config.filter.empty() && bench.name.find(config.filter) == std::string::npos) continue;
+        results.push_back(Measure(bench, config));
+        const BenchResult& r = results.back();
+        std::fprintf(stderr, "%-36s %14.1f ns/op %12llu iters\n", r.name.c_str(), r.nsPerOp, (unsigned long long)r.iterations);
+    }
+
+    std::cout.clear();
+    std::cerr.clear();
+    const std::string json = ToJson(results, config);
+    if (config.outPath.empty()) {
+        std::cout << json;
+        return 0;
+    }
+
+    std::ofstream out(config.outPath);
+    if (!out || !(out << json)) {
+        std::cerr << "micro_bench: failed to write " << config.outPath << std::endl;
+        return 1;
+    }
+    std::fprintf(stderr, "wrote %s\n", config.outPath.c_str());
+    return 0;
+}
@@ -2,32 +2,55 @@
 
 #include "../../common/network/PacketUtils.hpp"
 #include "../../common/network/PacketStructs.hpp"
+#include "../logic/MapGenerator.hpp"
+#include "../logic/TerrainDiff.hpp"
+#include "../../common/utils/LZ.hpp"
+#include "../../common/utils/Log.hpp"
+#include "../../common/utils/Trace.hpp"
 
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <random>
 #include <thread>
 
 namespace {
-constexpr const char* kDefaultMap = "assets/maps/flatmap.txt";
+constexpr const char* kDefaultMap = MapGenerator::kMapName;
+constexpr const char* kRecordingDir = "replays";
+constexpr float kTickSeconds = 1.0f / 60.0f;
+constexpr float kDefaultBotFillSeconds = 15.0f;
+// One terrain snapshot chunk per client per tick keeps a full sync from delaying
+// the state snapshot behind it.
+constexpr size_t kTerrainChunkBytes = 8 * 1024;
+// Snapshots carry the terrain root hash once a second.
+constexpr uint32_t kTerrainHashInterval = 60;
+// Per-turn search budget; the solver runs off the tick thread, so this bounds how
+// long the bot "thinks", not how long a tick takes.
+constexpr std::chrono::milliseconds kBotSolveBudget(50);
+constexpr const char* kDefaultOverrunLog = "tick_overruns.log";
+// A stalled machine overruns every tick; keep the log readable.
+constexpr uint32_t kMaxOverrunLogsPerSecond = 10;
+constexpr int64_t kPingIntervalUs = 1000000;
+// A connection that answered pings before and then stays silent this long (or four
+// RTOs, if more) is shut down; its seat stays open for a reconnect.
+constexpr int64_t kMinPongTimeoutUs = 5000000;
 
-const char* CommandToString(uint32_t command) {
-    switch (command) {
-        case INGAME_CMD_MOVE_LEFT:
-            return "MOVE_LEFT";
-        case INGAME_CMD_MOVE_RIGHT:
-            return "MOVE_RIGHT";
-        case INGAME_CMD_STOP:
-            return "STOP";
-        case INGAME_CMD_ADJUST_ANGLE:
-            return "ADJUST_ANGLE";
-        case INGAME_CMD_ADJUST_POWER:
-            return "ADJUST_POWER";
-        case INGAME_CMD_FIRE:
-            return "FIRE";
-        default:
-            return nullptr;
+const char* RoomStateName(RoomState state) {
+    switch (state) {
+        case WAITING_FOR_PLAYERS: return "WAITING_FOR_PLAYERS";
+        case PLAYING_TURN: return "PLAYING_TURN";
+        case FIRING_PHASE: return "FIRING_PHASE";
+        case GAME_OVER: return "GAME_OVER";
     }
+    return "UNKNOWN";
+}
+
+// Timestamps echoed to clients; only differences between them mean anything.
+int64_t SteadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 }
 
@@ -36,7 +59,32 @@ GameServer::GameServer()
       m_gameRoom(nullptr),
       m_mapLoader(nullptr),
       m_matchId(1),
-      m_tick(0) {}
+      m_tick(0),
+      m_terrainVersion(0),
+      m_recorder(nullptr),
+      m_roomTick(0),
+      m_servicePort(0),
+      m_botFillSeconds(kDefaultBotFillSeconds),
+      m_waitTicks(0),
+      m_botPool(nullptr),
+      m_profiler((uint64_t)(kTickSeconds * 1e9f)),
+      m_overrunLogPath(kDefaultOverrunLog),
+      m_overrunStop(false),
+      m_lastInputCount(0),
+      m_overrunSecond(0),
+      m_overrunsThisSecond(0),
+      m_overrunsSuppressed(0),
+      m_connectionCount(0),
+      m_connectionsAccepted(0),
+      m_roomStateMetric(-1),
+      m_sendQueueMax(0),
+      m_sendQueueTotal(0),
+      m_pingTimeouts(0) {
+    for (int i = 0; i < INGAME_MAX_PLAYERS; i++) {
+        m_seatRttUs[i].store(-1, std::memory_order_relaxed);
+        m_seatJitterUs[i].store(-1, std::memory_order_relaxed);
+    }
+}
 
 GameServer::~GameServer() {
     Stop();
@@ -54,6 +102,7 @@ void GameServer::Stop() {
         }
         m_clients.clear();
         m_fdToPlayerId.clear();
+        m_terrainSyncs.clear();
     }
 
     if (m_gameLoopThread.joinable()) {
@@ -62,6 +111,16 @@ void GameServer::Stop() {
 
     {
         std::lock_guard<std::mutex> lock(m_roomMutex);
+        StopRecording();
+
+        // Bots first: their solvers may still have batches queued on the pool.
+        for (auto* bot : m_bots) {
+            delete bot;
+        }
+        m_bots.clear();
+        delete m_botPool;
+        m_botPool = nullptr;
+
         delete m_gameRoom;
         m_gameRoom = nullptr;
 
@@ -73,6 +132,19 @@ void GameServer::Stop() {
         delete m_mapLoader;
         m_mapLoader = nullptr;
     }
+
+    if (m_reportThread.joinable()) {
+        m_reportThread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_overrunMutex);
+        m_overrunStop = true;
+    }
+    m_overrunWake.notify_all();
+    if (m_overrunThread.joinable()) {
+        m_overrunThread.join();
+    }
 }
 
 void GameServer::Run(int port) {
@@ -83,6 +155,9 @@ void GameServer::Run(int port) {
 
         std::cout << "GameServer listening on port " << port << std::endl;
 
+        if (!m_overrunLogPath.empty()) {
+            m_overrunThread = std::thread(&GameServer::OverrunLogLoop, this);
+        }
         m_gameLoopThread = std::thread(&GameServer::GameLoop, this);
 
         while (mIsRunning) {
@@ -91,13 +166,17 @@ void GameServer::Run(int port) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(2));
                 continue;
             }
+            // A tick sends terrain and state back to back; the second must not wait for an ACK.
+            clientSocket->SetNoDelay(true);
 
             {
                 std::lock_guard<std::mutex> lock(m_clientsMutex);
                 m_clients.push_back(clientSocket);
             }
+            m_connectionCount.fetch_add(1, std::memory_order_relaxed);
+            m_connectionsAccepted.fetch_add(1, std::memory_order_relaxed);
 
-            std::cout << "GameServer accepted connection." << std::endl;
+            LOG_INFO("connection_accepted", "fd", clientSocket->GetFd());
             std::thread clientThread(&GameServer::HandleClient, this, clientSocket);
             clientThread.detach();
         }
@@ -111,7 +190,14 @@ void GameServer::RemoveClient(TCPSocket* clientSocket) {
 
     const int fd = clientSocket->GetFd();
     std::lock_guard<std::mutex> lock(m_clientsMutex);
+    auto seat = m_fdToPlayerId.find(fd);
+    if (seat != m_fdToPlayerId.end() && seat->second < INGAME_MAX_PLAYERS) {
+        m_seatRttUs[seat->second].store(-1, std::memory_order_relaxed);
+        m_seatJitterUs[seat->second].store(-1, std::memory_order_relaxed);
+    }
     m_fdToPlayerId.erase(fd);
+    m_terrainSyncs.erase(clientSocket);
+    m_pings.erase(clientSocket);
 
     auto it = std::find(m_clients.begin(), m_clients.end(), clientSocket);
     if (it != m_clients.end()) {
@@ -121,6 +207,7 @@ void GameServer::RemoveClient(TCPSocket* clientSocket) {
 
 void GameServer::HandleClient(TCPSocket* clientSocket) {
     if (!clientSocket) return;
+    Trace::setThreadName("client_connection");
 
     bool connected = true;
 
@@ -130,7 +217,10 @@ void GameServer::HandleClient(TCPSocket* clientSocket) {
             connected = false;
             break;
         }
+        const int64_t receivedUs = SteadyMicros();
 
+        Trace::Span receiveSpan("receive", "server");
+        receiveSpan.arg("type", packet.header.type);
         switch (packet.header.type) {
             case PacketType::REQ_INGAME_JOIN: {
                 ReqIngameJoin req = packet.GetPayload<ReqIngameJoin>();
@@ -140,13 +230,17 @@ void GameServer::HandleClient(TCPSocket* clientSocket) {
                 res.playerId = UINT32_MAX;
 
                 uint32_t assignedPlayerId = UINT32_MAX;
+                TerrainSync sync;
+                MapLoader terrain;
+                bool needsSync = false;
                 {
                     std::lock_guard<std::mutex> lock(m_roomMutex);
 
                     if (!m_mapLoader) {
                         m_mapLoader = new MapLoader();
                         std::string mapPath = (req.mapName[0] != '\0') ? std::string(req.mapName) : std::string(kDefaultMap);
-                        if (!m_mapLoader->loadMap(mapPath)) {
+                        m_mapPath = mapPath;
+                        if (!MapGenerator::Load(*m_mapLoader, mapPath, std::random_device{}())) {
                             res.isSuccess = false;
                             std::snprintf(res.message, sizeof(res.message), "Failed to load map: %s", mapPath.c_str());
                             PacketUtils::SendPacket(clientSocket, PacketType::RES_INGAME_JOIN, res);
@@ -155,55 +249,151 @@ void GameServer::HandleClient(TCPSocket* clientSocket) {
                     }
 
                     if (m_players.size() >= INGAME_MAX_PLAYERS) {
-                        res.isSuccess = false;
-                        std::snprintf(res.message, sizeof(res.message), "Room full");
-                        PacketUtils::SendPacket(clientSocket, PacketType::RES_INGAME_JOIN, res);
-                        break;
-                    }
+                        // A reconnecting client takes over a human seat whose connection dropped.
+                        assignedPlayerId = ClaimOrphanedSeat(clientSocket->GetFd());
+                        if (assignedPlayerId == UINT32_MAX) {
+                            res.isSuccess = false;
+                            std::snprintf(res.message, sizeof(res.message), "Room full");
+                            PacketUtils::SendPacket(clientSocket, PacketType::RES_INGAME_JOIN, res);
+                            break;
+                        }
+                    } else {
+                        assignedPlayerId = static_cast<uint32_t>(m_players.size());
+                        AddPlayer("Player" + std::to_string(assignedPlayerId + 1));
+                        {
+                            // Before m_roomMutex is released, or a reconnect could take the seat as orphaned.
+                            std::lock_guard<std::mutex> clientsLock(m_clientsMutex);
+                            m_fdToPlayerId[clientSocket->GetFd()] = assignedPlayerId;
+                        }
 
-                    assignedPlayerId = static_cast<uint32_t>(m_players.size());
-                    const auto& spawns = m_mapLoader->getSpawnPoints();
-                    float sx = (spawns.size() > assignedPlayerId) ? spawns[assignedPlayerId].x : (100.0f + 300.0f * assignedPlayerId);
-                    float sy = (spawns.size() > assignedPlayerId) ? spawns[assignedPlayerId].y : 100.0f;
-                    bool orient = (assignedPlayerId % 2 == 0);
-
-                    Player* p = new Player((int)assignedPlayerId,
-                                           "Player" + std::to_string(assignedPlayerId + 1),
-                                           sx,
-                                           sy,
-                                           orient);
-                    m_players.push_back(p);
-
-                    if (!m_gameRoom && m_players.size() >= 2) {
-                        m_gameRoom = new GameRoom(m_players);
-                        m_gameRoom->setMapLoader(m_mapLoader);
-                        m_gameRoom->startGame();
+                        if (!m_gameRoom && m_players.size() >= 2) {
+                            CreateRoom();
+                        }
                     }
-                }
 
-                if (assignedPlayerId != UINT32_MAX) {
-                    std::lock_guard<std::mutex> lock(m_clientsMutex);
-                    m_fdToPlayerId[clientSocket->GetFd()] = assignedPlayerId;
+                    // The seat's last ack belongs to its previous connection, whose seqs mean
+                    // nothing to this one.
+                    m_inputAcks[assignedPlayerId] = {};
+
+                    // Late joiners and reconnects get the current terrain instead of the pristine map.
+                    // The sync is registered before the lock is released so every diff after
+                    // its version is broadcast to this connection.
+                    needsSync = CaptureTerrainSync(sync, terrain);
+                    if (needsSync) {
+                        std::lock_guard<std::mutex> clientsLock(m_clientsMutex);
+                        TerrainSync& pending = m_terrainSyncs[clientSocket];
+                        pending = TerrainSync{};
+                        pending.header = sync.header;
+                    }
+                    std::snprintf(res.mapName, sizeof(res.mapName), "%s", m_mapPath.c_str());
+                    res.mapSeed = m_mapLoader->getSeed();
                 }
+                if (needsSync) CompressTerrainSync(sync, terrain);
 
                 res.isSuccess = (assignedPlayerId != UINT32_MAX);
                 res.playerId = assignedPlayerId;
                 if (res.isSuccess) {
                     std::snprintf(res.message, sizeof(res.message), "Joined match %u as player %u", res.matchId, res.playerId);
                 }
+
+                // Sent under m_clientsMutex so it cannot interleave with a broadcast;
+                // the terrain snapshot starts streaming on the next tick.
+                std::lock_guard<std::mutex> lock(m_clientsMutex);
+                auto pending = m_terrainSyncs.find(clientSocket);
+                if (needsSync && pending != m_terrainSyncs.end()) {
+                    pending->second.header.totalSize = sync.header.totalSize;
+                    pending->second.data = std::move(sync.data);
+                    pending->second.ready = true;
+                }
                 PacketUtils::SendPacket(clientSocket, PacketType::RES_INGAME_JOIN, res);
             } break;
 
             case PacketType::REQ_INGAME_INPUT: {
                 ReqIngameInput req = packet.GetPayload<ReqIngameInput>();
-                const char* cmd = CommandToString(req.command);
-                if (!cmd) break;
+                if (!MatchRecording::CommandToString(req.command)) break;
+                if (receiveSpan.active()) {
+                    receiveSpan.arg("seq", req.seq);
+                    Trace::flowStep("input", Trace::inputFlowId(req.playerId, req.seq));
+                }
+
+                std::lock_guard<std::mutex> lock(m_inputMutex);
+                m_pendingInputs.push_back({req, receivedUs});
+            } break;
+
+            case PacketType::REQ_INGAME_TERRAIN_HASHES: {
+                Packet reply(PacketType::RES_INGAME_TERRAIN_HASHES);
+                {
+                    std::lock_guard<std::mutex> lock(m_roomMutex);
+                    if (!m_mapLoader) break;
+
+                    ResIngameTerrainHashes res{};
+                    res.matchId = m_matchId;
+                    res.version = m_terrainVersion;
+                    res.chunkSize = (uint32_t)MapLoader::kHashChunkSize;
+                    res.chunksX = (uint32_t)m_mapLoader->getHashChunksX();
+                    res.chunksY = (uint32_t)m_mapLoader->getHashChunksY();
+
+                    const auto& hashes = m_mapLoader->getChunkHashes();
+                    std::vector<char> bytes(hashes.size() * sizeof(uint64_t));
+                    if (!hashes.empty()) std::memcpy(bytes.data(), hashes.data(), bytes.size());
+                    reply.SetPayload(res);
+                    reply.AppendPayload(bytes);
+                }
+
+                std::lock_guard<std::mutex> lock(m_clientsMutex);
+                PacketUtils::SendPacket(clientSocket, reply);
+            } break;
+
+            case PacketType::REQ_INGAME_TERRAIN_CHUNKS: {
+                if (packet.payload.size() < sizeof(ReqIngameTerrainChunks)) break;
+                ReqIngameTerrainChunks req = packet.GetPayload<ReqIngameTerrainChunks>();
+                const size_t available = (packet.payload.size() - sizeof(req)) / sizeof(uint32_t);
+                const size_t count = std::min<size_t>(req.count, available);
+
+                Packet reply(PacketType::RES_INGAME_TERRAIN_CHUNKS);
+                {
+                    std::lock_guard<std::mutex> lock(m_roomMutex);
+                    if (!m_mapLoader) break;
+
+                    const int chunkCount = m_mapLoader->getHashChunksX() * m_mapLoader->getHashChunksY();
+                    std::vector<TerrainRect> rects;
+                    for (size_t i = 0; i < count; i++) {
+                        uint32_t index;
+                        std::memcpy(&index, packet.payload.data() + sizeof(req) + i * sizeof(uint32_t), sizeof(index));
+                        if (index < (uint32_t)chunkCount) rects.push_back(m_mapLoader->getHashChunkRect((int)index));
+                    }
+
+                    // Always answered with the current version; the client drops it if it has moved on.
+                    ResIngameTerrainChunks res{};
+                    res.matchId = m_matchId;
+                    res.version = m_terrainVersion;
+                    std::vector<char> encoded;
+                    TerrainDiff::Encode(*m_mapLoader, rects, encoded);
+                    reply.SetPayload(res);
+                    reply.AppendPayload(encoded);
+                }
+
+                std::lock_guard<std::mutex> lock(m_clientsMutex);
+                PacketUtils::SendPacket(clientSocket, reply);
+            } break;
+
+            case PacketType::REQ_INGAME_PING: {
+                if (packet.payload.size() < sizeof(ReqIngamePing)) break;
+                const ReqIngamePing ping = packet.GetPayload<ReqIngamePing>();
+                ResIngamePong pong{};
+                pong.id = ping.id;
+                pong.sentUs = ping.sentUs;
+                pong.replyUs = SteadyMicros();
 
-                std::lock_guard<std::mutex> lock(m_roomMutex);
-                if (!m_gameRoom) break;
-                m_gameRoom->handleInput((int)req.playerId, cmd, req.value);
+                std::lock_guard<std::mutex> lock(m_clientsMutex);
+                PacketUtils::SendPacket(clientSocket, PacketType::RES_INGAME_PONG, pong);
             } break;
 
+            case PacketType::RES_INGAME_PONG:
+                if (packet.payload.size() < sizeof(ResIngamePong)) break;
+                HandlePong(clientSocket, packet.GetPayload<ResIngamePong>(), receivedUs);
+                break;
+
             case PacketType::REQ_LOGOUT:
                 connected = false;
                 break;
@@ -214,34 +404,342 @@ void GameServer::HandleClient(TCPSocket* clientSocket) {
         }
     }
 
+    LOG_INFO("connection_closed", "fd", clientSocket->GetFd());
     RemoveClient(clientSocket);
     clientSocket->Close();
     delete clientSocket;
+    m_connectionCount.fetch_sub(1, std::memory_order_relaxed);
 }
 
 void GameServer::GameLoop() {
     using clock = std::chrono::steady_clock;
-    auto last = clock::now();
+    const auto tickDuration = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(kTickSeconds));
+    auto nextTick = clock::now();
+    Trace::setThreadName("tick");
 
     while (mIsRunning) {
-        auto now = clock::now();
-        std::chrono::duration<float> dt = now - last;
-        last = now;
-
-        float deltaSeconds = dt.count();
-        if (deltaSeconds < 0.0f) deltaSeconds = 0.0f;
-        if (deltaSeconds > 0.1f) deltaSeconds = 0.1f;
-
+        const double lateMs = std::chrono::duration<double, std::milli>(clock::now() - nextTick).count();
+        m_profiler.beginTick();
+        // Carries the tick of the snapshot this iteration broadcasts.
+        Trace::Span tickSpan("room_tick", "server");
+        tickSpan.arg("tick", m_tick.load(std::memory_order_relaxed) + 1);
         {
+            TickProfiler::Scope lockScope(PHASE_LOCK_WAIT);
             std::lock_guard<std::mutex> lock(m_roomMutex);
+            lockScope.stop();
+
+            TickProfiler::Scope inputScope(PHASE_INPUT);
+            FillEmptySeats();
+            RunBots();
+            DrainInputs();
+            inputScope.stop();
+
             if (m_gameRoom) {
-                m_gameRoom->update(deltaSeconds);
+                m_gameRoom->update(kTickSeconds);
+                if (m_gameRoom->getState() == GAME_OVER) {
+                    StopRecording();
+                }
             }
+            m_roomStateMetric.store(m_gameRoom ? (int)m_gameRoom->getState()
+                                               : (m_players.empty() ? -1 : (int)WAITING_FOR_PLAYERS),
+                                    std::memory_order_relaxed);
         }
 
         BroadcastStateSnapshot();
+        if (m_profiler.endTick()) {
+            LogOverrun(lateMs);
+        }
+        tickSpan.stop();
+
+        // Fixed-rate stepping keeps the simulation deterministic; after a stall we
+        // resync instead of bursting to catch up.
+        nextTick += tickDuration;
+        const auto now = clock::now();
+        if (nextTick < now) nextTick = now;
+        std::this_thread::sleep_until(nextTick);
+    }
+
+    PrintTickProfile();
+}
+
+// Called with m_roomMutex held. Picks a human seat with no connection and gives it to fd
+// under the same lock, so concurrent reconnects never get the same seat.
+uint32_t GameServer::ClaimOrphanedSeat(int fd) {
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    for (const Player* p : m_players) {
+        const uint32_t id = (uint32_t)p->getId();
+        const bool isBot = std::any_of(m_bots.begin(), m_bots.end(),
+                                       [id](const SolverBot* b) { return (uint32_t)b->getPlayerId() == id; });
+        if (isBot) continue;
+
+        const bool connected = std::any_of(m_fdToPlayerId.begin(), m_fdToPlayerId.end(),
+                                           [id](const std::pair<const int, uint32_t>& e) { return e.second == id; });
+        if (!connected) {
+            m_fdToPlayerId[fd] = id;
+            return id;
+        }
+    }
+    return UINT32_MAX;
+}
+
+// Called with m_roomMutex held. Copies the current terrain (only mixed tiles own memory)
+// for CompressTerrainSync, which runs after the lock is released so a join never holds
+// up the tick. Returns false when the client can rebuild the terrain itself: a generated
+// map that no explosion has touched yet is fully described by the name and seed in the
+// join response.
+bool GameServer::CaptureTerrainSync(TerrainSync& out, MapLoader& terrain) {
+    if (!m_mapLoader) return false;
+    int width = 0, height = 0;
+    if (m_terrainVersion == 0 && MapGenerator::ParseName(m_mapPath, width, height)) return false;
+
+    terrain = *m_mapLoader;
+    out.header = ResIngameTerrainSnapshot{};
+    out.header.matchId = m_matchId;
+    out.header.version = m_terrainVersion;
+    out.header.width = (uint32_t)terrain.getWidth();
+    out.header.height = (uint32_t)terrain.getHeight();
+    out.header.offset = 0;
+    return true;
+}
+
+// Compresses the captured terrain once; the broadcast then streams it in
+// kTerrainChunkBytes pieces.
+void GameServer::CompressTerrainSync(TerrainSync& out, const MapLoader& terrain) {
+    std::vector<uint8_t> bits;
+    terrain.packCells(bits);
+    out.data.clear();
+    LZ::Compress(bits.data(), bits.size(), out.data);
+    out.header.totalSize = (uint32_t)out.data.size();
+}
+
+// Called with m_clientsMutex held. Returns true once the last chunk has been sent.
+bool GameServer::SendTerrainSyncChunk(TCPSocket* client, TerrainSync& sync) {
+    const size_t offset = sync.header.offset;
+    const size_t size = std::min(kTerrainChunkBytes, sync.data.size() - offset);
+
+    Packet packet(PacketType::RES_INGAME_TERRAIN_SNAPSHOT);
+    packet.SetPayload(sync.header);
+    packet.AppendPayload(std::vector<char>(sync.data.begin() + offset, sync.data.begin() + offset + size));
+    PacketUtils::SendPacket(client, packet);
+
+    sync.header.offset = (uint32_t)(offset + size);
+    return sync.header.offset >= sync.data.size();
+}
+
+// Called with m_roomMutex held. Seats are assigned in join order.
+Player* GameServer::AddPlayer(const std::string& name) {
+    const uint32_t id = static_cast<uint32_t>(m_players.size());
+    const auto& spawns = m_mapLoader->getSpawnPoints();
+    float sx = (spawns.size() > id) ? spawns[id].x : (100.0f + 300.0f * id);
+    float sy = (spawns.size() > id) ? spawns[id].y : 100.0f;
+    bool orient = (id % 2 == 0);
+
+    Player* p = new Player((int)id, name, sx, sy, orient);
+    m_players.push_back(p);
+    return p;
+}
+
+// Called with m_roomMutex held once every seat is taken.
+void GameServer::CreateRoom() {
+    m_gameRoom = new GameRoom(m_players);
+    m_gameRoom->setMapLoader(m_mapLoader);
+    m_gameRoom->startGame();
+    StartRecording();
+}
+
+// Called with m_roomMutex held, once per tick.
+void GameServer::FillEmptySeats() {
+    if (m_gameRoom || !m_mapLoader || m_players.empty() || m_botFillSeconds < 0.0f) {
+        m_waitTicks = 0;
+        return;
+    }
+    if (++m_waitTicks * kTickSeconds < m_botFillSeconds) return;
+
+    if (!m_botPool) {
+        // Leave a core for the tick and client threads.
+        const size_t cores = std::thread::hardware_concurrency();
+        m_botPool = new WorkStealingPool(cores > 1 ? cores - 1 : 1);
+    }
+
+    while (m_players.size() < INGAME_MAX_PLAYERS) {
+        Player* p = AddPlayer("Bot" + std::to_string(m_players.size() + 1));
+        m_bots.push_back(new SolverBot(p->getId(), m_botPool, kBotSolveBudget));
+        LOG_INFO("bot_seated", "player", p->getId());
+    }
+    m_waitTicks = 0;
+    CreateRoom();
+}
+
+// Called with m_roomMutex held, before DrainInputs. Bot commands go through the
+// input queue so they are applied and recorded exactly like client input.
+void GameServer::RunBots() {
+    if (!m_gameRoom || m_bots.empty()) return;
+
+    std::vector<BotCommand> commands;
+    for (auto* bot : m_bots) {
+        commands.clear();
+        bot->think(*m_gameRoom, kTickSeconds, commands);
+        if (commands.empty()) continue;
+
+        std::lock_guard<std::mutex> lock(m_inputMutex);
+        for (const auto& c : commands) {
+            ReqIngameInput in{};
+            in.matchId = m_matchId;
+            in.playerId = (uint32_t)bot->getPlayerId();
+            in.command = c.command;
+            in.value = c.value;
+            m_pendingInputs.push_back({in, SteadyMicros()});
+        }
+    }
+}
+
+// Called with m_roomMutex held, once per tick before GameRoom::update.
+void GameServer::DrainInputs() {
+    std::vector<PendingInput> inputs;
+    {
+        std::lock_guard<std::mutex> lock(m_inputMutex);
+        inputs.swap(m_pendingInputs);
+    }
+    m_lastInputCount = inputs.size();
+    if (!m_gameRoom) return;
+
+    m_roomTick++;
+    const int64_t appliedUs = SteadyMicros();
+    for (const auto& pending : inputs) {
+        const ReqIngameInput& in = pending.req;
+        const char* cmd = MatchRecording::CommandToString(in.command);
+        if (!cmd) continue;
+        if (m_gameRoom->handleInput((int)in.playerId, cmd, in.value) && m_recorder) {
+            m_recorder->recordInput(m_roomTick, in.playerId, in.command, in.value);
+        }
+        // Bot inputs have no seq: nothing to acknowledge and nothing upstream to link to.
+        if (in.seq == 0 || in.playerId >= INGAME_MAX_PLAYERS) continue;
+        // Rejected commands (not this player's turn) are acknowledged too; the client
+        // only needs to know they were processed.
+        m_inputAcks[in.playerId] = {in.seq, pending.receivedUs, appliedUs};
+        Trace::flowEnd("input", Trace::inputFlowId(in.playerId, in.seq));
+    }
+}
+
+// Called with m_roomMutex held, right after the room is created.
+void GameServer::StartRecording() {
+    if (m_recorder || !m_gameRoom || !m_mapLoader) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(kRecordingDir, ec);
+
+    char path[128];
+    std::snprintf(path, sizeof(path), "%s/match_%u_%ld.gmr", kRecordingDir, m_matchId, (long)std::time(nullptr));
+
+    MatchRecordingInfo info;
+    info.matchId = m_matchId;
+    info.seed = m_mapLoader->getSeed();
+    info.tickSeconds = kTickSeconds;
+    info.mapName = m_mapPath;
+    for (const Player* p : m_gameRoom->getPlayers()) {
+        RecordedPlayer rp{};
+        const Position pos = p->getPosition();
+        rp.id = (uint32_t)p->getId();
+        rp.x = pos.x;
+        rp.y = pos.y;
+        rp.orient = pos.orient ? 1 : 0;
+        std::snprintf(rp.name, sizeof(rp.name), "Player%d", p->getId() + 1);
+        info.players.push_back(rp);
+    }
+
+    m_roomTick = 0;
+    m_recorder = new MatchRecorder();
+    if (!m_recorder->open(path, info)) {
+        LOG_ERROR("recording_open_failed", "path", path);
+        delete m_recorder;
+        m_recorder = nullptr;
+        return;
+    }
+    LOG_INFO("recording_started", "match", m_matchId, "path", path);
+}
+
+// Called with m_roomMutex held.
+void GameServer::StopRecording() {
+    if (!m_recorder) return;
+
+    const uint64_t hash = m_gameRoom ? MatchRecording::ComputeStateHash(*m_gameRoom) : 0;
+    m_recorder->close(m_roomTick, hash);
+    LOG_INFO("recording_saved", "match", m_matchId, "inputs", m_recorder->getInputCount(), "ticks", m_roomTick,
+             "path", m_recorder->getPath());
+    ReportRecording(m_recorder->getPath());
+
+    delete m_recorder;
+    m_recorder = nullptr;
+}
+
+// Sends the recording's absolute path to the service server for "Match".log_path. Off
+// the tick thread, since connecting may take a while; Stop() waits for it.
+void GameServer::ReportRecording(const std::string& path) {
+    if (m_serviceIp.empty()) return;
+
+    std::error_code ec;
+    const std::string absolute = std::filesystem::absolute(path, ec).string();
+    ReqMatchLogPath req{};
+    req.matchId = m_matchId;
+    std::snprintf(req.logPath, sizeof(req.logPath), "%s", ec ? path.c_str() : absolute.c_str());
+
+    if (m_reportThread.joinable()) m_reportThread.join();
+    m_reportThread = std::thread([ip = m_serviceIp, port = m_servicePort, req]() {
+        TCPSocket socket;
+        try {
+            socket.Connect(ip, port);
+        } catch (const std::exception& e) {
+            LOG_WARN("recording_report_failed", "match", req.matchId, "error", e.what());
+            return;
+        }
+        if (PacketUtils::SendPacket(&socket, PacketType::REQ_MATCH_LOG_PATH, req)) {
+            LOG_INFO("recording_reported", "match", req.matchId, "path", req.logPath);
+        } else {
+            LOG_WARN("recording_report_failed", "match", req.matchId, "error", "send");
+        }
+        socket.Close();
+    });
+}
+
+void GameServer::FillStateSnapshot(const GameRoom* room, const std::vector<Player*>& seated, ResIngameState& out) {
+    const std::vector<Player*>& players = room ? room->getPlayers() : seated;
+    out.roomState = room ? (uint32_t)room->getState() : (uint32_t)WAITING_FOR_PLAYERS;
+    out.turnTimer = room ? room->getTurnTimer() : 0.0f;
+    out.playerCount = static_cast<uint8_t>(std::min<size_t>(players.size(), INGAME_MAX_PLAYERS));
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    for (size_t i = 0; i < out.playerCount; i++) {
+        Player* p = players[i];
+        if (!p) continue;
+        const Position pos = p->getPosition();
+
+        out.players[i].id = (uint32_t)p->getId();
+        out.players[i].hp = (int32_t)p->getHP();
+        out.players[i].isAlive = p->isAlive() ? 1 : 0;
+        out.players[i].isMyTurn = p->isMyTurn() ? 1 : 0;
+        out.players[i].orient = pos.orient ? 1 : 0;
+        out.players[i].x = pos.x;
+        out.players[i].y = pos.y;
+        out.players[i].angle = p->m_angle;
+        out.players[i].power = p->m_power;
+        out.players[i].vx = p->m_velocity.vx;
+        out.players[i].vy = p->m_velocity.vy;
+        out.players[i].isAsleep = p->isAsleep() ? 1 : 0;
+    }
+
+    out.projectileCount = 0;
+    if (!room) return;
+
+    const auto& projectiles = room->getProjectiles();
+    const size_t projCount = std::min<size_t>(projectiles.size(), INGAME_MAX_PROJECTILES);
+    out.projectileCount = static_cast<uint8_t>(projCount);
+
+    for (size_t i = 0; i < projCount; i++) {
+        const auto& pr = projectiles[i];
+        out.projectiles[i].isActive = pr.isActive ? 1 : 0;
+        out.projectiles[i].x = pr.position.x;
+        out.projectiles[i].y = pr.position.y;
+        out.projectiles[i].vx = pr.velocity.vx;
+        out.projectiles[i].vy = pr.velocity.vy;
     }
 }
 
@@ -249,91 +747,307 @@ void GameServer::BroadcastStateSnapshot() {
     ResIngameState snapshot{};
     snapshot.matchId = m_matchId;
     snapshot.tick = ++m_tick;
+    Trace::Span broadcastSpan("broadcast", "server");
+    broadcastSpan.arg("tick", snapshot.tick);
+
+    Packet terrainPacket(PacketType::RES_INGAME_TERRAIN_DIFF);
+    bool hasTerrainDiff = false;
 
     {
+        TickProfiler::Scope lockScope(PHASE_LOCK_WAIT);
         std::lock_guard<std::mutex> lock(m_roomMutex);
+        lockScope.stop();
+        TickProfiler::Scope buildScope(PHASE_SNAPSHOT_BUILD);
 
-        if (!m_gameRoom) {
-            snapshot.roomState = (uint32_t)WAITING_FOR_PLAYERS;
-            snapshot.turnTimer = 0.0f;
-            snapshot.terrainModified = 0;
-            snapshot.hasExplosion = 0;
-            snapshot.explosionX = 0.0f;
-            snapshot.explosionY = 0.0f;
-            snapshot.explosionRadius = 0.0f;
-            snapshot.playerCount = static_cast<uint8_t>(std::min<size_t>(m_players.size(), INGAME_MAX_PLAYERS));
-            snapshot.projectileCount = 0;
-
-            for (size_t i = 0; i < snapshot.playerCount; i++) {
-                Player* p = m_players[i];
-                if (!p) continue;
-                const Position pos = p->getPosition();
-
-                snapshot.players[i].id = (uint32_t)p->getId();
-                snapshot.players[i].hp = (int32_t)p->getHP();
-                snapshot.players[i].isAlive = p->isAlive() ? 1 : 0;
-                snapshot.players[i].isMyTurn = p->isMyTurn() ? 1 : 0;
-                snapshot.players[i].orient = pos.orient ? 1 : 0;
-                snapshot.players[i].x = pos.x;
-                snapshot.players[i].y = pos.y;
-                snapshot.players[i].angle = p->m_angle;
-                snapshot.players[i].power = p->m_power;
-            }
-        } else {
-            snapshot.roomState = (uint32_t)m_gameRoom->getState();
-            snapshot.turnTimer = m_gameRoom->getTurnTimer();
-            snapshot.terrainModified = m_gameRoom->consumeTerrainModified() ? 1 : 0;
-
-            float ex = 0.0f, ey = 0.0f, er = 0.0f;
-            if (m_gameRoom->consumeLastExplosion(ex, ey, er)) {
-                snapshot.hasExplosion = 1;
-                snapshot.explosionX = ex;
-                snapshot.explosionY = ey;
-                snapshot.explosionRadius = er;
-            } else {
-                snapshot.hasExplosion = 0;
-                snapshot.explosionX = 0.0f;
-                snapshot.explosionY = 0.0f;
-                snapshot.explosionRadius = 0.0f;
-            }
+        FillStateSnapshot(m_gameRoom, m_players, snapshot);
+        for (uint8_t i = 0; i < snapshot.playerCount; i++) {
+            NetPlayerState& ps = snapshot.players[i];
+            if (ps.id >= INGAME_MAX_PLAYERS) continue;
+            ps.lastInputSeq = m_inputAcks[ps.id].seq;
+            ps.inputReceivedUs = m_inputAcks[ps.id].receivedUs;
+            ps.inputAppliedUs = m_inputAcks[ps.id].appliedUs;
+        }
 
-            const auto& players = m_gameRoom->getPlayers();
-            snapshot.playerCount = static_cast<uint8_t>(std::min<size_t>(players.size(), INGAME_MAX_PLAYERS));
-
-            for (size_t i = 0; i < snapshot.playerCount; i++) {
-                Player* p = players[i];
-                if (!p) continue;
-                const Position pos = p->getPosition();
-
-                snapshot.players[i].id = (uint32_t)p->getId();
-                snapshot.players[i].hp = (int32_t)p->getHP();
-                snapshot.players[i].isAlive = p->isAlive() ? 1 : 0;
-                snapshot.players[i].isMyTurn = p->isMyTurn() ? 1 : 0;
-                snapshot.players[i].orient = pos.orient ? 1 : 0;
-                snapshot.players[i].x = pos.x;
-                snapshot.players[i].y = pos.y;
-                snapshot.players[i].angle = p->m_angle;
-                snapshot.players[i].power = p->m_power;
-            }
+        m_dirtyRects.clear();
+        hasTerrainDiff = m_gameRoom && m_gameRoom->drainDirtyRects(m_dirtyRects);
+        if (hasTerrainDiff) ++m_terrainVersion;
 
-            const auto& projectiles = m_gameRoom->getProjectiles();
-            const size_t projCount = std::min<size_t>(projectiles.size(), INGAME_MAX_PROJECTILES);
-            snapshot.projectileCount = static_cast<uint8_t>(projCount);
-
-            for (size_t i = 0; i < projCount; i++) {
-                const auto& pr = projectiles[i];
-                snapshot.projectiles[i].isActive = pr.isActive ? 1 : 0;
-                snapshot.projectiles[i].x = pr.position.x;
-                snapshot.projectiles[i].y = pr.position.y;
-                snapshot.projectiles[i].vx = pr.velocity.vx;
-                snapshot.projectiles[i].vy = pr.velocity.vy;
-            }
+        snapshot.terrainVersion = m_terrainVersion;
+        CaptureOverrunRoom();
+        if (m_mapLoader && snapshot.tick % kTerrainHashInterval == 0) {
+            snapshot.hasTerrainHash = 1;
+            snapshot.terrainHash = m_mapLoader->getTerrainHash();
+        }
+        buildScope.stop();
+
+        if (hasTerrainDiff) {
+            TickProfiler::Scope encodeScope(PHASE_ENCODE);
+            ResIngameTerrainDiff diff{};
+            diff.matchId = m_matchId;
+            diff.tick = snapshot.tick;
+            diff.version = m_terrainVersion;
+
+            std::vector<char> encoded;
+            TerrainDiff::Encode(*m_mapLoader, m_dirtyRects, encoded);
+            terrainPacket.SetPayload(diff);
+            terrainPacket.AppendPayload(encoded);
         }
     }
 
+    TickProfiler::Scope lockScope(PHASE_LOCK_WAIT);
     std::lock_guard<std::mutex> lock(m_clientsMutex);
+    lockScope.stop();
+    TickProfiler::Scope sendScope(PHASE_SEND);
+    m_overrunRoom.clients = m_clients.size();
+    m_overrunRoom.terrainSyncs = m_terrainSyncs.size();
     for (auto* c : m_clients) {
         if (!c) continue;
+        auto sync = m_terrainSyncs.find(c);
+        if (sync != m_terrainSyncs.end() && sync->second.ready && SendTerrainSyncChunk(c, sync->second)) {
+            m_terrainSyncs.erase(sync);
+        }
+        // The diff goes first so a client never sees a snapshot ahead of its terrain.
+        if (hasTerrainDiff) PacketUtils::SendPacket(c, terrainPacket);
+        if (broadcastSpan.active()) {
+            auto player = m_fdToPlayerId.find(c->GetFd());
+            if (player != m_fdToPlayerId.end()) {
+                Trace::flowStart("snapshot", Trace::snapshotFlowId(player->second, snapshot.tick));
+            }
+        }
         PacketUtils::SendPacket(c, PacketType::RES_INGAME_STATE, snapshot);
     }
-}
\ No newline at end of file
+    PingClients();
+
+    int queueMax = 0, queueTotal = 0;
+    for (auto* c : m_clients) {
+        const int queued = c ? c->GetSendQueueBytes() : -1;
+        if (queued <= 0) continue;
+        queueMax = std::max(queueMax, queued);
+        queueTotal += queued;
+    }
+    m_sendQueueMax.store(queueMax, std::memory_order_relaxed);
+    m_sendQueueTotal.store(queueTotal, std::memory_order_relaxed);
+}
+
+// Called with m_clientsMutex held, once per tick after the snapshot went out.
+void GameServer::PingClients() {
+    const int64_t now = SteadyMicros();
+    for (auto* c : m_clients) {
+        if (!c) continue;
+        ConnectionPing& ping = m_pings[c];
+
+        // Clients that never answered (older builds, raw tools) are not timed out.
+        if (ping.rtt.hasSample() && now - ping.lastPongUs > std::max(kMinPongTimeoutUs, 4 * ping.rtt.timeoutUs(0))) {
+            LOG_WARN("ping_timeout", "fd", c->GetFd(), "silent_ms", (now - ping.lastPongUs) / 1000,
+                     "srtt_us", ping.rtt.srttUs());
+            m_pingTimeouts.fetch_add(1, std::memory_order_relaxed);
+            // HandleClient wakes up from its receive and cleans up as for any disconnect.
+            c->Shutdown();
+            ping.lastPongUs = now;
+            continue;
+        }
+
+        if (now - ping.lastPingUs < kPingIntervalUs) continue;
+        ReqIngamePing req{};
+        req.id = ++ping.nextId;
+        req.sentUs = now;
+        ping.lastPingUs = now;
+        PacketUtils::SendPacket(c, PacketType::REQ_INGAME_PING, req);
+    }
+}
+
+// Client thread.
+void GameServer::HandlePong(TCPSocket* clientSocket, const ResIngamePong& pong, int64_t receivedUs) {
+    std::lock_guard<std::mutex> lock(m_clientsMutex);
+    auto it = m_pings.find(clientSocket);
+    if (it == m_pings.end()) return;
+    ConnectionPing& ping = it->second;
+    ping.rtt.addSample(pong.sentUs, receivedUs, pong.replyUs);
+    ping.lastPongUs = receivedUs;
+    m_rttHistogram.record((uint64_t)std::max<int64_t>(0, ping.rtt.lastRttUs()) * 1000);
+
+    auto seat = m_fdToPlayerId.find(clientSocket->GetFd());
+    if (seat != m_fdToPlayerId.end() && seat->second < INGAME_MAX_PLAYERS) {
+        m_seatRttUs[seat->second].store(ping.rtt.srttUs(), std::memory_order_relaxed);
+        m_seatJitterUs[seat->second].store(ping.rtt.jitterUs(), std::memory_order_relaxed);
+    }
+}
+
+int64_t GameServer::GetPlayerRttUs(uint32_t playerId) const {
+    return playerId < INGAME_MAX_PLAYERS ? m_seatRttUs[playerId].load(std::memory_order_relaxed) : -1;
+}
+
+int64_t GameServer::GetPlayerJitterUs(uint32_t playerId) const {
+    return playerId < INGAME_MAX_PLAYERS ? m_seatJitterUs[playerId].load(std::memory_order_relaxed) : -1;
+}
+
+// Called with m_roomMutex held at the end of every tick: the room state LogOverrun
+// reports if the tick turns out to be over budget.
+void GameServer::CaptureOverrunRoom() {
+    OverrunRoom& r = m_overrunRoom;
+    r.state = m_gameRoom ? m_gameRoom->getState() : WAITING_FOR_PLAYERS;
+    r.roomTick = m_roomTick;
+    r.turnTimer = m_gameRoom ? m_gameRoom->getTurnTimer() : 0.0f;
+    const Player* current = m_gameRoom ? m_gameRoom->getCurrentPlayer() : nullptr;
+    r.currentPlayer = current ? current->getId() : -1;
+    r.projectiles = 0;
+    if (m_gameRoom) {
+        for (const auto& pr : m_gameRoom->getProjectiles()) r.projectiles += pr.isActive ? 1 : 0;
+    }
+    r.debrisBodies = m_gameRoom ? m_gameRoom->getTerrainCollapse().getBodyCount() : (size_t)0;
+    r.terrainVersion = m_terrainVersion;
+    r.terrainRevision = m_mapLoader ? m_mapLoader->getRevision() : 0u;
+    r.bots = m_bots.size();
+    r.playerCount = std::min(m_players.size(), (size_t)INGAME_MAX_PLAYERS);
+    for (size_t i = 0; i < r.playerCount; i++) {
+        const Player* p = m_players[i];
+        r.players[i] = {p->getId(), p->getHP(), p->isAlive(), p->isAsleep(),
+                        p->m_position.x, p->m_position.y, p->m_velocity.vx, p->m_velocity.vy};
+    }
+}
+
+// Called on the tick thread right after a tick that went over budget. Only formats;
+// the write happens on m_overrunThread.
+void GameServer::LogOverrun(double lateMs) {
+    if (m_overrunLogPath.empty()) return;
+    const int64_t second = (int64_t)std::time(nullptr);
+    if (second != m_overrunSecond) {
+        m_overrunSecond = second;
+        m_overrunsThisSecond = 0;
+    }
+    if (m_overrunsThisSecond >= kMaxOverrunLogsPerSecond) {
+        m_overrunsSuppressed++;
+        return;
+    }
+    m_overrunsThisSecond++;
+
+    const TickProfiler::Breakdown& t = m_profiler.lastTick();
+    const OverrunRoom& r = m_overrunRoom;
+    char buf[512];
+    std::string line;
+    std::snprintf(buf, sizeof(buf),
+                  "{\"time\":%ld,\"match\":%u,\"tick\":%u,\"budget_us\":%.1f,\"late_us\":%.1f,\"suppressed\":%llu,\"phases_us\":{",
+                  (long)second, m_matchId, m_tick.load(), m_profiler.getBudgetNs() / 1e3, lateMs * 1e3,
+                  (unsigned long long)m_overrunsSuppressed);
+    line += buf;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        std::snprintf(buf, sizeof(buf), "%s\"%s\":%.1f", p ? "," : "", tickPhaseName(p), t.ns[p] / 1e3);
+        line += buf;
+    }
+    std::snprintf(buf, sizeof(buf),
+                  "},\"room\":{\"state\":\"%s\",\"room_tick\":%u,\"turn_timer\":%.2f,\"current_player\":%d,"
+                  "\"projectiles\":%zu,\"debris_bodies\":%zu,\"terrain_version\":%u,\"terrain_revision\":%u,"
+                  "\"inputs\":%zu,\"bots\":%zu,\"players\":[",
+                  RoomStateName(r.state), r.roomTick, r.turnTimer, r.currentPlayer, r.projectiles, r.debrisBodies,
+                  r.terrainVersion, r.terrainRevision, m_lastInputCount, r.bots);
+    line += buf;
+    for (size_t i = 0; i < r.playerCount; i++) {
+        const auto& p = r.players[i];
+        std::snprintf(buf, sizeof(buf),
+                      "%s{\"id\":%d,\"hp\":%d,\"alive\":%d,\"asleep\":%d,\"x\":%.1f,\"y\":%.1f,\"vx\":%.2f,\"vy\":%.2f}",
+                      i ? "," : "", p.id, p.hp, p.alive ? 1 : 0, p.asleep ? 1 : 0, p.x, p.y, p.vx, p.vy);
+        line += buf;
+    }
+    std::snprintf(buf, sizeof(buf), "],\"clients\":%zu,\"terrain_syncs\":%zu}}\n", r.clients, r.terrainSyncs);
+    line += buf;
+
+    {
+        std::lock_guard<std::mutex> lock(m_overrunMutex);
+        m_overrunQueue.push_back(std::move(line));
+    }
+    m_overrunWake.notify_one();
+}
+
+// Writes queued overrun lines to m_overrunLogPath until Stop().
+void GameServer::OverrunLogLoop() {
+    Trace::setThreadName("overrun_log");
+    std::FILE* out = nullptr;
+    bool openFailed = false;
+    std::vector<std::string> lines;
+    std::unique_lock<std::mutex> lock(m_overrunMutex);
+    while (true) {
+        m_overrunWake.wait(lock, [this] { return m_overrunStop || !m_overrunQueue.empty(); });
+        lines.swap(m_overrunQueue);
+        const bool stop = m_overrunStop;
+        lock.unlock();
+
+        if (!lines.empty() && !out && !openFailed) {
+            out = std::fopen(m_overrunLogPath.c_str(), "a");
+            if (!out) {
+                LOG_ERROR("overrun_log_open_failed", "path", m_overrunLogPath);
+                openFailed = true;
+            }
+        }
+        if (out && !lines.empty()) {
+            for (const auto& line : lines) std::fputs(line.c_str(), out);
+            std::fflush(out);
+        }
+        lines.clear();
+
+        if (stop) break;
+        lock.lock();
+    }
+    if (out) std::fclose(out);
+}
+
+// Called on the tick thread when the game loop ends.
+void GameServer::PrintTickProfile() {
+    const PhaseHistograms& h = m_profiler.histograms();
+    const uint64_t ticks = h.phases[PHASE_TICK].count();
+    if (ticks == 0) return;
+
+    char buf[256];
+    std::snprintf(buf, sizeof(buf), "GameServer: %llu ticks, %llu over the %.1f ms budget (%llu not logged)",
+                  (unsigned long long)ticks, (unsigned long long)h.overruns.load(),
+                  m_profiler.getBudgetNs() / 1e6, (unsigned long long)m_overrunsSuppressed);
+    std::cout << buf << std::endl;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const LatencyHistogram& hist = h.phases[p];
+        if (hist.max() == 0) continue;
+        std::snprintf(buf, sizeof(buf), "  %-20s mean %8.3f  p50 %8.3f  p99 %8.3f  p99.9 %8.3f  max %8.3f ms",
+                      tickPhaseName(p), hist.sum() / 1e6 / (double)hist.count(), hist.percentile(0.50) / 1e6,
+                      hist.percentile(0.99) / 1e6, hist.percentile(0.999) / 1e6, hist.max() / 1e6);
+        std::cout << buf << std::endl;
+    }
+}
+
+void GameServer::WriteMetrics(PrometheusText& out) const {
+    out.Family("gummy_ingame_connections", "gauge", "Open client connections.");
+    out.Sample("gummy_ingame_connections", "", m_connectionCount.load(std::memory_order_relaxed));
+    out.Family("gummy_ingame_connections_accepted_total", "counter", "Client connections accepted.");
+    out.Sample("gummy_ingame_connections_accepted_total", "", (double)m_connectionsAccepted.load(std::memory_order_relaxed));
+
+    const int roomState = m_roomStateMetric.load(std::memory_order_relaxed);
+    out.Family("gummy_ingame_rooms", "gauge", "Rooms hosted by this process, by RoomState.");
+    for (int state = WAITING_FOR_PLAYERS; state <= GAME_OVER; state++) {
+        out.Sample("gummy_ingame_rooms", std::string("state=\"") + RoomStateName((RoomState)state) + "\"",
+                   roomState == state ? 1 : 0);
+    }
+
+    const PhaseHistograms& h = m_profiler.histograms();
+    out.Family("gummy_ingame_tick_phase_seconds", "histogram", "Time per tick spent in each phase; phase=\"tick\" is the whole tick.");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        out.Histogram("gummy_ingame_tick_phase_seconds", std::string("phase=\"") + tickPhaseName(p) + "\"", h.phases[p]);
+    }
+    out.Family("gummy_ingame_tick_overruns_total", "counter", "Ticks that took longer than the tick budget.");
+    out.Sample("gummy_ingame_tick_overruns_total", "", (double)h.overruns.load(std::memory_order_relaxed));
+
+    out.Family("gummy_ingame_send_queue_bytes", "gauge", "Unacknowledged bytes in client send queues after the last broadcast.");
+    out.Sample("gummy_ingame_send_queue_bytes", "stat=\"max\"", m_sendQueueMax.load(std::memory_order_relaxed));
+    out.Sample("gummy_ingame_send_queue_bytes", "stat=\"total\"", m_sendQueueTotal.load(std::memory_order_relaxed));
+
+    out.Family("gummy_ingame_ping_rtt_seconds", "histogram", "Ping round trips to clients.");
+    out.Histogram("gummy_ingame_ping_rtt_seconds", "", m_rttHistogram);
+    out.Family("gummy_ingame_player_rtt_seconds", "gauge", "Smoothed ping RTT of each seated connection.");
+    for (uint32_t p = 0; p < INGAME_MAX_PLAYERS; p++) {
+        const int64_t rtt = GetPlayerRttUs(p);
+        if (rtt >= 0) out.Sample("gummy_ingame_player_rtt_seconds", "player=\"" + std::to_string(p) + "\"", rtt / 1e6);
+    }
+    out.Family("gummy_ingame_player_rtt_jitter_seconds", "gauge", "Ping RTT variation of each seated connection.");
+    for (uint32_t p = 0; p < INGAME_MAX_PLAYERS; p++) {
+        const int64_t jitter = GetPlayerJitterUs(p);
+        if (jitter >= 0) out.Sample("gummy_ingame_player_rtt_jitter_seconds", "player=\"" + std::to_string(p) + "\"", jitter / 1e6);
+    }
+    out.Family("gummy_ingame_ping_timeouts_total", "counter", "Connections shut down after their pongs stopped.");
+    out.Sample("gummy_ingame_ping_timeouts_total", "", (double)m_pingTimeouts.load(std::memory_order_relaxed));
+}
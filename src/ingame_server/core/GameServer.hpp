@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -8,11 +9,18 @@
 #include <atomic>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <unordered_map>
 
 #include "../../common/network/TCPSocket.hpp"
+#include "../../common/metrics/MetricsServer.hpp"
 #include "../logic/GameRoom.hpp"
 #include "../logic/MapLoader.hpp"
+#include "../logic/MatchRecorder.hpp"
+#include "../logic/SolverBot.hpp"
+#include "../logic/TickProfiler.hpp"
+#include "../../common/utils/RttEstimator.hpp"
+#include "../../common/utils/WorkStealingPool.hpp"
 
 class GameServer {
 private:
@@ -30,13 +38,138 @@ private:
     std::vector<TCPSocket*> m_clients;
     std::unordered_map<int, uint32_t> m_fdToPlayerId;
 
+    // Compressed terrain still being streamed to a client after it joined. Registered
+    // under m_roomMutex at the captured version; the broadcast skips it until ready.
+    struct TerrainSync {
+        ResIngameTerrainSnapshot header{};
+        std::vector<char> data;
+        bool ready = false;
+    };
+    std::unordered_map<TCPSocket*, TerrainSync> m_terrainSyncs;
+
+    // Ping state of each connection. The tick thread pings every client once a second
+    // and shuts down connections whose pongs stopped; HandleClient feeds the pongs in.
+    struct ConnectionPing {
+        RttEstimator rtt;
+        uint32_t nextId = 0;
+        int64_t lastPingUs = 0;
+        int64_t lastPongUs = 0;
+    };
+    std::unordered_map<TCPSocket*, ConnectionPing> m_pings;
+
     uint32_t m_matchId;
     std::atomic<uint32_t> m_tick;
 
+    // Terrain regions changed during the last tick, drained when the snapshot is built
+    // and sent as a RES_INGAME_TERRAIN_DIFF tagged with the next terrain version.
+    std::vector<TerrainRect> m_dirtyRects;
+    uint32_t m_terrainVersion;
+
+    // Inputs are queued by client threads and applied at the start of the next tick,
+    // so the simulation only ever advances in fixed steps with a known input set.
+    std::mutex m_inputMutex;
+    struct PendingInput {
+        ReqIngameInput req;
+        int64_t receivedUs;
+    };
+    std::vector<PendingInput> m_pendingInputs;
+
+    // Last applied input of each seat, echoed in every snapshot so clients can time
+    // input -> ack. Guarded by m_roomMutex.
+    struct InputAck {
+        uint32_t seq = 0;
+        int64_t receivedUs = 0;
+        int64_t appliedUs = 0;
+    };
+    InputAck m_inputAcks[INGAME_MAX_PLAYERS];
+
+    MatchRecorder* m_recorder;
+    std::string m_mapPath;
+    uint32_t m_roomTick;
+
+    // Service server told about each finished recording, so it can fill in
+    // "Match".log_path; empty when there is none. The report runs on its own thread.
+    std::string m_serviceIp;
+    int m_servicePort;
+    std::thread m_reportThread;
+
+    // Empty seats are filled with solver bots once a lone player has waited
+    // m_botFillSeconds (< 0 disables). The pool is shared by every bot's solver.
+    float m_botFillSeconds;
+    uint32_t m_waitTicks;
+    WorkStealingPool* m_botPool;
+    std::vector<SolverBot*> m_bots;
+
+    // Phase timings of every tick. A tick over budget (kTickSeconds) is appended to
+    // m_overrunLogPath as one JSON line with its breakdown and the room state. The tick
+    // thread formats the line from m_overrunRoom, filled under the locks the broadcast
+    // already holds, and queues it; m_overrunThread owns the file.
+    TickProfiler m_profiler;
+    std::string m_overrunLogPath;
+    struct OverrunRoom {
+        RoomState state = WAITING_FOR_PLAYERS;
+        uint32_t roomTick = 0;
+        float turnTimer = 0.0f;
+        int currentPlayer = -1;
+        size_t projectiles = 0;
+        size_t debrisBodies = 0;
+        uint32_t terrainVersion = 0;
+        uint32_t terrainRevision = 0;
+        size_t bots = 0;
+        size_t playerCount = 0;
+        struct {
+            int id, hp;
+            bool alive, asleep;
+            float x, y, vx, vy;
+        } players[INGAME_MAX_PLAYERS] = {};
+        size_t clients = 0;
+        size_t terrainSyncs = 0;
+    };
+    OverrunRoom m_overrunRoom;   // tick thread only
+    std::thread m_overrunThread;
+    std::mutex m_overrunMutex;
+    std::condition_variable m_overrunWake;
+    std::vector<std::string> m_overrunQueue;
+    bool m_overrunStop;
+    size_t m_lastInputCount;
+    int64_t m_overrunSecond;
+    uint32_t m_overrunsThisSecond;
+    uint64_t m_overrunsSuppressed;
+
+    // Read by WriteMetrics from the metrics thread; written where they change, never
+    // under a lock the scrape would need.
+    std::atomic<int> m_connectionCount;
+    std::atomic<uint64_t> m_connectionsAccepted;
+    std::atomic<int> m_roomStateMetric;     // RoomState, -1 while nobody is seated
+    std::atomic<int> m_sendQueueMax;        // largest client send queue after the last broadcast
+    std::atomic<int> m_sendQueueTotal;
+    std::atomic<int64_t> m_seatRttUs[INGAME_MAX_PLAYERS];      // smoothed, -1 while unknown
+    std::atomic<int64_t> m_seatJitterUs[INGAME_MAX_PLAYERS];
+    std::atomic<uint64_t> m_pingTimeouts;
+    Metrics::Histogram m_rttHistogram;
+
     void HandleClient(TCPSocket* clientSocket);
     void GameLoop();
+    Player* AddPlayer(const std::string& name);
+    uint32_t ClaimOrphanedSeat(int fd);
+    bool CaptureTerrainSync(TerrainSync& out, MapLoader& terrain);
+    void CompressTerrainSync(TerrainSync& out, const MapLoader& terrain);
+    bool SendTerrainSyncChunk(TCPSocket* client, TerrainSync& sync);
+    void CreateRoom();
+    void FillEmptySeats();
+    void RunBots();
+    void DrainInputs();
+    void StartRecording();
+    void StopRecording();
+    void ReportRecording(const std::string& path);
     void BroadcastStateSnapshot();
     void RemoveClient(TCPSocket* clientSocket);
+    void PingClients();
+    void HandlePong(TCPSocket* clientSocket, const ResIngamePong& pong, int64_t receivedUs);
+    void CaptureOverrunRoom();
+    void LogOverrun(double lateMs);
+    void OverrunLogLoop();
+    void PrintTickProfile();
 
 public:
     GameServer();
@@ -44,6 +177,27 @@ public:
 
     void Run(int port = 9090);
     void Stop();
+
+    void SetBotFillSeconds(float seconds) { m_botFillSeconds = seconds; }
+    void SetOverrunLogPath(const std::string& path) { m_overrunLogPath = path; }
+    // "Match".match_id of the match this server hosts; it tags the recording and its report.
+    void SetMatchId(uint32_t matchId) { m_matchId = matchId; }
+    void SetServiceAddress(const std::string& ip, int port) { m_serviceIp = ip; m_servicePort = port; }
+
+    // Per-phase tick histograms; safe to read from any thread while the server runs.
+    const TickProfiler& GetTickProfiler() const { return m_profiler; }
+
+    // Smoothed ping RTT and jitter of the connection holding a seat, -1 while the seat has
+    // none or it has not answered a ping yet. For room placement; safe from any thread.
+    int64_t GetPlayerRttUs(uint32_t playerId) const;
+    int64_t GetPlayerJitterUs(uint32_t playerId) const;
+
+    // gummy_ingame_* metrics; safe to call from any thread, takes no locks.
+    void WriteMetrics(PrometheusText& out) const;
+
+    // Player/projectile/room fields of a RES_INGAME_STATE snapshot; before the match has
+    // started (no room) the seated players are reported as waiting.
+    static void FillStateSnapshot(const GameRoom* room, const std::vector<Player*>& seated, ResIngameState& out);
 };
 
 
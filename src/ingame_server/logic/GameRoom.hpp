@@ -2,8 +2,10 @@
 #include "Player.hpp"
 #include "PhysicsEngine.hpp"
 #include "MapLoader.hpp"
+#include "TerrainCollapse.hpp"
+#include "TickProfiler.hpp"
+#include "../../common/utils/Log.hpp"
 #include <vector>
-#include <iostream>
 #include <string>
 
 #define TIMER 10.0f
@@ -26,6 +28,7 @@ private:
     MapLoader* m_mapLoader;
     Player* m_pendingShooter;
     bool m_waitingForShot;
+    TerrainCollapse m_collapse;
     void switchTurn() {
         m_players[m_currentTurnIndex]->setTurn(false);
         m_players[m_currentTurnIndex]->stopMoving();
@@ -39,6 +42,8 @@ private:
         m_state = PLAYING_TURN;
         m_pendingShooter = nullptr;
         m_waitingForShot = false;
+        // Every shot of the finished turn is spent; don't carry them into snapshots.
+        m_projectiles.clear();
 
         m_physics->setWind(0);
     }
@@ -59,7 +64,7 @@ private:
             m_state = GAME_OVER;
             for (auto p : m_players) {
                 if (p->isAlive()) {
-                    std::cout << "Player " << p->getId() << " wins!" << std::endl;
+                    LOG_INFO("game_over", "winner", p->getId());
                 }
             }
         }
@@ -80,6 +85,9 @@ public:
     ~GameRoom() { delete m_physics; }
 
     void setMapLoader(MapLoader* mapLoader) { m_mapLoader = mapLoader; }
+    const MapLoader* getMapLoader() const { return m_mapLoader; }
+    const PhysicsEngine* getPhysics() const { return m_physics; }
+    const TerrainCollapse& getTerrainCollapse() const { return m_collapse; }
 
     const std::vector<Player*>& getPlayers() const { return m_players; }
     const std::vector<Projectile>& getProjectiles() const { return m_projectiles; }
@@ -91,18 +99,13 @@ public:
         return nullptr;
     }
 
-    bool consumeTerrainModified() {
-        if (!m_physics) return false;
-        if (!m_physics->hasTerrainBeenModified()) return false;
-        m_physics->resetTerrainModifiedFlag();
+    // Terrain regions changed since the last call (explosions); see MapLoader::markDirty.
+    bool drainDirtyRects(std::vector<TerrainRect>& out) {
+        if (!m_mapLoader || !m_mapLoader->hasDirtyRects()) return false;
+        m_mapLoader->drainDirtyRects(out);
         return true;
     }
 
-    bool consumeLastExplosion(float& outX, float& outY, float& outRadius) {
-        if (!m_physics) return false;
-        return m_physics->consumeLastExplosion(outX, outY, outRadius);
-    }
-
     void addPlayer(int id, std::string name) {
         float startX = 100.0f + m_players.size() * 200.0f;
         m_players.push_back(new Player(id, name, startX, 0, 0));
@@ -116,7 +119,7 @@ public:
             m_turnTimer = TIMER;
             m_pendingShooter = nullptr;
             m_waitingForShot = false;
-            std::cout << "Game Started! Player " << m_players[0]->getId() << "'s turn." << std::endl;
+            LOG_INFO("game_started", "players", m_players.size(), "first_turn", m_players[0]->getId());
         }
     }
 
@@ -179,13 +182,19 @@ public:
 
     // Backward-compatible update for existing code paths.
     void update(float deltaTime) {
+        TickProfiler::Scope scope(PHASE_ROOM_UPDATE);
         // Use real delta for physics on the server; clamp to keep stability.
         float physicsDt = deltaTime;
         if (physicsDt < 0.0f) physicsDt = 0.0f;
         if (physicsDt > 0.033f) physicsDt = 0.033f; // ~30 FPS worst-case step
 
         if (m_physics && m_mapLoader) {
-            m_physics->update(physicsDt, m_players, m_projectiles, m_mapLoader);
+            // With everyone asleep and nothing in flight an idle room costs no physics.
+            if (!m_physics->isAtRest(m_players, m_projectiles, *m_mapLoader)) {
+                m_physics->update(physicsDt, m_players, m_projectiles, m_mapLoader);
+            }
+            TickProfiler::Scope collapseScope(PHASE_COLLAPSE);
+            m_collapse.update(*m_mapLoader, PhysicsEngine::toSimDt(physicsDt), m_physics->getGravity());
         }
 
         if (m_state == PLAYING_TURN) {
@@ -197,7 +206,8 @@ public:
         }
 
         if (m_state == FIRING_PHASE) {
-            if (!hasActiveProjectile(m_projectiles)) {
+            // The turn ends once the shot and any debris it cut loose have come to rest.
+            if (!hasActiveProjectile(m_projectiles) && !m_collapse.isSettling()) {
                 checkWinCondition();
                 if (m_state != GAME_OVER) {
                     switchTurn();
@@ -206,11 +216,12 @@ public:
         }
     }
 
-    void handleInput(int playerId, std::string command, float value = 0.0f) {
-        if (m_state != PLAYING_TURN) return;
+    // Returns true when the command was accepted and applied to the room.
+    bool handleInput(int playerId, std::string command, float value = 0.0f) {
+        if (m_state != PLAYING_TURN) return false;
 
         Player* currentPlayer = m_players[m_currentTurnIndex];
-        if (currentPlayer->getId() != playerId) return;
+        if (currentPlayer->getId() != playerId) return false;
         if (command == "MOVE_LEFT") {
             currentPlayer->moveLeft();
             currentPlayer->setOrient(0);
@@ -229,6 +240,9 @@ public:
             if (currentPlayer->m_power > 100.0f) currentPlayer->m_power = 100.0f;
         } else if (command == "FIRE") {
             commitShot();
+        } else {
+            return false;
         }
+        return true;
     }
 };
\ No newline at end of file
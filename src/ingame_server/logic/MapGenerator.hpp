@@ -0,0 +1,190 @@
+#pragma once
+#include "MapLoader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Seeded terrain generator. The same (seed, size) always produces the same cells on
+// every platform: the whole pipeline is integer arithmetic, so a match only needs to
+// transmit the seed. The map name "procedural" (or "procedural:WxH") stands for a
+// generated map wherever a map file path is accepted.
+//
+// Terrain is layered 1D value noise for the ground line, a few smooth valleys cut into
+// it, and floating islands above it. Output goes straight into MapLoader tile rows, so
+// uniform tiles are never visited cell by cell.
+namespace MapGenerator {
+    constexpr const char* kMapName = "procedural";
+    constexpr int kDefaultWidth = 1280;
+    constexpr int kDefaultHeight = 720;
+    constexpr int kMinSize = 256;
+    constexpr int kMaxSize = 16384;
+
+    // Accepts "procedural" (default size) and "procedural:WxH".
+    inline bool ParseName(const std::string& name, int& width, int& height) {
+        const size_t prefix = std::strlen(kMapName);
+        if (name.compare(0, prefix, kMapName) != 0) return false;
+
+        width = kDefaultWidth;
+        height = kDefaultHeight;
+        if (name.size() == prefix) return true;
+
+        int w = 0, h = 0;
+        char tail = 0;
+        if (std::sscanf(name.c_str() + prefix, ":%dx%d%c", &w, &h, &tail) != 2) return false;
+        if (w < kMinSize || w > kMaxSize || h < kMinSize || h > kMaxSize) return false;
+        width = w;
+        height = h;
+        return true;
+    }
+
+    inline uint32_t Hash(uint32_t seed, uint32_t salt, int32_t i) {
+        uint32_t h = seed ^ (salt * 0x9E3779B9u) ^ ((uint32_t)i * 0x85EBCA6Bu);
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        h *= 0x846CA68Bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // Smoothstep-interpolated value noise in [-32768, 32767] with lattice spacing `period`.
+    inline int32_t Noise(uint32_t seed, uint32_t salt, int x, int period) {
+        const int cell = x / period;
+        const int64_t t = (int64_t)(x % period) * 65536 / period;
+        const int64_t s = (t * t * (3 * 65536 - 2 * t)) >> 32;
+        const int32_t a = (int32_t)(Hash(seed, salt, cell) & 0xFFFF) - 32768;
+        const int32_t b = (int32_t)(Hash(seed, salt, cell + 1) & 0xFFFF) - 32768;
+        return a + (int32_t)(((int64_t)(b - a) * s) >> 16);
+    }
+
+    inline void Generate(MapLoader& map, uint32_t seed, int width, int height) {
+        struct Octave {
+            int period;
+            int amplitude; // thousandths of the map height
+        };
+        static const Octave kOctaves[] = {{512, 180}, {192, 70}, {64, 25}, {16, 4}};
+
+        const int minGround = height * 25 / 100;
+        const int maxGround = height - 24;
+
+        // Ground line: y of the first solid cell in each column.
+        std::vector<int> ground(width);
+        for (int x = 0; x < width; ++x) {
+            int64_t y = height * 58 / 100;
+            for (uint32_t o = 0; o < sizeof(kOctaves) / sizeof(kOctaves[0]); ++o) {
+                const int amplitude = height * kOctaves[o].amplitude / 1000;
+                y += ((int64_t)Noise(seed, o + 1, x, kOctaves[o].period) * amplitude) >> 15;
+            }
+            ground[x] = (int)y;
+        }
+
+        // Valleys: a quartic bump pushed down into the ground line.
+        uint32_t salt = 100;
+        const int valleys = 1 + width / 1600 + (int)(Hash(seed, salt++, 0) & 1);
+        for (int v = 0; v < valleys; ++v) {
+            const int halfWidth = 90 + (int)(Hash(seed, salt++, v) % 110);
+            const int centre = width / 8 + (int)(Hash(seed, salt++, v) % (uint32_t)(width * 3 / 4));
+            const int64_t depth = height * 15 / 100 + Hash(seed, salt++, v) % (uint32_t)(height * 15 / 100 + 1);
+            const int64_t hw2 = (int64_t)halfWidth * halfWidth;
+
+            for (int x = std::max(centre - halfWidth, 0); x < std::min(centre + halfWidth, width); ++x) {
+                const int64_t u = hw2 - (int64_t)(x - centre) * (x - centre);
+                if (u > 0) ground[x] += (int)(depth * u / hw2 * u / hw2);
+            }
+        }
+        for (int x = 0; x < width; ++x) {
+            ground[x] = std::min(std::max(ground[x], minGround), maxGround);
+        }
+
+        // Floating islands: lens-shaped spans with a flat-ish top and a tapering underside,
+        // kept clear of the ground below and of each other.
+        std::vector<int> islandTop(width, 0);
+        std::vector<int> islandBottom(width, 0);
+        const int islands = width / 400 + (int)(Hash(seed, salt++, 0) % 3);
+        for (int i = 0; i < islands; ++i) {
+            const int halfWidth = 40 + (int)(Hash(seed, salt++, i) % 70);
+            const int thickness = 14 + (int)(Hash(seed, salt++, i) % 26);
+            if (width <= 2 * halfWidth) break;
+            const int centre = halfWidth + (int)(Hash(seed, salt++, i) % (uint32_t)(width - 2 * halfWidth));
+            const int x0 = centre - halfWidth;
+            const int x1 = centre + halfWidth;
+
+            bool overlaps = false;
+            int lowest = height;
+            for (int x = std::max(x0 - 48, 0); x < std::min(x1 + 48, width); ++x) {
+                if (islandBottom[x] > 0) overlaps = true;
+                lowest = std::min(lowest, ground[x]);
+            }
+            // Room for a player to walk underneath, and for one standing on top.
+            const int minCentre = height * 12 / 100 + 48;
+            const int maxCentre = lowest - 110 - thickness;
+            if (overlaps || maxCentre < minCentre) continue;
+            const int cy = minCentre + (int)(Hash(seed, salt++, i) % (uint32_t)(maxCentre - minCentre + 1));
+
+            const int64_t hw2 = (int64_t)halfWidth * halfWidth;
+            for (int x = x0; x < x1; ++x) {
+                const int64_t f = (hw2 - (int64_t)(x - centre) * (x - centre)) * 256 / hw2; // 0..256
+                const int top = cy - (int)(6 * f >> 8) + ((Noise(seed, salt, x, 24) * 3) >> 15);
+                const int bottom = cy + (int)(thickness * f * f >> 16);
+                if (bottom > top) {
+                    islandTop[x] = std::max(top, 0);
+                    islandBottom[x] = bottom;
+                }
+            }
+            salt++;
+        }
+
+        map.reset(width, height);
+        const int tilesX = (width + MapLoader::kTileSize - 1) / MapLoader::kTileSize;
+        for (int tx = 0; tx < tilesX; ++tx) {
+            const int x0 = tx * MapLoader::kTileSize;
+            const int x1 = std::min(x0 + MapLoader::kTileSize, width);
+
+            int groundMin = height, groundMax = 0;
+            int islandMin = height, islandMax = 0;
+            for (int x = x0; x < x1; ++x) {
+                groundMin = std::min(groundMin, ground[x]);
+                groundMax = std::max(groundMax, ground[x]);
+                if (islandBottom[x] > 0) {
+                    islandMin = std::min(islandMin, islandTop[x]);
+                    islandMax = std::max(islandMax, islandBottom[x]);
+                }
+            }
+
+            // Only rows crossing the ground line or an island need per-column tests.
+            for (int y = std::min(groundMin, islandMin); y < height; ++y) {
+                uint64_t bits = 0;
+                if (y >= groundMax) {
+                    bits = ~0ull;
+                } else if (y >= groundMin) {
+                    for (int x = x0; x < x1; ++x) {
+                        if (y >= ground[x]) bits |= 1ull << (x - x0);
+                    }
+                }
+                if (y >= islandMin && y < islandMax) {
+                    for (int x = x0; x < x1; ++x) {
+                        if (y >= islandTop[x] && y < islandBottom[x]) bits |= 1ull << (x - x0);
+                    }
+                }
+                if (bits) map.setTileRow(tx, y, bits);
+            }
+        }
+
+        map.generateSpawnPoints(seed);
+    }
+
+    // Resolves a map name the way every server and client entry point does: generated
+    // from the seed for "procedural[:WxH]", otherwise loaded from the file.
+    inline bool Load(MapLoader& map, const std::string& name, uint32_t seed) {
+        int width = 0, height = 0;
+        if (ParseName(name, width, height)) {
+            Generate(map, seed, width, height);
+            return true;
+        }
+        return map.loadMap(name, seed);
+    }
+}
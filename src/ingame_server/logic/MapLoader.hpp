@@ -1,69 +1,112 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <vector>
 #include <string>
 #include <fstream>
 #include <iostream>
-#include <cstdlib>
+#include <cstdint>
 #include <ctime>
 #include <cmath>
+#include <random>
 
 struct SpawnPoint {
     float x, y;
 };
 
+// Half-open cell rectangle [x, x + w) x [y, y + h).
+struct TerrainRect {
+    int x, y, w, h;
+};
+
+// Terrain is stored as kTileSize x kTileSize tiles. Tiles that are entirely air or
+// entirely solid are just a flag; only mixed tiles own a bitmap (one uint64_t per row),
+// so memory follows the amount of surface rather than the map area.
 class MapLoader {
 public:
-    MapLoader() : m_width(0), m_height(0) {}
+    static constexpr int kTileShift = 6;
+    static constexpr int kTileSize = 1 << kTileShift;
+    static constexpr int kHashChunkSize = kTileSize;
+
+    enum TileKind {
+        TILE_EMPTY,
+        TILE_SOLID,
+        TILE_MIXED
+    };
+
+    MapLoader() : m_width(0), m_height(0), m_seed(0), m_tilesX(0), m_tilesY(0), m_terrainHash(0), m_generation(0), m_revision(0) {}
 
     bool loadMap(const std::string& filePath) {
+        return loadMap(filePath, (uint32_t)std::time(nullptr));
+    }
+
+    // Spawn points are derived from the seed, so the same (file, seed) pair always
+    // produces the same map state. Match recordings rely on this.
+    bool loadMap(const std::string& filePath, uint32_t seed) {
         std::ifstream file(filePath);
         if (!file.is_open()) {
             return false;
         }
 
-        file >> m_width >> m_height;
-
-        m_collisionMask.resize(m_width * m_height);
+        int width = 0, height = 0;
+        file >> width >> height;
+        if (width <= 0 || height <= 0) {
+            return false;
+        }
+        reset(width, height);
 
         char input;
+        std::vector<uint64_t> row(m_tilesX);
         for (int y = 0; y < m_height; ++y) {
+            std::fill(row.begin(), row.end(), 0);
             for (int x = 0; x < m_width; ++x) {
                 file >> input;
-                int index = y * m_width + x;
-                m_collisionMask[index] = (input == '1');
+                if (input == '1') row[x >> kTileShift] |= 1ull << (x & kTileMask);
+            }
+            for (int tx = 0; tx < m_tilesX; ++tx) {
+                if (row[tx]) setTileRow(tx, y, row[tx]);
             }
         }
 
         file.close();
 
-        // Generate 2 random spawn X coordinates with a minimum separation.
-        static bool seeded = false;
-        if (!seeded) {
-            std::srand((unsigned)std::time(nullptr));
-            seeded = true;
-        }
+        m_dirtyRects.clear();
+        generateSpawnPoints(seed);
+        return true;
+    }
+
+    // Generate 2 random spawn points with a minimum horizontal separation, each standing
+    // on the topmost surface of its column. Columns without ground are skipped; if none
+    // is found the player drops in from the top of the map.
+    void generateSpawnPoints(uint32_t seed) {
+        m_seed = seed;
+        std::mt19937 rng(seed);
 
         m_spawnPoints.clear();
 
         const float minSeparation = 600.0f;
-        const float maxX = (m_width > 0) ? (float)(m_width - 1) : 0.0f;
+        const float maxX = (m_width > kPlayerSize) ? (float)(m_width - kPlayerSize) : 0.0f;
 
         auto randomX = [&]() -> float {
             if (maxX <= 0.0f) return 0.0f;
-            return (float)std::rand() / (float)RAND_MAX * maxX;
+            return (float)rng() / (float)std::mt19937::max() * maxX;
         };
 
-        float spawnX_1 = randomX();
-        float spawnX_2 = randomX();
-        int attempts = 0;
-        while (std::fabs(spawnX_1 - spawnX_2) < minSeparation && attempts++ < 2000) {
-            spawnX_2 = randomX();
-        }
+        auto pickSpawn = [&](const SpawnPoint* other) -> SpawnPoint {
+            SpawnPoint spawn{randomX(), 0.0f};
+            for (int attempts = 0; attempts < 2000; ++attempts) {
+                const float x = (attempts == 0) ? spawn.x : randomX();
+                if (other && std::fabs(x - other->x) < minSeparation) continue;
+                spawn.x = x;
+                if (findGround(x, spawn.y)) break;
+            }
+            return spawn;
+        };
 
-        m_spawnPoints.push_back({spawnX_1, 100.0f});
-        m_spawnPoints.push_back({spawnX_2, 100.0f});
-        
-        return true;
+        const SpawnPoint first = pickSpawn(nullptr);
+        m_spawnPoints.push_back(first);
+        m_spawnPoints.push_back(pickSpawn(&first));
     }
 
     bool isSolid(float x, float y) const {
@@ -73,27 +116,286 @@ public:
             return false;
         }
 
-        int index = (int)y * m_width + (int)x;
-        return m_collisionMask[index];
+        return getCell((int)x, (int)y);
+    }
+
+    // Cell access without the out-of-bounds rules of isSolid; callers stay in range.
+    bool getCell(int x, int y) const {
+        const int32_t tile = m_tiles[(y >> kTileShift) * m_tilesX + (x >> kTileShift)];
+        if (tile < 0) return tile == kTileSolid;
+        return (m_tileBits[tile][y & kTileMask] >> (x & kTileMask)) & 1u;
+    }
+
+    // Row y of tile column tileX as a bitmask (bit i = cell tileX * kTileSize + i).
+    // Bits past the right edge of the map are unspecified.
+    uint64_t getTileRow(int tileX, int y) const {
+        const int32_t tile = m_tiles[(y >> kTileShift) * m_tilesX + tileX];
+        if (tile < 0) return tile == kTileSolid ? ~0ull : 0ull;
+        return m_tileBits[tile][y & kTileMask];
+    }
+
+    TileKind getTileKind(int tileX, int tileY) const {
+        const int32_t tile = m_tiles[tileY * m_tilesX + tileX];
+        if (tile == kTileEmpty) return TILE_EMPTY;
+        return tile == kTileSolid ? TILE_SOLID : TILE_MIXED;
+    }
+
+    int getTilesX() const { return m_tilesX; }
+    int getTilesY() const { return m_tilesY; }
+
+    // Writes cells [x, x + w) of row y to out as one 32-bit value each, `solid` or `air`
+    // (e.g. texture pixels). Works a tile row at a time: uniform runs are a fill and
+    // mixed ones a branchless expansion of the row's bits. Callers stay in range.
+    void expandRow(int y, int x, int w, uint32_t solid, uint32_t air, uint32_t* out) const {
+        const uint32_t diff = solid ^ air;
+        const int end = x + w;
+        while (x < end) {
+            const int tileX = x >> kTileShift;
+            const int stop = std::min(end, (tileX + 1) << kTileShift);
+            const int count = stop - x;
+            uint64_t bits = getTileRow(tileX, y) >> (x & kTileMask);
+            const uint64_t mask = (count == kTileSize) ? ~0ull : ((1ull << count) - 1);
+            if ((bits & mask) == 0) {
+                std::fill(out, out + count, air);
+            } else if ((bits & mask) == mask) {
+                std::fill(out, out + count, solid);
+            } else {
+                for (int i = 0; i < count; ++i, bits >>= 1) {
+                    out[i] = air ^ (diff & (0u - (uint32_t)(bits & 1u)));
+                }
+            }
+            out += count;
+            x = stop;
+        }
+    }
+
+    // Flips a horizontal run of cells (used to apply replay terrain diffs).
+    void flipSpan(int y, int x, int length) {
+        if (y < 0 || y >= m_height) return;
+        const int begin = std::max(x, 0);
+        const int end = std::min(x + length, m_width);
+        for (int cx = begin; cx < end; ++cx) {
+            setCell(cx, y, !getCell(cx, y));
+        }
+        markDirty(begin, y, end, y + 1);
+    }
+
+    // Row-major bitmap of the whole mask, 8 cells per byte, LSB first.
+    void packCells(std::vector<uint8_t>& out) const {
+        out.assign(((size_t)m_width * m_height + 7) / 8, 0);
+        size_t i = 0;
+        for (int y = 0; y < m_height; ++y) {
+            for (int x = 0; x < m_width; ++x, ++i) {
+                if (getCell(x, y)) out[i >> 3] |= (uint8_t)(1u << (i & 7));
+            }
+        }
+    }
+
+    // Replaces the mask with a packCells() bitmap (the size may change). The whole
+    // map is marked dirty. Spawn points are left alone.
+    bool unpackCells(int width, int height, const uint8_t* bits, size_t size) {
+        if (width <= 0 || height <= 0 || size < ((size_t)width * height + 7) / 8) return false;
+
+        reset(width, height);
+        std::vector<uint64_t> row(m_tilesX);
+        size_t i = 0;
+        for (int y = 0; y < m_height; ++y) {
+            std::fill(row.begin(), row.end(), 0);
+            for (int x = 0; x < m_width; ++x, ++i) {
+                if ((bits[i >> 3] >> (i & 7)) & 1u) row[x >> kTileShift] |= 1ull << (x & kTileMask);
+            }
+            for (int tx = 0; tx < m_tilesX; ++tx) {
+                if (row[tx]) setTileRow(tx, y, row[tx]);
+            }
+        }
+
+        m_dirtyRects.clear();
+        markDirty(0, 0, m_width, m_height);
+        return true;
+    }
+
+    // Sets a horizontal run of cells (used to apply network terrain diffs).
+    void fillSpan(int y, int x, int length, bool solid) {
+        if (y < 0 || y >= m_height) return;
+        const int begin = std::max(x, 0);
+        const int end = std::min(x + length, m_width);
+        bool changed = false;
+        for (int cx = begin; cx < end; ++cx) {
+            if (getCell(cx, y) == solid) continue;
+            setCell(cx, y, solid);
+            changed = true;
+        }
+        if (changed) markDirty(begin, y, end, y + 1);
     }
 
     void applyExplosion(float x, float y, float radius) {
-        int minX = (int)(x - radius);
-        int maxX = (int)(x + radius);
-        int minY = (int)(y - radius);
-        int maxY = (int)(y + radius);
+        int minX = std::max((int)(x - radius), 0);
+        int maxX = std::min((int)(x + radius), m_width - 1);
+        int minY = std::max((int)(y - radius), 0);
+        int maxY = std::min((int)(y + radius), m_height - 1);
 
+        // The carved cells of each tile row are collected into one mask, so the row's
+        // hash and counts are updated once rather than per cell.
+        bool changed = false;
         for (int cy = minY; cy <= maxY; ++cy) {
-            for (int cx = minX; cx <= maxX; ++cx) {
-                if (cx >= 0 && cx < m_width && cy >= 0 && cy < m_height) {
-                    float dx = cx - x;
-                    float dy = cy - y;
-                    if ((dx * dx + dy * dy) <= (radius * radius)) {
-                        m_collisionMask[cy * m_width + cx] = false;
-                    }
+            const float dy = cy - y;
+            for (int tileX = minX >> kTileShift; tileX <= maxX >> kTileShift; ++tileX) {
+                const uint64_t row = getTileRow(tileX, cy);
+                if (row == 0) continue;
+                const int begin = std::max(minX, tileX << kTileShift);
+                const int end = std::min(maxX, ((tileX + 1) << kTileShift) - 1);
+                uint64_t carved = 0;
+                for (int cx = begin; cx <= end; ++cx) {
+                    const float dx = cx - x;
+                    if ((dx * dx + dy * dy) <= (radius * radius)) carved |= 1ull << (cx & kTileMask);
+                }
+                if (row & carved) {
+                    setTileRow(tileX, cy, row & ~carved);
+                    changed = true;
                 }
             }
         }
+        if (changed) markDirty(minX, minY, maxX + 1, maxY + 1);
+    }
+
+    // Records that cells in [minX, maxX) x [minY, maxY) changed. Rects are clipped to
+    // the map and merged with any rect they overlap or touch, so a burst of nearby
+    // explosions collapses into a few regions. Past kMaxDirtyRects everything is folded
+    // into one bounding rect to keep consumers' work bounded.
+    void markDirty(int minX, int minY, int maxX, int maxY) {
+        minX = std::max(minX, 0);
+        minY = std::max(minY, 0);
+        maxX = std::min(maxX, m_width);
+        maxY = std::min(maxY, m_height);
+        if (minX >= maxX || minY >= maxY) return;
+
+        TerrainRect rect{minX, minY, maxX - minX, maxY - minY};
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (size_t i = 0; i < m_dirtyRects.size(); ++i) {
+                const TerrainRect& other = m_dirtyRects[i];
+                if (other.x > rect.x + rect.w || rect.x > other.x + other.w ||
+                    other.y > rect.y + rect.h || rect.y > other.y + other.h) {
+                    continue;
+                }
+                rect = unionRect(rect, other);
+                m_dirtyRects[i] = m_dirtyRects.back();
+                m_dirtyRects.pop_back();
+                merged = true;
+                break;
+            }
+        }
+        m_dirtyRects.push_back(rect);
+
+        if (m_dirtyRects.size() > kMaxDirtyRects) {
+            TerrainRect all = m_dirtyRects[0];
+            for (const auto& r : m_dirtyRects) all = unionRect(all, r);
+            m_dirtyRects.assign(1, all);
+        }
+    }
+
+    bool hasDirtyRects() const { return !m_dirtyRects.empty(); }
+    const std::vector<TerrainRect>& getDirtyRects() const { return m_dirtyRects; }
+
+    // Appends the regions changed since the last drain and forgets them.
+    void drainDirtyRects(std::vector<TerrainRect>& out) {
+        out.insert(out.end(), m_dirtyRects.begin(), m_dirtyRects.end());
+        m_dirtyRects.clear();
+    }
+
+    void clearDirtyRects() { m_dirtyRects.clear(); }
+
+    // Terrain hashes for desync detection. Each non-empty tile row contributes a 64-bit
+    // key of its position and contents, XORed into its kHashChunkSize x kHashChunkSize
+    // chunk and into the root, so every cell change updates both in O(1) and equal
+    // masks always hash equal.
+    uint64_t getTerrainHash() const { return m_terrainHash; }
+    const std::vector<uint64_t>& getChunkHashes() const { return m_chunkHashes; }
+    int getHashChunksX() const { return m_tilesX; }
+    int getHashChunksY() const { return m_tilesY; }
+
+    // Hash chunks are the storage tiles.
+    TerrainRect getHashChunkRect(int index) const {
+        const int x = (index % m_tilesX) * kTileSize;
+        const int y = (index / m_tilesX) * kTileSize;
+        return {x, y, std::min(kTileSize, m_width - x), std::min(kTileSize, m_height - y)};
+    }
+
+    // Tiles that currently own a bitmap (neither all air nor all solid).
+    size_t getMixedTileCount() const { return m_tileBits.size() - m_freeTiles.size(); }
+
+    // Approximate heap use of the terrain storage.
+    size_t getTerrainBytes() const {
+        return m_tiles.capacity() * sizeof(int32_t) +
+               m_tileBits.capacity() * sizeof(TileBits) +
+               m_tileCounts.capacity() * sizeof(uint16_t) +
+               m_freeTiles.capacity() * sizeof(int32_t) +
+               m_chunkHashes.capacity() * sizeof(uint64_t);
+    }
+
+    // Replaces the map with an all-air one of the given size; hashes of an empty map
+    // are all zero. Generators follow this with setTileRow() calls.
+    void reset(int width, int height) {
+        m_width = width;
+        m_height = height;
+        m_tilesX = (width + kTileSize - 1) / kTileSize;
+        m_tilesY = (height + kTileSize - 1) / kTileSize;
+        m_tiles.assign((size_t)m_tilesX * m_tilesY, kTileEmpty);
+        m_tileBits.clear();
+        m_tileCounts.clear();
+        m_freeTiles.clear();
+        m_chunkHashes.assign(m_tiles.size(), 0);
+        m_terrainHash = 0;
+        m_spawnPoints.clear();
+        m_dirtyRects.clear();
+        m_tileChanged.assign(m_tiles.size(), 0);
+        m_changedTiles.clear();
+        m_generation++;
+        m_revision++;
+    }
+
+    // Bumped by every reset(); holders of per-tile state rebuild it when this changes.
+    uint32_t getGeneration() const { return m_generation; }
+
+    // Bumped whenever any cell changes (and by reset()); a cheap "has anything moved" test.
+    uint32_t getRevision() const { return m_revision; }
+
+    // Appends the indices of tiles written since the last drain (each at most once).
+    // Unlike the dirty rects this is exact and never folded; it feeds connectivity tracking.
+    void drainChangedTiles(std::vector<int>& out) {
+        for (int t : m_changedTiles) m_tileChanged[t] = 0;
+        out.insert(out.end(), m_changedTiles.begin(), m_changedTiles.end());
+        m_changedTiles.clear();
+    }
+
+    // Overwrites row y of tile column tileX (bit i = cell tileX * kTileSize + i) and keeps
+    // the tile flags and hashes current. Bits past the right edge are ignored. Does not
+    // mark anything dirty.
+    void setTileRow(int tileX, int y, uint64_t bits) {
+        const uint64_t mask = tileRowMask(tileX);
+        bits &= mask;
+        const uint64_t old = getTileRow(tileX, y) & mask;
+        if (old == bits) return;
+
+        const int t = (y >> kTileShift) * m_tilesX + tileX;
+        int32_t tile = m_tiles[t];
+        if (tile < 0) tile = materializeTile(t);
+        if (!m_tileChanged[t]) {
+            m_tileChanged[t] = 1;
+            m_changedTiles.push_back(t);
+        }
+        m_revision++;
+        m_tileBits[tile][y & kTileMask] = bits;
+
+        const uint64_t delta = rowKey(tileX, y, old) ^ rowKey(tileX, y, bits);
+        m_chunkHashes[t] ^= delta;
+        m_terrainHash ^= delta;
+
+        uint16_t& count = m_tileCounts[tile];
+        count = (uint16_t)(count + std::bitset<64>(bits).count() - std::bitset<64>(old).count());
+        if (count == 0) releaseTile(t, kTileEmpty);
+        else if (count == tileCellCount(t)) releaseTile(t, kTileSolid);
     }
 
     const std::vector<SpawnPoint>& getSpawnPoints() const {
@@ -102,10 +404,126 @@ public:
 
     int getWidth() const { return m_width; }
     int getHeight() const { return m_height; }
+    uint32_t getSeed() const { return m_seed; }
 
 private:
+    static constexpr size_t kMaxDirtyRects = 16;
+    static constexpr int kTileMask = kTileSize - 1;
+    static constexpr int32_t kTileEmpty = -1;
+    static constexpr int32_t kTileSolid = -2;
+
+    using TileBits = std::array<uint64_t, kTileSize>;
+
+    static constexpr int kPlayerSize = 32;
+
+    // splitmix64 finaliser.
+    static uint64_t mix64(uint64_t z) {
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Every mutation after load goes through here so the hashes stay current.
+    void setCell(int x, int y, bool solid) {
+        const int tileX = x >> kTileShift;
+        const uint64_t bit = 1ull << (x & kTileMask);
+        const uint64_t row = getTileRow(tileX, y);
+        setTileRow(tileX, y, solid ? (row | bit) : (row & ~bit));
+    }
+
+    // Hash contribution of one tile row; an all-air row contributes nothing.
+    static uint64_t rowKey(int tileX, int y, uint64_t bits) {
+        if (bits == 0) return 0;
+        return mix64(bits ^ mix64((uint64_t)(uint32_t)y << 32 | (uint32_t)tileX));
+    }
+
+    // In-map bits of a row of tile column tileX.
+    uint64_t tileRowMask(int tileX) const {
+        const int w = std::min(kTileSize, m_width - tileX * kTileSize);
+        return (w == kTileSize) ? ~0ull : ((1ull << w) - 1);
+    }
+
+    // Cells of tile t that lie inside the map (edge tiles are partial).
+    int tileCellCount(int t) const {
+        const int w = std::min(kTileSize, m_width - (t % m_tilesX) * kTileSize);
+        const int h = std::min(kTileSize, m_height - (t / m_tilesX) * kTileSize);
+        return w * h;
+    }
+
+    // Gives the uniform tile t a bitmap holding its current contents.
+    int32_t materializeTile(int t) {
+        int32_t index;
+        if (!m_freeTiles.empty()) {
+            index = m_freeTiles.back();
+            m_freeTiles.pop_back();
+        } else {
+            index = (int32_t)m_tileBits.size();
+            m_tileBits.emplace_back();
+            m_tileCounts.push_back(0);
+        }
+
+        TileBits& bits = m_tileBits[index];
+        bits.fill(0);
+        m_tileCounts[index] = 0;
+        if (m_tiles[t] == kTileSolid) {
+            const int w = std::min(kTileSize, m_width - (t % m_tilesX) * kTileSize);
+            const int h = std::min(kTileSize, m_height - (t / m_tilesX) * kTileSize);
+            const uint64_t mask = (w == kTileSize) ? ~0ull : ((1ull << w) - 1);
+            for (int y = 0; y < h; ++y) bits[y] = mask;
+            m_tileCounts[index] = (uint16_t)(w * h);
+        }
+
+        m_tiles[t] = index;
+        return index;
+    }
+
+    void releaseTile(int t, int32_t uniform) {
+        m_freeTiles.push_back(m_tiles[t]);
+        m_tiles[t] = uniform;
+    }
+
+    // Top-left of a player standing on the first solid cell below the top of the map in
+    // the column under its feet.
+    bool findGround(float x, float& y) const {
+        const int column = std::min(std::max((int)x + kPlayerSize / 2, 0), m_width - 1);
+        for (int cy = kPlayerSize; cy < m_height; ++cy) {
+            if (!getCell(column, cy)) continue;
+            // Solid within a body height of the top: nowhere to stand.
+            for (int above = cy - kPlayerSize; above < cy; ++above) {
+                if (getCell(column, above)) return false;
+            }
+            y = (float)(cy - kPlayerSize);
+            return true;
+        }
+        return false;
+    }
+
+    static TerrainRect unionRect(const TerrainRect& a, const TerrainRect& b) {
+        const int minX = std::min(a.x, b.x);
+        const int minY = std::min(a.y, b.y);
+        const int maxX = std::max(a.x + a.w, b.x + b.w);
+        const int maxY = std::max(a.y + a.h, b.y + b.h);
+        return {minX, minY, maxX - minX, maxY - minY};
+    }
+
     int m_width;
     int m_height;
-    std::vector<bool> m_collisionMask;
+    uint32_t m_seed;
     std::vector<SpawnPoint> m_spawnPoints;
+    std::vector<TerrainRect> m_dirtyRects;
+
+    int m_tilesX;
+    int m_tilesY;
+    std::vector<int32_t> m_tiles; // kTileEmpty, kTileSolid or an index into m_tileBits
+    std::vector<TileBits> m_tileBits;
+    std::vector<uint16_t> m_tileCounts; // solid cells per bitmap
+    std::vector<int32_t> m_freeTiles;
+    std::vector<uint64_t> m_chunkHashes;
+    uint64_t m_terrainHash;
+
+    uint32_t m_generation;
+    uint32_t m_revision;
+    std::vector<uint8_t> m_tileChanged;
+    std::vector<int> m_changedTiles;
 };
\ No newline at end of file
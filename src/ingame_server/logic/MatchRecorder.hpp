@@ -0,0 +1,274 @@
+#pragma once
+#include "GameRoom.hpp"
+#include "../../common/network/PacketStructs.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Compact input-log recording of a match.
+//
+// The simulation is deterministic for a given map, spawn set and per-tick input
+// stream, so instead of storing every ResIngameState we only store:
+//   header  : magic, version, match id, RNG seed, tick length, map name, players
+//   records : varint tick delta, (playerId << 4 | command), optional float value
+//   end     : varint tick delta, 0xFF marker, final state hash
+// A typical match is a few kilobytes.
+
+#define MATCH_RECORDING_MAGIC 0x43524D47u // "GMRC"
+#define MATCH_RECORDING_VERSION 1u
+#define MATCH_RECORDING_END_MARKER 0xFFu
+
+struct RecordedPlayer {
+    uint32_t id;
+    float x;
+    float y;
+    uint8_t orient;
+    char name[32];
+};
+
+struct RecordedInput {
+    uint32_t tick;
+    uint8_t playerId;
+    uint8_t command; // InGameCommand
+    float value;
+};
+
+struct MatchRecordingInfo {
+    uint32_t matchId;
+    uint32_t seed;
+    float tickSeconds;
+    std::string mapName;
+    std::vector<RecordedPlayer> players;
+};
+
+namespace MatchRecording {
+    // Maps the wire command to the GameRoom::handleInput command string.
+    inline const char* CommandToString(uint32_t command) {
+        switch (command) {
+            case INGAME_CMD_MOVE_LEFT:
+                return "MOVE_LEFT";
+            case INGAME_CMD_MOVE_RIGHT:
+                return "MOVE_RIGHT";
+            case INGAME_CMD_STOP:
+                return "STOP";
+            case INGAME_CMD_ADJUST_ANGLE:
+                return "ADJUST_ANGLE";
+            case INGAME_CMD_ADJUST_POWER:
+                return "ADJUST_POWER";
+            case INGAME_CMD_FIRE:
+                return "FIRE";
+            default:
+                return nullptr;
+        }
+    }
+
+    inline bool CommandHasValue(uint32_t command) {
+        return command == INGAME_CMD_ADJUST_ANGLE || command == INGAME_CMD_ADJUST_POWER;
+    }
+
+    // FNV-1a over the gameplay-relevant player state; used to verify re-simulation.
+    inline uint64_t ComputeStateHash(const GameRoom& room) {
+        uint64_t hash = 1469598103934665603ull;
+        auto mix = [&hash](const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+
+        for (const Player* p : room.getPlayers()) {
+            if (!p) continue;
+            const int id = p->getId();
+            const int hp = p->getHP();
+            const Position pos = p->getPosition();
+            mix(&id, sizeof(id));
+            mix(&hp, sizeof(hp));
+            mix(&pos.x, sizeof(pos.x));
+            mix(&pos.y, sizeof(pos.y));
+            mix(&p->m_angle, sizeof(p->m_angle));
+            mix(&p->m_power, sizeof(p->m_power));
+        }
+        const uint32_t state = (uint32_t)room.getState();
+        mix(&state, sizeof(state));
+        return hash;
+    }
+}
+
+class MatchRecorder {
+public:
+    MatchRecorder() : m_lastTick(0), m_inputCount(0) {}
+    ~MatchRecorder() { close(m_lastTick, 0); }
+
+    bool open(const std::string& path, const MatchRecordingInfo& info) {
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_file.is_open()) return false;
+
+        m_path = path;
+        m_lastTick = 0;
+        m_inputCount = 0;
+
+        writeU32(MATCH_RECORDING_MAGIC);
+        writeU32(MATCH_RECORDING_VERSION);
+        writeU32(info.matchId);
+        writeU32(info.seed);
+        writeFloat(info.tickSeconds);
+
+        char mapName[64] = {0};
+        std::strncpy(mapName, info.mapName.c_str(), sizeof(mapName) - 1);
+        m_file.write(mapName, sizeof(mapName));
+
+        const uint8_t playerCount = (uint8_t)info.players.size();
+        m_file.put((char)playerCount);
+        for (const auto& p : info.players) {
+            writeU32(p.id);
+            writeFloat(p.x);
+            writeFloat(p.y);
+            m_file.put((char)p.orient);
+            m_file.write(p.name, sizeof(p.name));
+        }
+        return m_file.good();
+    }
+
+    bool isOpen() const { return m_file.is_open(); }
+    const std::string& getPath() const { return m_path; }
+    uint32_t getInputCount() const { return m_inputCount; }
+
+    void recordInput(uint32_t tick, uint32_t playerId, uint32_t command, float value) {
+        if (!m_file.is_open()) return;
+
+        writeVarint(tick - m_lastTick);
+        m_lastTick = tick;
+        m_file.put((char)(((playerId & 0x0F) << 4) | (command & 0x0F)));
+        if (MatchRecording::CommandHasValue(command)) {
+            writeFloat(value);
+        }
+        m_inputCount++;
+    }
+
+    void close(uint32_t finalTick, uint64_t finalStateHash) {
+        if (!m_file.is_open()) return;
+
+        writeVarint(finalTick >= m_lastTick ? finalTick - m_lastTick : 0);
+        m_file.put((char)MATCH_RECORDING_END_MARKER);
+        m_file.write(reinterpret_cast<const char*>(&finalStateHash), sizeof(finalStateHash));
+        m_file.close();
+    }
+
+private:
+    void writeU32(uint32_t v) { m_file.write(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    void writeFloat(float v) { m_file.write(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+    void writeVarint(uint32_t v) {
+        while (v >= 0x80) {
+            m_file.put((char)((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        m_file.put((char)v);
+    }
+
+    std::ofstream m_file;
+    std::string m_path;
+    uint32_t m_lastTick;
+    uint32_t m_inputCount;
+};
+
+// Reads back a recording produced by MatchRecorder.
+class MatchRecordingReader {
+public:
+    MatchRecordingInfo info;
+    std::vector<RecordedInput> inputs;
+    uint32_t finalTick = 0;
+    uint64_t finalStateHash = 0;
+    bool complete = false;
+
+    bool load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+
+        m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        m_offset = 0;
+        inputs.clear();
+        info.players.clear();
+        finalTick = 0;
+        finalStateHash = 0;
+        complete = false;
+
+        uint32_t magic = 0, version = 0;
+        if (!readU32(magic) || magic != MATCH_RECORDING_MAGIC) return false;
+        if (!readU32(version) || version != MATCH_RECORDING_VERSION) return false;
+        if (!readU32(info.matchId) || !readU32(info.seed) || !readFloat(info.tickSeconds)) return false;
+
+        char mapName[64];
+        if (!readBytes(mapName, sizeof(mapName))) return false;
+        mapName[sizeof(mapName) - 1] = '\0';
+        info.mapName = mapName;
+
+        uint8_t playerCount = 0;
+        if (!readBytes(&playerCount, 1)) return false;
+        for (uint8_t i = 0; i < playerCount; i++) {
+            RecordedPlayer p{};
+            if (!readU32(p.id) || !readFloat(p.x) || !readFloat(p.y) ||
+                !readBytes(&p.orient, 1) || !readBytes(p.name, sizeof(p.name))) {
+                return false;
+            }
+            p.name[sizeof(p.name) - 1] = '\0';
+            info.players.push_back(p);
+        }
+
+        // A recording cut short by a crash is still usable up to its last full record.
+        uint32_t tick = 0;
+        while (m_offset < m_data.size()) {
+            uint32_t delta = 0;
+            uint8_t tag = 0;
+            if (!readVarint(delta) || !readBytes(&tag, 1)) break;
+            tick += delta;
+
+            if (tag == MATCH_RECORDING_END_MARKER) {
+                finalTick = tick;
+                complete = readBytes(&finalStateHash, sizeof(finalStateHash));
+                break;
+            }
+
+            RecordedInput in{};
+            in.tick = tick;
+            in.playerId = (uint8_t)(tag >> 4);
+            in.command = (uint8_t)(tag & 0x0F);
+            in.value = 0.0f;
+            if (MatchRecording::CommandHasValue(in.command) && !readFloat(in.value)) break;
+            inputs.push_back(in);
+            finalTick = tick;
+        }
+
+        m_data.clear();
+        m_data.shrink_to_fit();
+        return true;
+    }
+
+private:
+    bool readBytes(void* out, size_t size) {
+        if (m_offset + size > m_data.size()) return false;
+        std::memcpy(out, m_data.data() + m_offset, size);
+        m_offset += size;
+        return true;
+    }
+    bool readU32(uint32_t& v) { return readBytes(&v, sizeof(v)); }
+    bool readFloat(float& v) { return readBytes(&v, sizeof(v)); }
+
+    bool readVarint(uint32_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t byte = 0;
+            if (!readBytes(&byte, 1)) return false;
+            v |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    std::vector<char> m_data;
+    size_t m_offset = 0;
+};
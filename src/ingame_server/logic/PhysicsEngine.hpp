@@ -1,6 +1,8 @@
 #pragma once
 #include "Player.hpp"
 #include "MapLoader.hpp"
+#include "TickProfiler.hpp"
+#include "../../common/utils/Log.hpp"
 #include <vector>
 #include <cmath>
 
@@ -17,114 +19,172 @@ class PhysicsEngine {
 private:
     const float GRAVITY;
     float WIND;
-    bool m_terrainModified;
-    bool m_hasLastExplosion;
-    float m_lastExplosionX;
-    float m_lastExplosionY;
-    float m_lastExplosionRadius;
+    uint32_t m_terrainRevision; // MapLoader revision sleeping players were last checked against
 
     bool checkCollision(const Projectile& proj, const Player* p) {
-        float dx = proj.position.x - p->getPosition().x;
-        float dy = proj.position.y - p->getPosition().y;
-        return (std::sqrt(dx*dx + dy*dy) < 20.0f);
+        return hitsPlayer(proj, p->getPosition());
     }
 
 public:
     PhysicsEngine()
                 : GRAVITY(0.98f),
           WIND(0.0f),
-          m_terrainModified(false),
-          m_hasLastExplosion(false),
-          m_lastExplosionX(0.0f),
-          m_lastExplosionY(0.0f),
-          m_lastExplosionRadius(0.0f) {}
-
-    bool hasTerrainBeenModified() const { return m_terrainModified; }
-    void resetTerrainModifiedFlag() { m_terrainModified = false; }
-
-    bool consumeLastExplosion(float& outX, float& outY, float& outRadius) {
-        if (!m_hasLastExplosion) return false;
-        outX = m_lastExplosionX;
-        outY = m_lastExplosionY;
-        outRadius = m_lastExplosionRadius;
-        m_hasLastExplosion = false;
-        return true;
-    }
+          m_terrainRevision(0) {}
 
-    void update(float deltaTime, std::vector<Player*>& players, std::vector<Projectile>& projectiles, MapLoader* map) {
-        // The game constants (SPEED, GRAVITY, power -> velocity) are tuned for a ~60 FPS fixed step.
-        // The engine provides deltaTime in seconds, so convert to a 60 FPS-scaled step to avoid
-        // slow-motion movement/projectiles.
+    float getGravity() const { return GRAVITY; }
+    float getWind() const { return WIND; }
+
+    // The game constants (SPEED, GRAVITY, power -> velocity) are tuned for a ~60 FPS fixed step.
+    // The engine provides deltaTime in seconds, so convert to a 60 FPS-scaled step to avoid
+    // slow-motion movement/projectiles.
+    static float toSimDt(float deltaTime) {
         float simDt = deltaTime * gameSpeed;
         if (simDt < 0.0f) simDt = 0.0f;
         if (simDt > 3.0f) simDt = 3.0f; // clamp (prevents huge jumps on stalls)
+        return simDt;
+    }
 
-        // Update players
-        for (auto p : players) {
-            if(!p->isAlive()) continue;
+    // One integration step of a projectile; shared with the bot trajectory solver.
+    static void integrateProjectile(Projectile& proj, float simDt, float gravity, float wind) {
+        // Apply gravity
+        proj.velocity.vy += gravity * simDt;
+
+        // Apply wind
+        proj.velocity.vx += wind * simDt;
+
+        // Update position
+        proj.position.x += proj.velocity.vx * simDt;
+        proj.position.y += proj.velocity.vy * simDt;
+    }
+
+    static bool isOutOfBounds(const Projectile& proj, const MapLoader& map) {
+        return proj.position.x < 0 || proj.position.x > map.getWidth() ||
+               proj.position.y < 0 || proj.position.y > map.getHeight();
+    }
 
-            // Apply gravity
-            p->m_velocity.vy += GRAVITY * simDt;
+    static bool hitsPlayer(const Projectile& proj, const Position& playerPos) {
+        float dx = proj.position.x - playerPos.x;
+        float dy = proj.position.y - playerPos.y;
+        return (std::sqrt(dx*dx + dy*dy) < 20.0f);
+    }
 
-            // Apply velocity
-            p->m_position.x += p->m_velocity.vx * simDt;
-            p->m_position.y += p->m_velocity.vy * simDt;
+    // Initial projectile state for a shot from `from` (orient: true = facing right).
+    static Projectile launchProjectile(const Position& from, float angle, float power) {
+        float rad = angle * (PI / 180.0f);
+        Projectile proj;
+        proj.position.x = from.x;
+        proj.position.y = from.y - 20;
+        proj.position.orient = from.orient;
+        float directionMult = from.orient ? 1.0f : -1.0f;
 
-            // --- NEW: PIXEL-PERFECT COLLISION ---
+        proj.velocity.vx = std::cos(rad) * power * 1.0f * directionMult;
+        proj.velocity.vy = -std::sin(rad) * power * 1.0f;
+        proj.isActive = true;
+        return proj;
+    }
+
+    // A player rests when its feet are in air directly above a solid cell.
+    static bool isSupported(const Player* p, const MapLoader& map) {
+        const float feetX = p->m_position.x + 16;
+        const float feetY = p->m_position.y + 32;
+        return !map.isSolid(feetX, feetY) && map.isSolid(feetX, feetY + 1);
+    }
+
+    // One step of an awake player: gravity, velocity, landing on the terrain and the map
+    // bounds. Shared with client-side prediction (MovementPredictor).
+    static void stepPlayer(Player* p, float simDt, float gravity, const MapLoader& map) {
+        bool landed = false;
+
+        // Apply gravity
+        p->m_velocity.vy += gravity * simDt;
+
+        // Apply velocity
+        p->m_position.x += p->m_velocity.vx * simDt;
+        p->m_position.y += p->m_velocity.vy * simDt;
+
+        // --- NEW: PIXEL-PERFECT COLLISION ---
+        
+        // 1. Calculate the position of the player's feet (bottom-center)
+        // Assuming the sprite is approx 32x32 pixels. Adjust offsets if your sprite is different.
+        float feetX = p->m_position.x + 16; 
+        float feetY = p->m_position.y + 32;
+
+        // 2. Check if the feet are inside a solid pixel
+        if (map.isSolid(feetX, feetY)) {
+            // Stop falling
+            p->m_velocity.vy = 0;
+            landed = true;
             
-            // 1. Calculate the position of the player's feet (bottom-center)
-            // Assuming the sprite is approx 32x32 pixels. Adjust offsets if your sprite is different.
-            float feetX = p->m_position.x + 16; 
-            float feetY = p->m_position.y + 32;
-
-            // 2. Check if the feet are inside a solid pixel
-            if (map->isSolid(feetX, feetY)) {
-                // Stop falling
-                p->m_velocity.vy = 0;
-                
-                // Optional: Snap to top of the pixel to prevent sinking
-                // A simple way is to move them up pixel by pixel until not solid, 
-                // but strictly setting vy=0 on contact is a good start.
-                // For smoother landing, we might nudge Y up slightly:
-                while (map->isSolid(feetX, feetY) && feetY > 0) {
-                    p->m_position.y -= 1.0f;
-                    feetY -= 1.0f;
-                }
+            // Optional: Snap to top of the pixel to prevent sinking
+            // A simple way is to move them up pixel by pixel until not solid, 
+            // but strictly setting vy=0 on contact is a good start.
+            // For smoother landing, we might nudge Y up slightly:
+            while (map.isSolid(feetX, feetY) && feetY > 0) {
+                p->m_position.y -= 1.0f;
+                feetY -= 1.0f;
             }
+        }
 
-            // Boundary checks
-            if (p->m_position.x < 0) p->m_position.x = 0;
-            if (p->m_position.x > 1280) p->m_position.x = 1280;
-            
-            // Hard floor safety net (below screen)
-            if (p->m_position.y > 720) { 
-                p->m_position.y = 0; // Respawn at top if they fall out of world
+        // Boundary checks
+        if (p->m_position.x < 0) p->m_position.x = 0;
+        if (p->m_position.x > map.getWidth()) p->m_position.x = (float)map.getWidth();
+        
+        // Hard floor safety net (below the map)
+        if (p->m_position.y > map.getHeight()) { 
+            p->m_position.y = 0; // Respawn at top if they fall out of world
+        }
+
+        // Standing still on the ground: nothing changes until input or the terrain does.
+        if (landed && p->m_velocity.vx == 0.0f && isSupported(p, map)) {
+            p->sleep();
+        }
+    }
+
+    // True when a step would change nothing: every living player is asleep, no projectile
+    // is in flight and the terrain is as it was when the sleepers were last checked.
+    bool isAtRest(const std::vector<Player*>& players, const std::vector<Projectile>& projectiles, const MapLoader& map) const {
+        if (map.getRevision() != m_terrainRevision) return false;
+        for (const auto p : players) {
+            if (p->isAlive() && !p->isAsleep()) return false;
+        }
+        for (const auto& proj : projectiles) {
+            if (proj.isActive) return false;
+        }
+        return true;
+    }
+
+    void update(float deltaTime, std::vector<Player*>& players, std::vector<Projectile>& projectiles, MapLoader* map) {
+        float simDt = toSimDt(deltaTime);
+        TickProfiler::Scope playersScope(PHASE_PHYSICS_PLAYERS);
+
+        // Explosions or falling debris since the last step may have removed the ground
+        // under a sleeping player.
+        if (map->getRevision() != m_terrainRevision) {
+            m_terrainRevision = map->getRevision();
+            for (auto p : players) {
+                if (p->isAlive() && p->isAsleep() && !isSupported(p, *map)) p->wake();
             }
         }
 
+        // Update players
+        for (auto p : players) {
+            if(!p->isAlive() || p->isAsleep()) continue;
+            stepPlayer(p, simDt, GRAVITY, *map);
+        }
+
+        playersScope.stop();
+        TickProfiler::Scope projectilesScope(PHASE_PHYSICS_PROJECTILES);
+
         // Update Projectile
         for (auto& proj : projectiles) {
             if (!proj.isActive) continue;
 
-            // Apply gravity
-            proj.velocity.vy += GRAVITY * simDt;
-
-            // Apply wind
-            proj.velocity.vx += WIND * simDt;
-
-            // Update position
-            proj.position.x += proj.velocity.vx * simDt;
-            proj.position.y += proj.velocity.vy * simDt;
+            integrateProjectile(proj, simDt, GRAVITY, WIND);
 
             // Check collision with map
             if (map->isSolid(proj.position.x, proj.position.y)) {
                 // Create an explosion effect with radius of 30 pixels
                 map->applyExplosion(proj.position.x, proj.position.y, 30.0f);
-                m_terrainModified = true;  // Mark terrain as modified
-                m_hasLastExplosion = true;
-                m_lastExplosionX = proj.position.x;
-                m_lastExplosionY = proj.position.y;
-                m_lastExplosionRadius = 30.0f;
                 proj.isActive = false;
                 continue;
             }
@@ -133,17 +193,16 @@ public:
             for (auto p : players) {
                 if (p->isAlive()) {
                     if (checkCollision(proj, p)) {
-                        std::cerr << "Player " << p->getId() << " took damage" << std::endl;
                         proj.isActive = false;
                         p->takeDamage(10); // Deal 10 damage on hit
+                        LOG_INFO("player_hit", "player", p->getId(), "hp", p->getHP());
                         break;
                     }
                 }
             }
 
             // Boundary check - deactivate if out of bounds
-            if (proj.position.x < 0 || proj.position.x > 1280 ||
-                proj.position.y < 0 || proj.position.y > 720) {
+            if (isOutOfBounds(proj, *map)) {
                 proj.isActive = false;
             }
         }
@@ -151,20 +210,11 @@ public:
             
     // Calculate initial velocity of projectile based on angle and player orientation
     void fireProjectile(Player* p, std::vector<Projectile>& projectiles) {
-        float rad = p->m_angle * (PI / 180.0f);
-        Projectile proj;
-        proj.position.x = p->m_position.x;
-        proj.position.y = p->m_position.y - 20;
-        float directionMult = p->m_position.orient ? 1.0f : -1.0f;
-        
-        proj.velocity.vx = std::cos(rad) * p->m_power * 1.0f * directionMult;
-        proj.velocity.vy = -std::sin(rad) * p->m_power * 1.0f;
-        proj.isActive = true;
-        projectiles.push_back(proj);
+        projectiles.push_back(launchProjectile(p->m_position, p->m_angle, p->m_power));
     }
 
     void setWind(float wind) {
         WIND = wind;
-        std::cout << "Wind set to: " << WIND << std::endl;
+        LOG_INFO("wind_changed", "wind", WIND);
     }
 };
\ No newline at end of file
@@ -26,10 +26,11 @@ private:
     int m_hp;
     bool m_isAlive;
     bool m_isMyTurn;
+    bool m_isAsleep;
 
 public:
     Player(int id, std::string name, float startX, float startY, bool startOrient)
-        : m_id(id), m_name(name), m_hp(100), m_isAlive(true), m_isMyTurn(false) {
+        : m_id(id), m_name(name), m_hp(100), m_isAlive(true), m_isMyTurn(false), m_isAsleep(false) {
             m_position = {startX, startY, startOrient};
             m_velocity = {0.0f, 0.0f};
             m_angle = 45.0f;
@@ -40,13 +41,19 @@ public:
     int getHP() const { return m_hp; }
     bool isAlive() const { return m_isAlive; }
 
-    void setPosition(Position pos) { m_position = pos; }
-    void setVelocity(Velocity vel) { m_velocity = vel; }
+    void setPosition(Position pos) { m_position = pos; m_isAsleep = false; }
+    void setVelocity(Velocity vel) { m_velocity = vel; m_isAsleep = false; }
     void setOrient(bool orient) {m_position.orient = orient; }
 
-    void moveLeft() { m_velocity.vx = -SPEED; }
-    void moveRight() { m_velocity.vx = SPEED; }
+    void moveLeft() { m_velocity.vx = -SPEED; m_isAsleep = false; }
+    void moveRight() { m_velocity.vx = SPEED; m_isAsleep = false; }
     void stopMoving() { m_velocity.vx = 0.0f; }
+
+    // A sleeping player rests on terrain and is skipped by the physics step until
+    // movement input or a terrain change under it wakes it.
+    bool isAsleep() const { return m_isAsleep; }
+    void sleep() { m_velocity = {0.0f, 0.0f}; m_isAsleep = true; }
+    void wake() { m_isAsleep = false; }
     
     void adjustAngle(float delta) { m_angle += delta; }
     void adjustPower(float delta) { m_power += delta; }
@@ -0,0 +1,480 @@
+#pragma once
+#include "GameRoom.hpp"
+#include "MapLoader.hpp"
+#include "../../common/network/PacketStructs.hpp"
+#include "../../common/utils/Varint.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Seekable replay container.
+//
+//   ReplayFileHeader
+//   chunk*        : kind (u8), tick (u32), size (u32), payload
+//   index         : ReplayIndexEntry[keyframeCount]
+//   ReplayFileFooter
+//
+// Every tick after the first has a DELTA chunk: the zero-run-length encoded XOR of
+// the frame against the previous tick, plus the terrain spans that flipped during
+// that tick. Every keyframeInterval ticks a KEYFRAME chunk follows the delta: the
+// same encoding against an all-zero frame, with terrain spans relative to the
+// pristine map. Seeking costs one keyframe decode plus < keyframeInterval deltas.
+// The reader maps the file with mmap and decodes straight from the mapping.
+//
+// Frames are encoded as raw bytes, so ReplayFrame only uses the replay's own player and
+// projectile structs, never the wire ones; any layout change bumps REPLAY_FILE_VERSION.
+
+#define REPLAY_FILE_MAGIC 0x4C505247u   // "GRPL"
+#define REPLAY_FOOTER_MAGIC 0x58505247u // "GRPX"
+#define REPLAY_FILE_VERSION 2u
+#define REPLAY_CHUNK_DELTA 1u
+#define REPLAY_CHUNK_KEYFRAME 2u
+
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t id;
+    int32_t hp;
+    uint8_t isAlive;
+    uint8_t isMyTurn;
+    uint8_t orient;
+    float x;
+    float y;
+    float angle;
+    float power;
+} ReplayPlayerState;
+
+typedef struct {
+    uint8_t isActive;
+    float x;
+    float y;
+    float vx;
+    float vy;
+} ReplayProjectileState;
+
+typedef struct {
+    uint32_t tick;
+    uint32_t roomState;
+    float turnTimer;
+    uint8_t playerCount;
+    uint8_t projectileCount;
+    ReplayPlayerState players[INGAME_MAX_PLAYERS];
+    ReplayProjectileState projectiles[INGAME_MAX_PROJECTILES];
+} ReplayFrame;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t frameSize;   // sizeof(ReplayFrame) of the writer
+    uint32_t matchId;
+    uint32_t seed;
+    float tickSeconds;
+    uint32_t keyframeInterval;
+    char mapName[64];
+} ReplayFileHeader;
+
+typedef struct {
+    uint32_t tick;
+    uint64_t offset;
+} ReplayIndexEntry;
+
+typedef struct {
+    uint64_t indexOffset;
+    uint32_t keyframeCount;
+    uint32_t firstTick;
+    uint32_t lastTick;
+    uint32_t magic;
+} ReplayFileFooter;
+#pragma pack(pop)
+
+// Horizontal run of terrain cells whose solidity flipped.
+struct ReplayTerrainSpan {
+    int y;
+    int x;
+    int length;
+};
+
+namespace ReplayCodec {
+    using Varint::WriteVarint;
+    using Varint::ReadVarint;
+
+    // XOR of two frames encoded as (zero run, literal length, literal bytes)*.
+    inline void EncodeFrame(const ReplayFrame& base, const ReplayFrame& frame, std::vector<char>& out) {
+        const unsigned char* a = reinterpret_cast<const unsigned char*>(&base);
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(&frame);
+        const size_t size = sizeof(ReplayFrame);
+
+        size_t i = 0;
+        while (i < size) {
+            size_t zeroStart = i;
+            while (i < size && a[i] == b[i]) i++;
+            size_t literalStart = i;
+            // Literal runs absorb short zero gaps; a zero run costs at least two bytes.
+            while (i < size) {
+                if (a[i] != b[i]) { i++; continue; }
+                size_t j = i;
+                while (j < size && a[j] == b[j] && j - i < 3) j++;
+                if (j - i >= 3 || j == size) break;
+                i = j;
+            }
+            WriteVarint(out, (uint32_t)(literalStart - zeroStart));
+            WriteVarint(out, (uint32_t)(i - literalStart));
+            for (size_t k = literalStart; k < i; k++) out.push_back((char)(a[k] ^ b[k]));
+        }
+    }
+
+    inline bool DecodeFrame(const unsigned char*& p, const unsigned char* end, ReplayFrame& frame) {
+        unsigned char* out = reinterpret_cast<unsigned char*>(&frame);
+        const size_t size = sizeof(ReplayFrame);
+        size_t i = 0;
+        while (i < size) {
+            uint32_t zeros = 0, literals = 0;
+            if (!ReadVarint(p, end, zeros) || !ReadVarint(p, end, literals)) return false;
+            i += zeros;
+            if (i + literals > size || p + literals > end) return false;
+            for (uint32_t k = 0; k < literals; k++) out[i + k] ^= p[k];
+            p += literals;
+            i += literals;
+        }
+        return i == size;
+    }
+
+    inline void EncodeSpans(const std::vector<ReplayTerrainSpan>& spans, std::vector<char>& out) {
+        WriteVarint(out, (uint32_t)spans.size());
+        for (const auto& s : spans) {
+            WriteVarint(out, (uint32_t)s.y);
+            WriteVarint(out, (uint32_t)s.x);
+            WriteVarint(out, (uint32_t)s.length);
+        }
+    }
+
+    inline bool DecodeSpans(const unsigned char*& p, const unsigned char* end, std::vector<ReplayTerrainSpan>& spans) {
+        uint32_t count = 0;
+        if (!ReadVarint(p, end, count)) return false;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t y = 0, x = 0, length = 0;
+            if (!ReadVarint(p, end, y) || !ReadVarint(p, end, x) || !ReadVarint(p, end, length)) return false;
+            spans.push_back({(int)y, (int)x, (int)length});
+        }
+        return true;
+    }
+
+    // Runs of cells that differ between two maps of the same size, limited to a region.
+    inline void DiffTerrain(const MapLoader& a, const MapLoader& b, int minX, int minY, int maxX, int maxY,
+                            std::vector<ReplayTerrainSpan>& out) {
+        if (minX < 0) minX = 0;
+        if (minY < 0) minY = 0;
+        if (maxX > a.getWidth()) maxX = a.getWidth();
+        if (maxY > a.getHeight()) maxY = a.getHeight();
+
+        for (int y = minY; y < maxY; y++) {
+            int x = minX;
+            while (x < maxX) {
+                if (a.getCell(x, y) == b.getCell(x, y)) { x++; continue; }
+                const int start = x;
+                while (x < maxX && a.getCell(x, y) != b.getCell(x, y)) x++;
+                out.push_back({y, start, x - start});
+            }
+        }
+    }
+
+    inline void ApplySpans(MapLoader& map, const std::vector<ReplayTerrainSpan>& spans) {
+        for (const auto& s : spans) map.flipSpan(s.y, s.x, s.length);
+    }
+
+    inline ReplayFrame CaptureFrame(const GameRoom& room, uint32_t tick) {
+        ReplayFrame frame;
+        std::memset(&frame, 0, sizeof(frame));
+        frame.tick = tick;
+        frame.roomState = (uint32_t)room.getState();
+        frame.turnTimer = room.getTurnTimer();
+
+        const auto& players = room.getPlayers();
+        frame.playerCount = (uint8_t)std::min<size_t>(players.size(), INGAME_MAX_PLAYERS);
+        for (size_t i = 0; i < frame.playerCount; i++) {
+            const Player* p = players[i];
+            const Position pos = p->getPosition();
+            frame.players[i].id = (uint32_t)p->getId();
+            frame.players[i].hp = (int32_t)p->getHP();
+            frame.players[i].isAlive = p->isAlive() ? 1 : 0;
+            frame.players[i].isMyTurn = p->isMyTurn() ? 1 : 0;
+            frame.players[i].orient = pos.orient ? 1 : 0;
+            frame.players[i].x = pos.x;
+            frame.players[i].y = pos.y;
+            frame.players[i].angle = p->m_angle;
+            frame.players[i].power = p->m_power;
+        }
+
+        const auto& projectiles = room.getProjectiles();
+        frame.projectileCount = (uint8_t)std::min<size_t>(projectiles.size(), INGAME_MAX_PROJECTILES);
+        for (size_t i = 0; i < frame.projectileCount; i++) {
+            const auto& pr = projectiles[i];
+            frame.projectiles[i].isActive = pr.isActive ? 1 : 0;
+            frame.projectiles[i].x = pr.position.x;
+            frame.projectiles[i].y = pr.position.y;
+            frame.projectiles[i].vx = pr.velocity.vx;
+            frame.projectiles[i].vy = pr.velocity.vy;
+        }
+        return frame;
+    }
+}
+
+class ReplayWriter {
+public:
+    ReplayWriter() : m_hasPrev(false), m_firstTick(0), m_lastTick(0), m_ticksWritten(0) {
+        std::memset(&m_header, 0, sizeof(m_header));
+        std::memset(&m_prev, 0, sizeof(m_prev));
+    }
+    ~ReplayWriter() { close(); }
+
+    bool open(const std::string& path, uint32_t matchId, uint32_t seed, float tickSeconds,
+              const std::string& mapName, uint32_t keyframeInterval = 300) {
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_file.is_open()) return false;
+
+        m_header.magic = REPLAY_FILE_MAGIC;
+        m_header.version = REPLAY_FILE_VERSION;
+        m_header.frameSize = (uint32_t)sizeof(ReplayFrame);
+        m_header.matchId = matchId;
+        m_header.seed = seed;
+        m_header.tickSeconds = tickSeconds;
+        m_header.keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+        std::strncpy(m_header.mapName, mapName.c_str(), sizeof(m_header.mapName) - 1);
+        m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+
+        m_index.clear();
+        m_hasPrev = false;
+        m_ticksWritten = 0;
+        return m_file.good();
+    }
+
+    bool isOpen() const { return m_file.is_open(); }
+
+    // terrainChanges: spans flipped during this tick.
+    // terrainSincePristine: only needed on keyframe ticks (see needsKeyframe).
+    bool needsKeyframe() const { return m_ticksWritten % m_header.keyframeInterval == 0; }
+
+    void writeTick(const ReplayFrame& frame,
+                   const std::vector<ReplayTerrainSpan>& terrainChanges,
+                   const std::vector<ReplayTerrainSpan>& terrainSincePristine) {
+        if (!m_file.is_open()) return;
+
+        if (m_hasPrev) {
+            m_payload.clear();
+            ReplayCodec::EncodeFrame(m_prev, frame, m_payload);
+            ReplayCodec::EncodeSpans(terrainChanges, m_payload);
+            writeChunk(REPLAY_CHUNK_DELTA, frame.tick);
+        } else {
+            m_firstTick = frame.tick;
+        }
+
+        if (needsKeyframe()) {
+            ReplayFrame zero;
+            std::memset(&zero, 0, sizeof(zero));
+            m_payload.clear();
+            ReplayCodec::EncodeFrame(zero, frame, m_payload);
+            ReplayCodec::EncodeSpans(terrainSincePristine, m_payload);
+            m_index.push_back({frame.tick, (uint64_t)m_file.tellp()});
+            writeChunk(REPLAY_CHUNK_KEYFRAME, frame.tick);
+        }
+
+        m_prev = frame;
+        m_hasPrev = true;
+        m_lastTick = frame.tick;
+        m_ticksWritten++;
+    }
+
+    void close() {
+        if (!m_file.is_open()) return;
+
+        ReplayFileFooter footer;
+        footer.indexOffset = (uint64_t)m_file.tellp();
+        footer.keyframeCount = (uint32_t)m_index.size();
+        footer.firstTick = m_firstTick;
+        footer.lastTick = m_lastTick;
+        footer.magic = REPLAY_FOOTER_MAGIC;
+
+        if (!m_index.empty()) {
+            m_file.write(reinterpret_cast<const char*>(m_index.data()), m_index.size() * sizeof(ReplayIndexEntry));
+        }
+        m_file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+        m_file.close();
+    }
+
+private:
+    void writeChunk(uint8_t kind, uint32_t tick) {
+        const uint32_t size = (uint32_t)m_payload.size();
+        m_file.put((char)kind);
+        m_file.write(reinterpret_cast<const char*>(&tick), sizeof(tick));
+        m_file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        m_file.write(m_payload.data(), size);
+    }
+
+    std::ofstream m_file;
+    ReplayFileHeader m_header;
+    ReplayFrame m_prev;
+    bool m_hasPrev;
+    uint32_t m_firstTick;
+    uint32_t m_lastTick;
+    uint32_t m_ticksWritten;
+    std::vector<ReplayIndexEntry> m_index;
+    std::vector<char> m_payload;
+};
+
+class ReplayReader {
+public:
+    ReplayReader() : m_data(nullptr), m_size(0), m_index(nullptr), m_cursor(0) {
+        std::memset(&m_header, 0, sizeof(m_header));
+        std::memset(&m_footer, 0, sizeof(m_footer));
+        std::memset(&m_frame, 0, sizeof(m_frame));
+    }
+    ~ReplayReader() { close(); }
+
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)(sizeof(ReplayFileHeader) + sizeof(ReplayFileFooter))) {
+            ::close(fd);
+            return false;
+        }
+
+        void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        m_data = static_cast<const unsigned char*>(mapped);
+        m_size = (size_t)st.st_size;
+
+        std::memcpy(&m_header, m_data, sizeof(m_header));
+        std::memcpy(&m_footer, m_data + m_size - sizeof(m_footer), sizeof(m_footer));
+        const uint64_t indexBytes = (uint64_t)m_footer.keyframeCount * sizeof(ReplayIndexEntry);
+        if (m_header.magic != REPLAY_FILE_MAGIC || m_header.version != REPLAY_FILE_VERSION ||
+            m_header.frameSize != sizeof(ReplayFrame) ||
+            m_footer.magic != REPLAY_FOOTER_MAGIC || m_footer.keyframeCount == 0 ||
+            m_footer.indexOffset + indexBytes + sizeof(m_footer) != m_size) {
+            close();
+            return false;
+        }
+
+        m_index = reinterpret_cast<const ReplayIndexEntry*>(m_data + m_footer.indexOffset);
+        m_cursor = 0;
+        return true;
+    }
+
+    void close() {
+        if (m_data) {
+            munmap(const_cast<unsigned char*>(m_data), m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_index = nullptr;
+        m_cursor = 0;
+    }
+
+    bool isOpen() const { return m_data != nullptr; }
+    const ReplayFileHeader& getHeader() const { return m_header; }
+    uint32_t getFirstTick() const { return m_footer.firstTick; }
+    uint32_t getLastTick() const { return m_footer.lastTick; }
+    uint32_t getKeyframeCount() const { return m_footer.keyframeCount; }
+    const ReplayFrame& getFrame() const { return m_frame; }
+
+    // Positions the reader at `tick` (clamped to the replay range). outTerrain receives
+    // the spans to flip on the pristine map to obtain the terrain at that tick.
+    bool seek(uint32_t tick, std::vector<ReplayTerrainSpan>& outTerrain) {
+        if (!m_data) return false;
+        if (tick < m_footer.firstTick) tick = m_footer.firstTick;
+        if (tick > m_footer.lastTick) tick = m_footer.lastTick;
+
+        // Last keyframe at or before `tick`.
+        uint32_t lo = 0, hi = m_footer.keyframeCount;
+        while (hi - lo > 1) {
+            const uint32_t mid = (lo + hi) / 2;
+            if (readIndex(mid).tick <= tick) lo = mid; else hi = mid;
+        }
+        const ReplayIndexEntry key = readIndex(lo);
+
+        outTerrain.clear();
+        std::memset(&m_frame, 0, sizeof(m_frame));
+        m_cursor = (size_t)key.offset;
+        uint8_t kind = 0;
+        if (!decodeChunk(kind, outTerrain) || kind != REPLAY_CHUNK_KEYFRAME) return false;
+
+        while (m_frame.tick < tick) {
+            if (!step(outTerrain)) break;
+        }
+        return true;
+    }
+
+    // Advances one tick. Appends the terrain spans that flipped during that tick.
+    bool step(std::vector<ReplayTerrainSpan>& outTerrain) {
+        while (m_data && m_cursor < m_footer.indexOffset) {
+            const size_t chunkStart = m_cursor;
+            uint8_t kind = m_data[chunkStart];
+            if (kind == REPLAY_CHUNK_KEYFRAME) {
+                if (!skipChunk()) return false;
+                continue;
+            }
+            return decodeChunk(kind, outTerrain);
+        }
+        return false;
+    }
+
+private:
+    ReplayIndexEntry readIndex(uint32_t i) const {
+        ReplayIndexEntry e;
+        std::memcpy(&e, m_index + i, sizeof(e));
+        return e;
+    }
+
+    bool readChunkHeader(uint8_t& kind, uint32_t& tick, uint32_t& size) {
+        const size_t headerSize = 1 + sizeof(uint32_t) * 2;
+        if (m_cursor + headerSize > m_footer.indexOffset) return false;
+        kind = m_data[m_cursor];
+        std::memcpy(&tick, m_data + m_cursor + 1, sizeof(tick));
+        std::memcpy(&size, m_data + m_cursor + 5, sizeof(size));
+        m_cursor += headerSize;
+        return m_cursor + size <= m_footer.indexOffset;
+    }
+
+    bool skipChunk() {
+        uint8_t kind = 0;
+        uint32_t tick = 0, size = 0;
+        if (!readChunkHeader(kind, tick, size)) return false;
+        m_cursor += size;
+        return true;
+    }
+
+    bool decodeChunk(uint8_t& kind, std::vector<ReplayTerrainSpan>& outTerrain) {
+        uint32_t tick = 0, size = 0;
+        if (!readChunkHeader(kind, tick, size)) return false;
+
+        const unsigned char* p = m_data + m_cursor;
+        const unsigned char* end = p + size;
+        m_cursor += size;
+
+        if (kind == REPLAY_CHUNK_KEYFRAME) std::memset(&m_frame, 0, sizeof(m_frame));
+        return ReplayCodec::DecodeFrame(p, end, m_frame) && ReplayCodec::DecodeSpans(p, end, outTerrain);
+    }
+
+    const unsigned char* m_data;
+    size_t m_size;
+    const ReplayIndexEntry* m_index;
+    size_t m_cursor;
+    ReplayFileHeader m_header;
+    ReplayFileFooter m_footer;
+    ReplayFrame m_frame;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include "GameRoom.hpp"
+#include "../../common/network/PacketStructs.hpp"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct BotCommand {
+    uint32_t command; // InGameCommand
+    float value;
+};
+
+// Cheap seeded bot for batch simulation: turns towards the opponent, aims with a
+// flat-ground ballistic estimate plus noise, waits a few ticks and fires.
+// Emits the same commands a client would send, so GameRoom stays the only authority.
+class ScriptedBot {
+public:
+    ScriptedBot(int playerId, uint32_t seed, float aimNoise = 0.05f)
+        : m_playerId(playerId), m_rng(seed), m_aimNoise(aimNoise), m_wasMyTurn(false), m_turnTicks(0), m_fireAtTick(0) {}
+
+    int getPlayerId() const { return m_playerId; }
+
+    void think(const GameRoom& room, std::vector<BotCommand>& out) {
+        const Player* self = room.getPlayerById(m_playerId);
+        const bool myTurn = self && self->isAlive() && self->isMyTurn() && room.getState() == PLAYING_TURN;
+        if (!myTurn) {
+            m_wasMyTurn = false;
+            return;
+        }
+
+        if (!m_wasMyTurn) {
+            m_wasMyTurn = true;
+            m_turnTicks = 0;
+            std::uniform_int_distribution<int> delay(10, 90);
+            m_fireAtTick = delay(m_rng);
+        }
+        m_turnTicks++;
+
+        const Player* target = nullptr;
+        for (const Player* p : room.getPlayers()) {
+            if (p && p != self && p->isAlive()) { target = p; break; }
+        }
+        if (!target) return;
+
+        const float dx = target->getPosition().x - self->getPosition().x;
+        const bool faceRight = dx >= 0.0f;
+
+        if (m_turnTicks == 1) {
+            // A one-tick move sets the orientation; STOP cancels the velocity.
+            out.push_back({faceRight ? (uint32_t)INGAME_CMD_MOVE_RIGHT : (uint32_t)INGAME_CMD_MOVE_LEFT, 0.0f});
+            return;
+        }
+        if (m_turnTicks == 2) {
+            out.push_back({(uint32_t)INGAME_CMD_STOP, 0.0f});
+
+            std::normal_distribution<float> noise(1.0f, m_aimNoise);
+            const float angle = 45.0f;
+            // Range = v^2 * sin(2a) / g with the engine's per-step gravity.
+            const float power = std::sqrt(std::fabs(dx) * 0.98f) * noise(m_rng);
+            out.push_back({(uint32_t)INGAME_CMD_ADJUST_ANGLE, angle - self->m_angle});
+            out.push_back({(uint32_t)INGAME_CMD_ADJUST_POWER, power - self->m_power});
+            return;
+        }
+        if (m_turnTicks == m_fireAtTick) {
+            out.push_back({(uint32_t)INGAME_CMD_FIRE, 0.0f});
+        }
+    }
+
+private:
+    int m_playerId;
+    std::mt19937 m_rng;
+    float m_aimNoise;
+    bool m_wasMyTurn;
+    int m_turnTicks;
+    int m_fireAtTick;
+};
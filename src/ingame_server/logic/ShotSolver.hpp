@@ -0,0 +1,234 @@
+#pragma once
+#include "GameRoom.hpp"
+#include "MapLoader.hpp"
+#include "PhysicsEngine.hpp"
+#include "../../common/utils/WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct ShotResult {
+    float angle = 45.0f;
+    float power = 50.0f;
+    float missDistance = std::numeric_limits<float>::max();
+    bool directHit = false;
+    uint32_t evaluated = 0;
+};
+
+// Searches (angle, power) for the shooter's next shot by integrating candidate
+// trajectories with the same PhysicsEngine step the room uses. Candidates are split
+// into one batch per angle (most promising angles first) and run on a WorkStealingPool;
+// the search stops at the first direct hit or when the time budget runs out, and the
+// best candidate seen so far is returned.
+//
+// start() copies the terrain and positions, so the room keeps ticking while batches run.
+class ShotSolver {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr float kMinAngle = 5.0f;
+    static constexpr float kMaxAngle = 89.0f;
+    static constexpr float kAngleStep = 1.0f;
+    static constexpr float kMinPower = 10.0f;
+    static constexpr float kMaxPower = 100.0f;
+    static constexpr float kPowerStep = 0.5f;
+    static constexpr int kMaxSteps = 600;
+
+    // pool == nullptr runs every batch inline on the calling thread inside start().
+    ShotSolver(WorkStealingPool* pool, std::chrono::milliseconds budget)
+        : m_pool(pool), m_budget(budget) {}
+
+    ~ShotSolver() { cancel(); }
+
+    ShotSolver(const ShotSolver&) = delete;
+    ShotSolver& operator=(const ShotSolver&) = delete;
+
+    bool isRunning() const { return m_job != nullptr; }
+
+    // Begins a search for `shooterId` against the nearest other living player.
+    // The shooter's orientation is taken to face that target.
+    bool start(const GameRoom& room, int shooterId, const MapLoader& map, float tickSeconds) {
+        cancel();
+
+        const Player* self = room.getPlayerById(shooterId);
+        if (!self || !self->isAlive()) return false;
+
+        auto job = std::make_shared<Job>(map);
+        job->deadline = Clock::now() + m_budget;
+        job->shooter = self->getPosition();
+        job->simDt = PhysicsEngine::toSimDt(std::min(std::max(tickSeconds, 0.0f), 0.033f));
+        if (const PhysicsEngine* physics = room.getPhysics()) {
+            job->gravity = physics->getGravity();
+            job->wind = physics->getWind();
+        }
+
+        float bestDist = std::numeric_limits<float>::max();
+        for (const Player* p : room.getPlayers()) {
+            if (!p || !p->isAlive()) continue;
+            const Position pos = p->getPosition();
+            job->players.push_back(pos);
+            if (p == self) {
+                job->selfIndex = (int)job->players.size() - 1;
+                continue;
+            }
+            const float d = std::fabs(pos.x - job->shooter.x);
+            if (d < bestDist) {
+                bestDist = d;
+                job->targetIndex = (int)job->players.size() - 1;
+            }
+        }
+        if (job->targetIndex < 0) return false;
+
+        const Position& target = job->players[job->targetIndex];
+        job->shooter.orient = target.x >= job->shooter.x;
+
+        // Angles ordered outwards from 45 degrees so a tight budget still covers the
+        // flat-ground sweet spot first.
+        std::vector<float> angles;
+        for (float a = kMinAngle; a <= kMaxAngle; a += kAngleStep) angles.push_back(a);
+        std::sort(angles.begin(), angles.end(), [](float a, float b) {
+            return std::fabs(a - 45.0f) < std::fabs(b - 45.0f);
+        });
+
+        job->remaining.store((int)angles.size(), std::memory_order_relaxed);
+        m_job = job;
+
+        for (float angle : angles) {
+            if (m_pool) {
+                m_pool->submit([job, angle] { RunBatch(*job, angle); });
+            } else {
+                RunBatch(*job, angle);
+            }
+        }
+        return true;
+    }
+
+    // Orientation the solver assumed (true = facing right).
+    bool getFacing() const { return m_job ? m_job->shooter.orient : true; }
+
+    // Non-blocking. Returns true once the search has finished or run out of budget;
+    // `out` then holds the best shot found and the solver is idle again.
+    bool poll(ShotResult& out) {
+        if (!m_job) return false;
+
+        const bool finished = m_job->remaining.load(std::memory_order_acquire) == 0;
+        if (!finished && Clock::now() < m_job->deadline) return false;
+
+        m_job->stop.store(true, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_job->mutex);
+            out = m_job->best;
+        }
+        out.evaluated = m_job->evaluated.load(std::memory_order_relaxed);
+        m_job.reset();
+        return true;
+    }
+
+    // Abandons the current search; batches still queued see the flag and return at once.
+    void cancel() {
+        if (!m_job) return;
+        m_job->stop.store(true, std::memory_order_relaxed);
+        m_job.reset();
+    }
+
+private:
+    struct Job {
+        explicit Job(const MapLoader& map) : terrain(map) {}
+
+        MapLoader terrain;
+        Position shooter{};
+        std::vector<Position> players;
+        int selfIndex = -1;
+        int targetIndex = -1;
+        float simDt = 0.0f;
+        float gravity = 0.98f;
+        float wind = 0.0f;
+        Clock::time_point deadline;
+
+        std::atomic<bool> stop{false};
+        std::atomic<int> remaining{0};
+        std::atomic<uint32_t> evaluated{0};
+
+        std::mutex mutex;
+        ShotResult best;
+    };
+
+    // Distance from where the shot ends to the target; 0 on a direct hit.
+    // Self hits and shots leaving the world rank behind every terrain impact.
+    static float Simulate(const Job& job, float angle, float power, bool& directHit) {
+        constexpr float kSelfHitPenalty = 1.0e6f;
+        constexpr float kOutOfBoundsPenalty = 1.0e4f;
+
+        directHit = false;
+        const Position& target = job.players[job.targetIndex];
+        Projectile proj = PhysicsEngine::launchProjectile(job.shooter, angle, power);
+
+        for (int step = 0; step < kMaxSteps; step++) {
+            PhysicsEngine::integrateProjectile(proj, job.simDt, job.gravity, job.wind);
+
+            const float dx = proj.position.x - target.x;
+            const float dy = proj.position.y - target.y;
+
+            if (job.terrain.isSolid(proj.position.x, proj.position.y)) {
+                return std::sqrt(dx * dx + dy * dy);
+            }
+
+            for (size_t i = 0; i < job.players.size(); i++) {
+                if (!PhysicsEngine::hitsPlayer(proj, job.players[i])) continue;
+                if ((int)i == job.targetIndex) {
+                    directHit = true;
+                    return 0.0f;
+                }
+                return kSelfHitPenalty;
+            }
+
+            if (PhysicsEngine::isOutOfBounds(proj, job.terrain)) {
+                return kOutOfBoundsPenalty + std::sqrt(dx * dx + dy * dy);
+            }
+        }
+        return kOutOfBoundsPenalty;
+    }
+
+    static void RunBatch(Job& job, float angle) {
+        ShotResult local;
+        uint32_t evaluated = 0;
+
+        for (float power = kMinPower; power <= kMaxPower; power += kPowerStep) {
+            if (job.stop.load(std::memory_order_relaxed)) break;
+            // Checking the clock every few candidates keeps the overhead negligible.
+            if ((evaluated & 15) == 0 && Clock::now() >= job.deadline) break;
+
+            bool direct = false;
+            const float miss = Simulate(job, angle, power, direct);
+            evaluated++;
+
+            if (miss < local.missDistance) {
+                local.angle = angle;
+                local.power = power;
+                local.missDistance = miss;
+                local.directHit = direct;
+            }
+            if (direct) {
+                job.stop.store(true, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        job.evaluated.fetch_add(evaluated, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (local.missDistance < job.best.missDistance) job.best = local;
+        }
+        job.remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    WorkStealingPool* m_pool;
+    std::chrono::milliseconds m_budget;
+    std::shared_ptr<Job> m_job;
+};
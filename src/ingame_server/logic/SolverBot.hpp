@@ -0,0 +1,64 @@
+#pragma once
+#include "GameRoom.hpp"
+#include "ScriptedBot.hpp"
+#include "ShotSolver.hpp"
+#include "../../common/network/PacketStructs.hpp"
+
+#include <chrono>
+#include <vector>
+
+// Bot that fills an empty seat. On its turn it faces the opponent and starts a
+// ShotSolver search; once the search reports (hit found or budget spent) it dials in
+// the angle and power and fires. Like ScriptedBot it only emits client commands.
+class SolverBot {
+public:
+    SolverBot(int playerId, WorkStealingPool* pool, std::chrono::milliseconds budget = std::chrono::milliseconds(50))
+        : m_playerId(playerId), m_solver(pool, budget), m_wasMyTurn(false), m_fired(false) {}
+
+    int getPlayerId() const { return m_playerId; }
+    const ShotResult& getLastResult() const { return m_lastResult; }
+
+    void think(const GameRoom& room, float tickSeconds, std::vector<BotCommand>& out) {
+        const Player* self = room.getPlayerById(m_playerId);
+        const bool myTurn = self && self->isAlive() && self->isMyTurn() && room.getState() == PLAYING_TURN;
+        if (!myTurn) {
+            m_wasMyTurn = false;
+            m_solver.cancel();
+            return;
+        }
+
+        if (!m_wasMyTurn) {
+            m_wasMyTurn = true;
+            m_fired = false;
+
+            const MapLoader* map = room.getMapLoader();
+            if (!map || !m_solver.start(room, m_playerId, *map, tickSeconds)) {
+                out.push_back({(uint32_t)INGAME_CMD_FIRE, 0.0f});
+                m_fired = true;
+                return;
+            }
+            // A move cancelled by STOP in the same tick only turns the player around.
+            const bool faceRight = m_solver.getFacing();
+            out.push_back({faceRight ? (uint32_t)INGAME_CMD_MOVE_RIGHT : (uint32_t)INGAME_CMD_MOVE_LEFT, 0.0f});
+            out.push_back({(uint32_t)INGAME_CMD_STOP, 0.0f});
+        }
+
+        if (m_fired) return;
+
+        ShotResult result;
+        if (!m_solver.poll(result)) return;
+
+        m_lastResult = result;
+        out.push_back({(uint32_t)INGAME_CMD_ADJUST_ANGLE, result.angle - self->m_angle});
+        out.push_back({(uint32_t)INGAME_CMD_ADJUST_POWER, result.power - self->m_power});
+        out.push_back({(uint32_t)INGAME_CMD_FIRE, 0.0f});
+        m_fired = true;
+    }
+
+private:
+    int m_playerId;
+    ShotSolver m_solver;
+    ShotResult m_lastResult;
+    bool m_wasMyTurn;
+    bool m_fired;
+};
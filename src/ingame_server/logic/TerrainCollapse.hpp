@@ -0,0 +1,448 @@
+#pragma once
+#include "MapLoader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Finds terrain that explosions have cut loose and lets it fall.
+//
+// Connectivity is tracked per MapLoader tile. Each changed tile is re-labelled into
+// 4-connected local components (built from its row runs with a small union-find), and
+// the border cells of every component are kept. Components of neighbouring tiles are
+// connected where their border cells meet, which makes a graph with one node per tile
+// component; uniform tiles need no labelling at all.
+//
+// Only components in or next to changed tiles can have lost their support, so a check
+// searches from those alone, depth first and downwards first, stopping at the first
+// anchored node. Terrain still resting on the ground is typically confirmed after a
+// column of tiles, so the cost does not grow with the map area.
+//
+// A component is anchored when it reaches the bottom row of the map or lies in a pinned
+// tile: a tile holding terrain that was already floating when tracking began (designed
+// islands), so only terrain cut loose during play falls. Everything else is lifted out
+// as a debris body. Bodies fall under gravity by moving their cells through the terrain
+// itself, so clients and replays see them through the normal diff stream, and they stay
+// where they land. Checks are deferred while bodies are falling.
+class TerrainCollapse {
+public:
+    TerrainCollapse() : m_generation(0), m_tilesX(0), m_tilesY(0) {}
+
+    // True while debris is still falling.
+    bool isSettling() const { return !m_bodies.empty(); }
+    size_t getBodyCount() const { return m_bodies.size(); }
+
+    // Call once per tick after the terrain may have changed.
+    void update(MapLoader& map, float simDt, float gravity) {
+        if (map.getGeneration() != m_generation || map.getTilesX() != m_tilesX || map.getTilesY() != m_tilesY) {
+            rebuild(map);
+            return;
+        }
+
+        if (!m_bodies.empty()) {
+            stepBodies(map, simDt, gravity);
+            return;
+        }
+
+        m_changed.clear();
+        map.drainChangedTiles(m_changed);
+        if (m_changed.empty()) return;
+
+        for (int t : m_changed) labelTile(map, t);
+
+        m_check++;
+        m_seeds.clear();
+        for (int t : m_changed) {
+            addSeeds(t);
+            const int tx = t % m_tilesX;
+            const int ty = t / m_tilesX;
+            if (tx > 0) addSeeds(t - 1);
+            if (tx + 1 < m_tilesX) addSeeds(t + 1);
+            if (ty > 0) addSeeds(t - m_tilesX);
+            if (ty + 1 < m_tilesY) addSeeds(t + m_tilesX);
+        }
+        for (const Node& seed : m_seeds) {
+            if (m_tiles[seed.t].visits[seed.label].check == m_check) continue;
+            if (!search(seed)) m_bodies.push_back(makeBody(collectSpans()));
+        }
+    }
+
+private:
+    static constexpr int kTile = MapLoader::kTileSize;
+    static constexpr float kMaxFallSpeed = 20.0f;
+
+    // Cells [x0, x1) of row y inside a tile, with their local component (x1 is inclusive
+    // while a tile is being labelled).
+    struct Run {
+        uint8_t y;
+        uint8_t x0, x1;
+        uint16_t label;
+    };
+
+    enum Edge { EDGE_TOP = 0, EDGE_BOTTOM = 1, EDGE_LEFT = 2, EDGE_RIGHT = 3 };
+
+    // Per component: the check that resolved it (and whether it was anchored), and the
+    // last search that reached it.
+    struct Visit {
+        uint32_t check = 0;
+        uint32_t search = 0;
+        bool anchored = false;
+    };
+
+    struct TileLabels {
+        MapLoader::TileKind kind = MapLoader::TILE_EMPTY;
+        uint16_t count = 0;
+        std::vector<Run> runs;       // mixed tiles only
+        std::vector<uint16_t> edges; // mixed tiles only: 4 * kTile, label + 1, 0 = air
+        std::vector<Visit> visits;   // one per component
+    };
+
+    struct Node {
+        int t;
+        uint16_t label;
+    };
+
+    // Cells [x0, x1) of row y in map coordinates.
+    struct Span {
+        int y, x0, x1;
+    };
+
+    // A falling piece, as a bitmap of its bounding box.
+    struct Body {
+        int x = 0, y = 0, w = 0, h = 0;
+        float fy = 0.0f;
+        float vy = 0.0f;
+        std::vector<uint64_t> bits; // h rows of rowWords words
+        int rowWords = 0;
+        std::vector<std::pair<int, int>> footprint; // cells with no body cell below
+
+        bool has(int cx, int cy) const {
+            if (cx < 0 || cy < 0 || cx >= w || cy >= h) return false;
+            return (bits[(size_t)cy * rowWords + (cx >> 6)] >> (cx & 63)) & 1u;
+        }
+
+        // 64 cells of row cy starting at body column cx (which may be negative).
+        uint64_t window(int cy, int cx) const {
+            if (cy < 0 || cy >= h) return 0;
+            const uint64_t* row = &bits[(size_t)cy * rowWords];
+            auto word = [&](int i) -> uint64_t { return (i >= 0 && i < rowWords) ? row[i] : 0; };
+            const int i = (cx >= 0) ? cx / 64 : -((63 - cx) / 64);
+            const int shift = cx - i * 64;
+            if (shift == 0) return word(i);
+            return (word(i) >> shift) | (word(i + 1) << (64 - shift));
+        }
+    };
+
+    int tileWidth(int tx) const { return std::min(kTile, m_width - tx * kTile); }
+    int tileHeight(int ty) const { return std::min(kTile, m_height - ty * kTile); }
+
+    uint16_t edgeLabel(int t, Edge edge, int i) const {
+        const TileLabels& l = m_tiles[t];
+        if (l.kind == MapLoader::TILE_EMPTY) return 0;
+        if (l.kind == MapLoader::TILE_SOLID) return 1;
+        return l.edges[edge * kTile + i];
+    }
+
+    void rebuild(MapLoader& map) {
+        m_generation = map.getGeneration();
+        m_tilesX = map.getTilesX();
+        m_tilesY = map.getTilesY();
+        m_width = map.getWidth();
+        m_height = map.getHeight();
+        m_tiles.assign((size_t)m_tilesX * m_tilesY, TileLabels());
+        m_pinned.assign(m_tiles.size(), 0);
+        m_bodies.clear();
+
+        m_changed.clear();
+        map.drainChangedTiles(m_changed);
+        for (size_t t = 0; t < m_tiles.size(); t++) labelTile(map, (int)t);
+
+        // Whatever floats now was designed that way.
+        m_check++;
+        for (size_t t = 0; t < m_tiles.size(); t++) {
+            for (uint16_t l = 0; l < m_tiles[t].count; l++) {
+                if (m_tiles[t].visits[l].check == m_check) continue;
+                if (search({(int)t, l})) continue;
+                for (const Node& n : m_visited) m_pinned[n.t] = 1;
+            }
+        }
+    }
+
+    // Scanline labelling: runs of each row are unioned with the overlapping runs of the
+    // row above, then the roots are numbered densely.
+    void labelTile(const MapLoader& map, int t) {
+        TileLabels& l = m_tiles[t];
+        const int tx = t % m_tilesX;
+        const int ty = t / m_tilesX;
+        l.kind = map.getTileKind(tx, ty);
+        l.runs.clear();
+        l.edges.clear();
+        l.count = (l.kind == MapLoader::TILE_SOLID) ? 1 : 0;
+        l.visits.assign(l.count, Visit());
+        if (l.kind != MapLoader::TILE_MIXED) return;
+
+        const int w = tileWidth(tx);
+        const int h = tileHeight(ty);
+        m_local.clear();
+        size_t prevBegin = 0, prevEnd = 0;
+        for (int y = 0; y < h; y++) {
+            const uint64_t row = map.getTileRow(tx, ty * kTile + y);
+            const size_t begin = l.runs.size();
+            int x = 0;
+            while (x < w) {
+                if (!((row >> x) & 1u)) { x++; continue; }
+                const int x0 = x;
+                while (x < w && ((row >> x) & 1u)) x++;
+                const uint16_t id = (uint16_t)m_local.size();
+                m_local.push_back(id);
+                l.runs.push_back({(uint8_t)y, (uint8_t)x0, (uint8_t)(x - 1), id});
+            }
+            // Runs of both rows are sorted by x; walk them together.
+            size_t a = prevBegin;
+            for (size_t b = begin; b < l.runs.size(); b++) {
+                while (a < prevEnd && l.runs[a].x1 < l.runs[b].x0) a++;
+                for (size_t c = a; c < prevEnd && l.runs[c].x0 <= l.runs[b].x1; c++) {
+                    unite(m_local, l.runs[c].label, l.runs[b].label);
+                }
+            }
+            prevBegin = begin;
+            prevEnd = l.runs.size();
+        }
+
+        // Dense labels; x1 becomes exclusive from here on.
+        m_localIds.assign(m_local.size(), UINT16_MAX);
+        uint16_t count = 0;
+        for (auto& r : l.runs) {
+            const uint16_t root = findIn(m_local, r.label);
+            if (m_localIds[root] == UINT16_MAX) m_localIds[root] = count++;
+            r.label = m_localIds[root];
+            r.x1 = (uint8_t)(r.x1 + 1);
+        }
+        l.count = count;
+        l.visits.assign(count, Visit());
+
+        l.edges.assign(4 * kTile, 0);
+        for (const auto& r : l.runs) {
+            const uint16_t label = (uint16_t)(r.label + 1);
+            if (r.y == 0) for (int x = r.x0; x < r.x1; x++) l.edges[EDGE_TOP * kTile + x] = label;
+            if (r.y == h - 1) for (int x = r.x0; x < r.x1; x++) l.edges[EDGE_BOTTOM * kTile + x] = label;
+            if (r.x0 == 0) l.edges[EDGE_LEFT * kTile + r.y] = label;
+            if (r.x1 == w) l.edges[EDGE_RIGHT * kTile + r.y] = label;
+        }
+    }
+
+    void addSeeds(int t) {
+        for (uint16_t l = 0; l < m_tiles[t].count; l++) m_seeds.push_back({t, l});
+    }
+
+    bool isAnchor(const Node& n) const {
+        if (m_pinned[n.t]) return true;
+        const int tx = n.t % m_tilesX;
+        if (n.t / m_tilesX != m_tilesY - 1) return false;
+        for (int x = 0; x < tileWidth(tx); x++) {
+            if (edgeLabel(n.t, EDGE_BOTTOM, x) == n.label + 1) return true;
+        }
+        return false;
+    }
+
+    // Depth-first search from `seed` over tile components. Returns true as soon as it
+    // meets an anchor or a component already found anchored in this check; otherwise
+    // m_visited holds the whole (floating) component. Either way every visited node is
+    // resolved for the current check.
+    bool search(const Node& seed) {
+        m_search++;
+        m_visited.clear();
+        m_stack.clear();
+        m_stack.push_back(seed);
+        m_tiles[seed.t].visits[seed.label].search = m_search;
+
+        bool anchored = false;
+        while (!m_stack.empty() && !anchored) {
+            const Node n = m_stack.back();
+            m_stack.pop_back();
+            m_visited.push_back(n);
+
+            const Visit& v = m_tiles[n.t].visits[n.label];
+            if ((v.check == m_check && v.anchored) || isAnchor(n)) {
+                anchored = true;
+                break;
+            }
+
+            // Pushed last, popped first: head for the bottom of the map.
+            const int tx = n.t % m_tilesX;
+            const int ty = n.t / m_tilesX;
+            if (ty > 0) pushNeighbours(n, n.t - m_tilesX, EDGE_TOP, EDGE_BOTTOM, tileWidth(tx));
+            if (tx > 0) pushNeighbours(n, n.t - 1, EDGE_LEFT, EDGE_RIGHT, tileHeight(ty));
+            if (tx + 1 < m_tilesX) pushNeighbours(n, n.t + 1, EDGE_RIGHT, EDGE_LEFT, tileHeight(ty));
+            if (ty + 1 < m_tilesY) pushNeighbours(n, n.t + m_tilesX, EDGE_BOTTOM, EDGE_TOP, tileWidth(tx));
+        }
+
+        for (const Node& n : m_visited) {
+            Visit& v = m_tiles[n.t].visits[n.label];
+            v.check = m_check;
+            v.anchored = anchored;
+        }
+        return anchored;
+    }
+
+    void pushNeighbours(const Node& n, int other, Edge edge, Edge otherEdge, int length) {
+        const TileLabels& lo = m_tiles[other];
+        if (lo.kind == MapLoader::TILE_EMPTY) return;
+
+        uint16_t last = 0;
+        for (int i = 0; i < length; i++) {
+            if (edgeLabel(n.t, edge, i) != n.label + 1) continue;
+            const uint16_t e = edgeLabel(other, otherEdge, i);
+            if (!e || e == last) continue;
+            last = e;
+            Visit& v = m_tiles[other].visits[e - 1];
+            if (v.search == m_search) continue;
+            v.search = m_search;
+            m_stack.push_back({other, (uint16_t)(e - 1)});
+            if (lo.kind == MapLoader::TILE_SOLID) return;
+        }
+    }
+
+    // Cells of the component left in m_visited by a failed search.
+    std::vector<Span> collectSpans() const {
+        std::vector<Span> spans;
+        for (const Node& n : m_visited) {
+            const TileLabels& l = m_tiles[n.t];
+            const int ox = (n.t % m_tilesX) * kTile;
+            const int oy = (n.t / m_tilesX) * kTile;
+            if (l.kind == MapLoader::TILE_SOLID) {
+                const int w = tileWidth(n.t % m_tilesX);
+                for (int y = 0; y < tileHeight(n.t / m_tilesX); y++) spans.push_back({oy + y, ox, ox + w});
+                continue;
+            }
+            for (const auto& r : l.runs) {
+                if (r.label == n.label) spans.push_back({oy + r.y, ox + r.x0, ox + r.x1});
+            }
+        }
+        return spans;
+    }
+
+    static Body makeBody(const std::vector<Span>& spans) {
+        Body body;
+        int minX = spans[0].x0, maxX = spans[0].x1;
+        int minY = spans[0].y, maxY = spans[0].y + 1;
+        for (const auto& s : spans) {
+            minX = std::min(minX, s.x0);
+            maxX = std::max(maxX, s.x1);
+            minY = std::min(minY, s.y);
+            maxY = std::max(maxY, s.y + 1);
+        }
+        body.x = minX;
+        body.y = minY;
+        body.w = maxX - minX;
+        body.h = maxY - minY;
+        body.fy = (float)minY;
+        body.rowWords = (body.w + 63) / 64;
+        body.bits.assign((size_t)body.h * body.rowWords, 0);
+
+        for (const auto& s : spans) {
+            const int y = s.y - minY;
+            for (int x = s.x0 - minX; x < s.x1 - minX; x++) {
+                body.bits[(size_t)y * body.rowWords + (x >> 6)] |= 1ull << (x & 63);
+            }
+        }
+        for (int y = 0; y < body.h; y++) {
+            for (int x = 0; x < body.w; x++) {
+                if (body.has(x, y) && !body.has(x, y + 1)) body.footprint.push_back({x, y});
+            }
+        }
+        return body;
+    }
+
+    // Moves each body down one cell at a time until its footprint meets terrain or the
+    // bottom of the map, then leaves it there as ordinary terrain.
+    void stepBodies(MapLoader& map, float simDt, float gravity) {
+        for (size_t i = 0; i < m_bodies.size();) {
+            Body& body = m_bodies[i];
+            body.vy = std::min(body.vy + gravity * simDt, kMaxFallSpeed);
+            body.fy += body.vy * simDt;
+
+            int moved = 0;
+            bool landed = false;
+            while (body.y + moved < (int)body.fy) {
+                if (blocked(map, body, moved + 1)) {
+                    landed = true;
+                    break;
+                }
+                moved++;
+            }
+            if (moved > 0) moveBody(map, body, moved);
+
+            if (landed) {
+                m_bodies[i] = std::move(m_bodies.back());
+                m_bodies.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    bool blocked(const MapLoader& map, const Body& body, int offset) const {
+        for (const auto& f : body.footprint) {
+            const int y = body.y + f.second + offset;
+            if (y >= m_height) return true;
+            if (body.has(f.first, f.second + offset)) continue;
+            if (map.getCell(body.x + f.first, y)) return true;
+        }
+        return false;
+    }
+
+    // Rewrites the affected map rows a tile row (64 cells) at a time: the body's old
+    // cells are cleared and its cells shifted down by dy are set.
+    void moveBody(MapLoader& map, Body& body, int dy) {
+        const int tx0 = body.x / kTile;
+        const int tx1 = (body.x + body.w - 1) / kTile;
+        for (int y = body.y; y < body.y + body.h + dy; y++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                const int cx = tx * kTile - body.x;
+                const uint64_t before = body.window(y - body.y, cx);
+                const uint64_t after = body.window(y - body.y - dy, cx);
+                if (before == after) continue;
+                map.setTileRow(tx, y, (map.getTileRow(tx, y) & ~before) | after);
+            }
+        }
+        map.markDirty(body.x, body.y, body.x + body.w, body.y + body.h + dy);
+        body.y += dy;
+    }
+
+    template <typename T>
+    static T findIn(std::vector<T>& parent, T i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    template <typename T>
+    static void unite(std::vector<T>& parent, T a, T b) {
+        a = findIn(parent, a);
+        b = findIn(parent, b);
+        if (a == b) return;
+        if (a < b) parent[b] = a;
+        else parent[a] = b;
+    }
+
+    uint32_t m_generation;
+    int m_tilesX, m_tilesY;
+    int m_width = 0, m_height = 0;
+    std::vector<TileLabels> m_tiles;
+    std::vector<uint8_t> m_pinned;
+
+    std::vector<Body> m_bodies;
+
+    uint32_t m_check = 0;
+    uint32_t m_search = 0;
+    std::vector<Node> m_seeds;
+    std::vector<Node> m_stack;
+    std::vector<Node> m_visited;
+
+    std::vector<int> m_changed;
+    std::vector<uint16_t> m_local;
+    std::vector<uint16_t> m_localIds;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include "MapLoader.hpp"
+#include "../../common/utils/Varint.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Wire format for authoritative terrain updates (RES_INGAME_TERRAIN_DIFF).
+//
+//   varint rectCount
+//   per rect: varint x, y, w, h, then per row: varint run*
+//
+// Each row is a run-length encoding of its cells, alternating air/solid and starting
+// with air (the first run may be 0); a row ends when its runs add up to w. Rows carry
+// absolute contents rather than flips, so a client whose base differs inside the
+// region still ends up with the server's terrain there.
+namespace TerrainDiff {
+    inline void Encode(const MapLoader& map, const std::vector<TerrainRect>& rects, std::vector<char>& out) {
+        Varint::WriteVarint(out, (uint32_t)rects.size());
+        for (const auto& r : rects) {
+            Varint::WriteVarint(out, (uint32_t)r.x);
+            Varint::WriteVarint(out, (uint32_t)r.y);
+            Varint::WriteVarint(out, (uint32_t)r.w);
+            Varint::WriteVarint(out, (uint32_t)r.h);
+
+            for (int y = r.y; y < r.y + r.h; y++) {
+                bool solid = false;
+                int x = r.x;
+                const int end = r.x + r.w;
+                while (x < end) {
+                    const int start = x;
+                    while (x < end && map.getCell(x, y) == solid) x++;
+                    Varint::WriteVarint(out, (uint32_t)(x - start));
+                    solid = !solid;
+                }
+            }
+        }
+    }
+
+    // Returns false on malformed input or a region outside the map; rows decoded
+    // before the error stay applied.
+    inline bool Apply(MapLoader& map, const unsigned char* p, const unsigned char* end) {
+        uint32_t count = 0;
+        if (!Varint::ReadVarint(p, end, count)) return false;
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t x = 0, y = 0, w = 0, h = 0;
+            if (!Varint::ReadVarint(p, end, x) || !Varint::ReadVarint(p, end, y) ||
+                !Varint::ReadVarint(p, end, w) || !Varint::ReadVarint(p, end, h)) {
+                return false;
+            }
+            if ((uint64_t)x + w > (uint64_t)map.getWidth() || (uint64_t)y + h > (uint64_t)map.getHeight()) {
+                return false;
+            }
+
+            for (uint32_t row = 0; row < h; row++) {
+                bool solid = false;
+                uint32_t filled = 0;
+                while (filled < w) {
+                    uint32_t run = 0;
+                    if (!Varint::ReadVarint(p, end, run) || run > w - filled) return false;
+                    if (run > 0) map.fillSpan((int)(y + row), (int)(x + filled), (int)run, solid);
+                    filled += run;
+                    solid = !solid;
+                }
+            }
+        }
+        return p == end;
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "../../common/utils/LatencyHistogram.hpp"
+
+// Where a server tick's time goes. TickProfiler::Scope timers sit on the tick path
+// (GameServer::GameLoop, GameRoom::update, PhysicsEngine::update) and cost one
+// thread-local load unless the running thread has a tick open, which only the server's
+// game loop and `match_sim --profile` do.
+
+enum TickPhase {
+    PHASE_TICK,                // whole tick, beginTick() to endTick()
+    PHASE_LOCK_WAIT,           // waiting for m_roomMutex / m_clientsMutex
+    PHASE_INPUT,               // bots and the input drain
+    PHASE_ROOM_UPDATE,         // GameRoom::update, including the three below
+    PHASE_PHYSICS_PLAYERS,
+    PHASE_PHYSICS_PROJECTILES, // flight, hits and explosions
+    PHASE_COLLAPSE,            // floating terrain detection and debris
+    PHASE_SNAPSHOT_BUILD,
+    PHASE_ENCODE,              // terrain diff
+    PHASE_SEND,
+    PHASE_COUNT
+};
+
+inline const char* tickPhaseName(int phase) {
+    static const char* const names[PHASE_COUNT] = {
+        "tick", "lock_wait", "input", "room_update", "physics_players", "physics_projectiles",
+        "collapse", "snapshot_build", "encode", "send"};
+    return (phase >= 0 && phase < PHASE_COUNT) ? names[phase] : "unknown";
+}
+
+struct PhaseHistograms {
+    LatencyHistogram phases[PHASE_COUNT];
+    std::atomic<uint64_t> overruns{0};
+
+    void merge(const PhaseHistograms& other) {
+        for (int p = 0; p < PHASE_COUNT; p++) phases[p].merge(other.phases[p]);
+        overruns.store(overruns.load(std::memory_order_relaxed) + other.overruns.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    }
+};
+
+// One per room. beginTick/endTick bracket a tick on the thread that runs it; endTick
+// records the phase breakdown into the room's histograms and into the calling thread's
+// worker histograms (see workers()).
+class TickProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Breakdown {
+        uint64_t ns[PHASE_COUNT];
+    };
+
+    // Adds the time until stop() (or the end of the scope) to `phase` of the tick open on
+    // this thread. Phases may be entered more than once per tick.
+    class Scope {
+    public:
+        explicit Scope(TickPhase phase) : m_phase(phase), m_tick(current()) {
+            if (m_tick) m_start = Clock::now();
+        }
+        ~Scope() { stop(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void stop() {
+            if (!m_tick) return;
+            m_tick->ns[m_phase] += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+            m_tick = nullptr;
+        }
+
+    private:
+        TickPhase m_phase;
+        Breakdown* m_tick;
+        Clock::time_point m_start;
+    };
+
+    explicit TickProfiler(uint64_t budgetNs) : m_budgetNs(budgetNs), m_last{}, m_open{} {}
+
+    void beginTick() {
+        m_open = Breakdown{};
+        m_start = Clock::now();
+        current() = &m_open;
+    }
+
+    // Returns true when the tick took longer than the budget.
+    bool endTick() {
+        current() = nullptr;
+        m_open.ns[PHASE_TICK] = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count();
+        m_last = m_open;
+
+        PhaseHistograms& worker = currentWorker();
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            m_room.phases[p].record(m_last.ns[p]);
+            worker.phases[p].record(m_last.ns[p]);
+        }
+        if (m_last.ns[PHASE_TICK] <= m_budgetNs) return false;
+        m_room.overruns.store(m_room.overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        worker.overruns.store(worker.overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    uint64_t getBudgetNs() const { return m_budgetNs; }
+    // Breakdown of the last closed tick; only for the thread that runs the ticks.
+    const Breakdown& lastTick() const { return m_last; }
+    const PhaseHistograms& histograms() const { return m_room; }
+
+    // Histograms of every thread that has closed a tick, one entry per thread. Entries
+    // live until the process exits.
+    static std::vector<const PhaseHistograms*> workers() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        std::vector<const PhaseHistograms*> out;
+        for (const auto& w : registry()) out.push_back(&w);
+        return out;
+    }
+
+private:
+    static Breakdown*& current() {
+        static thread_local Breakdown* open = nullptr;
+        return open;
+    }
+
+    static PhaseHistograms& currentWorker() {
+        static thread_local PhaseHistograms* mine = nullptr;
+        if (!mine) {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            registry().emplace_back();
+            mine = &registry().back();
+        }
+        return *mine;
+    }
+
+    static std::deque<PhaseHistograms>& registry() {
+        static std::deque<PhaseHistograms> all;
+        return all;
+    }
+
+    static std::mutex& registryMutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    uint64_t m_budgetNs;
+    PhaseHistograms m_room;
+    Breakdown m_last;
+    Breakdown m_open;
+    Clock::time_point m_start;
+};
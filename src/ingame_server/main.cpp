@@ -1,7 +1,13 @@
 #include "core/GameServer.hpp"
+#include "../common/metrics/AllocationCounter.hpp"
+#include "../common/utils/Log.hpp"
+#include "../common/utils/Trace.hpp"
 
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 namespace {
 GameServer* g_server = nullptr;
@@ -15,17 +21,84 @@ void HandleSigInt(int) {
 }
 
 int main(int argc, char** argv) {
+    // Usage: ingame_server_demo [port] [--bot-fill SECONDS] [--overrun-log FILE] [--metrics-port PORT]
+    //                          [--log-level debug|info|warn|error|off] [--log-file FILE]
+    //                          [--trace FILE] [--match-id ID] [--service HOST:PORT]
+    //   negative SECONDS disables bots; an empty FILE disables the tick overrun log;
+    //   PORT serves Prometheus metrics on 127.0.0.1 (off by default). The event log goes
+    //   to stderr unless --log-file is given. --trace records Chrome trace spans and
+    //   writes them to FILE on shutdown. --match-id is the "Match".match_id being hosted;
+    //   the recording path is reported to the service server at HOST:PORT when it ends.
     int port = 9090;
-    if (argc >= 2) {
-        port = std::atoi(argv[1]);
-        if (port <= 0) port = 9090;
+    float botFillSeconds = -1.0f;
+    bool hasBotFill = false;
+    const char* overrunLog = nullptr;
+    int metricsPort = 0;
+    const char* tracePath = nullptr;
+    uint32_t matchId = 0;
+    std::string serviceIp;
+    int servicePort = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--bot-fill") == 0 && i + 1 < argc) {
+            botFillSeconds = (float)std::atof(argv[++i]);
+            hasBotFill = true;
+        } else if (std::strcmp(argv[i], "--overrun-log") == 0 && i + 1 < argc) {
+            overrunLog = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) {
+            metricsPort = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--match-id") == 0 && i + 1 < argc) {
+            matchId = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--service") == 0 && i + 1 < argc) {
+            const std::string address = argv[++i];
+            const size_t colon = address.rfind(':');
+            servicePort = (colon == std::string::npos) ? 0 : std::atoi(address.c_str() + colon + 1);
+            if (servicePort <= 0) {
+                std::cerr << "Expected HOST:PORT for --service, got " << address << std::endl;
+                return 1;
+            }
+            serviceIp = address.substr(0, colon);
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            Log::Level level;
+            if (!Log::parseLevel(argv[++i], level)) {
+                std::cerr << "Unknown log level " << argv[i] << std::endl;
+                return 1;
+            }
+            Log::setLevel(level);
+        } else if (std::strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) {
+            if (!Log::openFile(argv[++i])) {
+                std::cerr << "Cannot open log file " << argv[i] << std::endl;
+                return 1;
+            }
+        } else {
+            port = std::atoi(argv[i]);
+            if (port <= 0) port = 9090;
+        }
     }
 
+    if (tracePath) Trace::start(tracePath, "ingame_server");
+
     GameServer server;
+    if (hasBotFill) server.SetBotFillSeconds(botFillSeconds);
+    if (overrunLog) server.SetOverrunLogPath(overrunLog);
+    if (matchId != 0) server.SetMatchId(matchId);
+    if (!serviceIp.empty()) server.SetServiceAddress(serviceIp, servicePort);
     g_server = &server;
     std::signal(SIGINT, HandleSigInt);
 
+    MetricsServer metrics;
+    if (metricsPort > 0) {
+        metrics.Start(metricsPort, [&server](PrometheusText& out) {
+            server.WriteMetrics(out);
+            Metrics::WritePacketMetrics(out);
+            Metrics::WriteAllocationMetrics(out);
+        });
+    }
+
     server.Run(port);
+    metrics.Stop();
+    Trace::stop();
 
     g_server = nullptr;
     return 0;
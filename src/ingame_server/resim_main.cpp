@@ -0,0 +1,155 @@
+#include "logic/GameRoom.hpp"
+#include "logic/MapGenerator.hpp"
+#include "logic/MapLoader.hpp"
+#include "logic/MatchRecorder.hpp"
+#include "logic/ReplayFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Headless re-simulation of a match recording produced by GameServer.
+// Runs the recorded input stream through GameRoom as fast as possible, so real
+// matches can be replayed under a profiler.
+//
+// With --export-replay it also writes a seekable replay (see ReplayFile.hpp).
+//
+// Usage: match_resim <recording.gmr> [--repeat N] [--export-replay out.grp] [--keyframe-interval N]
+
+namespace {
+struct ResimResult {
+    uint32_t ticks;
+    uint64_t stateHash;
+    RoomState finalState;
+};
+
+// Records the replay frame and the terrain spans changed since the previous tick.
+void WriteReplayTick(ReplayWriter& writer, GameRoom& room, uint32_t tick,
+                     const MapLoader& pristine, const MapLoader& map, MapLoader& prevMap) {
+    std::vector<ReplayTerrainSpan> changes;
+    std::vector<ReplayTerrainSpan> sincePristine;
+
+    std::vector<TerrainRect> dirty;
+    if (room.drainDirtyRects(dirty)) {
+        for (const auto& r : dirty) {
+            ReplayCodec::DiffTerrain(prevMap, map, r.x, r.y, r.x + r.w, r.y + r.h, changes);
+        }
+        ReplayCodec::ApplySpans(prevMap, changes);
+    }
+    if (writer.needsKeyframe()) {
+        ReplayCodec::DiffTerrain(pristine, map, 0, 0, map.getWidth(), map.getHeight(), sincePristine);
+    }
+    writer.writeTick(ReplayCodec::CaptureFrame(room, tick), changes, sincePristine);
+}
+
+ResimResult Resimulate(const MatchRecordingReader& rec, const MapLoader& pristineMap, ReplayWriter* writer) {
+    MapLoader map = pristineMap;
+    MapLoader prevMap = pristineMap;
+
+    std::vector<Player*> players;
+    for (const auto& rp : rec.info.players) {
+        players.push_back(new Player((int)rp.id, rp.name, rp.x, rp.y, rp.orient != 0));
+    }
+
+    GameRoom room(players);
+    room.setMapLoader(&map);
+    room.startGame();
+    if (writer) WriteReplayTick(*writer, room, 0, pristineMap, map, prevMap);
+
+    size_t next = 0;
+    for (uint32_t tick = 1; tick <= rec.finalTick; tick++) {
+        while (next < rec.inputs.size() && rec.inputs[next].tick == tick) {
+            const RecordedInput& in = rec.inputs[next++];
+            const char* cmd = MatchRecording::CommandToString(in.command);
+            if (cmd) room.handleInput((int)in.playerId, cmd, in.value);
+        }
+        room.update(rec.info.tickSeconds);
+        if (writer) WriteReplayTick(*writer, room, tick, pristineMap, map, prevMap);
+    }
+
+    ResimResult result{rec.finalTick, MatchRecording::ComputeStateHash(room), room.getState()};
+    for (auto* p : players) delete p;
+    return result;
+}
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <recording.gmr> [--repeat N] [--export-replay out.grp] [--keyframe-interval N]" << std::endl;
+        return 1;
+    }
+
+    int repeat = 1;
+    std::string replayPath;
+    uint32_t keyframeInterval = 300;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--export-replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--keyframe-interval") == 0 && i + 1 < argc) {
+            keyframeInterval = (uint32_t)std::max(1, std::atoi(argv[++i]));
+        }
+    }
+
+    MatchRecordingReader rec;
+    if (!rec.load(argv[1])) {
+        std::cerr << "match_resim: failed to read recording " << argv[1] << std::endl;
+        return 1;
+    }
+
+    MapLoader map;
+    if (!MapGenerator::Load(map, rec.info.mapName, rec.info.seed)) {
+        std::cerr << "match_resim: failed to load map " << rec.info.mapName << std::endl;
+        return 1;
+    }
+
+    std::cout << "Recording: match " << rec.info.matchId << ", map " << rec.info.mapName
+              << ", seed " << rec.info.seed << ", " << rec.info.players.size() << " players, "
+              << rec.inputs.size() << " inputs, " << rec.finalTick << " ticks"
+              << (rec.complete ? "" : " (truncated)") << std::endl;
+
+    using clock = std::chrono::steady_clock;
+    ResimResult result{};
+    const auto start = clock::now();
+    for (int i = 0; i < repeat; i++) {
+        result = Resimulate(rec, map, nullptr);
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    if (!replayPath.empty()) {
+        ReplayWriter writer;
+        if (!writer.open(replayPath, rec.info.matchId, rec.info.seed, rec.info.tickSeconds,
+                         rec.info.mapName, keyframeInterval)) {
+            std::cerr << "match_resim: failed to open replay output " << replayPath << std::endl;
+            return 1;
+        }
+        Resimulate(rec, map, &writer);
+        writer.close();
+        std::cout << "Replay written to " << replayPath << std::endl;
+    }
+
+    const double totalTicks = (double)result.ticks * repeat;
+    const double matchSeconds = result.ticks * rec.info.tickSeconds;
+    std::cout << "Simulated " << repeat << "x " << result.ticks << " ticks in " << seconds * 1000.0 << " ms ("
+              << (seconds > 0.0 ? totalTicks / seconds : 0.0) << " ticks/s, "
+              << (seconds > 0.0 ? matchSeconds * repeat / seconds : 0.0) << "x real time)" << std::endl;
+    std::cout << "Final room state: " << (int)result.finalState << std::endl;
+
+    if (!rec.complete || rec.finalStateHash == 0) {
+        std::cout << "State hash: " << std::hex << result.stateHash << std::dec << " (no reference in recording)" << std::endl;
+        return 0;
+    }
+
+    if (result.stateHash != rec.finalStateHash) {
+        std::cout << "State hash MISMATCH: recorded " << std::hex << rec.finalStateHash
+                  << ", re-simulated " << result.stateHash << std::dec << std::endl;
+        return 2;
+    }
+    std::cout << "State hash matches recording: " << std::hex << result.stateHash << std::dec << std::endl;
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "logic/GameRoom.hpp"
+#include "logic/MapGenerator.hpp"
+#include "logic/MapLoader.hpp"
+#include "logic/MatchRecorder.hpp"
+#include "logic/ScriptedBot.hpp"
+#include "logic/SolverBot.hpp"
+#include "logic/TickProfiler.hpp"
+#include "../common/utils/Log.hpp"
+#include "../common/utils/WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Headless batch simulator: runs many bot-driven matches on every map in a
+// directory in parallel and reports throughput and per-map outcomes.
+// Doubles as a CPU benchmark for GameRoom/PhysicsEngine/MapLoader.
+//
+// Usage: match_sim [--matches N] [--threads T] [--maps DIR] [--max-ticks N] [--seed S] [--bot scripted|solver]
+//                  [--profile]
+//
+// --maps procedural[:WxH] generates a fresh map from each match's seed instead.
+// Solver bots search inline on their match's worker; the pool parallelises across matches.
+// --profile times every tick's phases (see TickProfiler) and reports them per worker.
+
+namespace {
+constexpr float kTickSeconds = 1.0f / 60.0f;
+
+struct SimConfig {
+    int matches = 1000;
+    size_t threads = 0;
+    std::string mapDir = "assets/maps";
+    uint32_t maxTicks = 60 * 60 * 5;
+    uint32_t seed = 1;
+    bool solverBots = false;
+    bool profile = false;
+    bool procedural = false;
+    int mapWidth = 0;
+    int mapHeight = 0;
+};
+
+struct MatchOutcome {
+    int mapIndex = 0;
+    int winner = -1; // player id, -1 = no winner
+    bool timedOut = false;
+    uint32_t ticks = 0;
+    uint32_t shots = 0;
+};
+
+struct MapStats {
+    int matches = 0;
+    int wins[INGAME_MAX_PLAYERS] = {0};
+    int draws = 0;
+    int timeouts = 0;
+    uint64_t ticks = 0;
+    uint64_t shots = 0;
+};
+
+MatchOutcome RunMatch(const MapLoader& pristine, int mapIndex, uint32_t seed, const SimConfig& config) {
+    const uint32_t maxTicks = config.maxTicks;
+    const bool solverBots = config.solverBots;
+
+    MapLoader map;
+    if (config.procedural) {
+        MapGenerator::Generate(map, seed, config.mapWidth, config.mapHeight);
+    } else {
+        map = pristine;
+        map.generateSpawnPoints(seed);
+    }
+
+    const auto& spawns = map.getSpawnPoints();
+    std::vector<Player*> players;
+    std::vector<ScriptedBot> bots;
+    std::vector<std::unique_ptr<SolverBot>> solvers;
+    for (int i = 0; i < INGAME_MAX_PLAYERS; i++) {
+        const float sx = (spawns.size() > (size_t)i) ? spawns[i].x : 100.0f + 300.0f * i;
+        const float sy = (spawns.size() > (size_t)i) ? spawns[i].y : 100.0f;
+        players.push_back(new Player(i, "Bot" + std::to_string(i + 1), sx, sy, i % 2 == 0));
+        if (solverBots) {
+            solvers.emplace_back(new SolverBot(i, nullptr));
+        } else {
+            bots.emplace_back(i, seed * 31u + (uint32_t)i);
+        }
+    }
+
+    GameRoom room(players);
+    room.setMapLoader(&map);
+    room.startGame();
+
+    MatchOutcome outcome;
+    outcome.mapIndex = mapIndex;
+
+    std::vector<BotCommand> commands;
+    auto apply = [&](int playerId) {
+        for (const auto& c : commands) {
+            const char* cmd = MatchRecording::CommandToString(c.command);
+            if (cmd && room.handleInput(playerId, cmd, c.value) && c.command == INGAME_CMD_FIRE) {
+                outcome.shots++;
+            }
+        }
+    };
+
+    TickProfiler profiler((uint64_t)(kTickSeconds * 1e9f));
+    uint32_t tick = 0;
+    while (room.getState() != GAME_OVER && tick < maxTicks) {
+        tick++;
+        if (config.profile) profiler.beginTick();
+        TickProfiler::Scope inputScope(PHASE_INPUT);
+        for (auto& bot : bots) {
+            commands.clear();
+            bot.think(room, commands);
+            apply(bot.getPlayerId());
+        }
+        for (auto& bot : solvers) {
+            commands.clear();
+            bot->think(room, kTickSeconds, commands);
+            apply(bot->getPlayerId());
+        }
+        inputScope.stop();
+        room.update(kTickSeconds);
+        if (config.profile) profiler.endTick();
+    }
+
+    outcome.ticks = tick;
+    outcome.timedOut = room.getState() != GAME_OVER;
+    if (!outcome.timedOut) {
+        for (const Player* p : room.getPlayers()) {
+            if (p->isAlive()) outcome.winner = p->getId();
+        }
+    }
+
+    for (auto* p : players) delete p;
+    return outcome;
+}
+
+bool ParseArgs(int argc, char** argv, SimConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--matches") == 0 && hasValue) {
+            config.matches = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            config.threads = (size_t)std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--maps") == 0 && hasValue) {
+            config.mapDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--max-ticks") == 0 && hasValue) {
+            config.maxTicks = (uint32_t)std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            config.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--bot") == 0 && hasValue) {
+            const char* kind = argv[++i];
+            if (std::strcmp(kind, "solver") == 0) config.solverBots = true;
+            else if (std::strcmp(kind, "scripted") == 0) config.solverBots = false;
+            else {
+                std::cerr << "match_sim: unknown bot kind " << kind << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--profile") == 0) {
+            config.profile = true;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--matches N] [--threads T] [--maps DIR] [--max-ticks N] [--seed S] [--bot scripted|solver]"
+                         " [--profile]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    if (!ParseArgs(argc, argv, config)) return 1;
+
+    std::vector<std::string> mapPaths;
+    std::error_code ec;
+    config.procedural = MapGenerator::ParseName(config.mapDir, config.mapWidth, config.mapHeight);
+    if (config.procedural) {
+        mapPaths.push_back(config.mapDir);
+    } else {
+        for (const auto& entry : std::filesystem::directory_iterator(config.mapDir, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+                mapPaths.push_back(entry.path().string());
+            }
+        }
+    }
+    std::sort(mapPaths.begin(), mapPaths.end());
+    if (mapPaths.empty()) {
+        std::cerr << "match_sim: no maps found in " << config.mapDir << std::endl;
+        return 1;
+    }
+
+    std::vector<MapLoader> maps(mapPaths.size());
+    for (size_t i = 0; i < mapPaths.size() && !config.procedural; i++) {
+        if (!maps[i].loadMap(mapPaths[i], config.seed)) {
+            std::cerr << "match_sim: failed to load map " << mapPaths[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // GameRoom/PhysicsEngine log every turn and hit; mute that for batch runs.
+    Log::setLevel(Log::LEVEL_OFF);
+
+    std::vector<MatchOutcome> outcomes(config.matches);
+    WorkStealingPool pool(config.threads);
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    for (int i = 0; i < config.matches; i++) {
+        pool.submit([&, i] {
+            const int mapIndex = i % (int)maps.size();
+            outcomes[i] = RunMatch(maps[mapIndex], mapIndex, config.seed + (uint32_t)i, config);
+        });
+    }
+    pool.waitIdle();
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::vector<MapStats> stats(maps.size());
+    uint64_t totalTicks = 0;
+    for (const auto& o : outcomes) {
+        MapStats& s = stats[o.mapIndex];
+        s.matches++;
+        s.ticks += o.ticks;
+        s.shots += o.shots;
+        totalTicks += o.ticks;
+        if (o.timedOut) s.timeouts++;
+        else if (o.winner >= 0 && o.winner < INGAME_MAX_PLAYERS) s.wins[o.winner]++;
+        else s.draws++;
+    }
+
+    std::printf("%d matches on %zu maps, %zu threads, %.3f s\n", config.matches, maps.size(), pool.size(), seconds);
+    std::printf("throughput: %.1f matches/s, %.0f ticks/s (%.0fx real time)\n",
+                config.matches / seconds, totalTicks / seconds, totalTicks * kTickSeconds / seconds);
+    std::printf("\n%-28s %8s %8s %8s %8s %8s %10s %8s\n", "map", "matches", "p1 win", "p2 win", "draw", "timeout", "avg ticks", "shots");
+    for (size_t i = 0; i < maps.size(); i++) {
+        const MapStats& s = stats[i];
+        if (s.matches == 0) continue;
+        const std::string name = std::filesystem::path(mapPaths[i]).filename().string();
+        std::printf("%-28s %8d %7.1f%% %7.1f%% %7.1f%% %7.1f%% %10.0f %8.1f\n",
+                    name.c_str(), s.matches,
+                    100.0 * s.wins[0] / s.matches, 100.0 * s.wins[1] / s.matches,
+                    100.0 * s.draws / s.matches, 100.0 * s.timeouts / s.matches,
+                    (double)s.ticks / s.matches, (double)s.shots / s.matches);
+    }
+
+    if (config.profile) {
+        // Each worker's histograms cover every tick of every match it ran.
+        const auto workers = TickProfiler::workers();
+        PhaseHistograms all;
+        for (const auto* w : workers) all.merge(*w);
+
+        std::printf("\ntick phases over %llu ticks (us), %llu over the %.1f ms real-time budget\n",
+                    (unsigned long long)all.phases[PHASE_TICK].count(), (unsigned long long)all.overruns.load(),
+                    kTickSeconds * 1e3f);
+        std::printf("%-20s %9s %9s %9s %9s %9s\n", "phase", "mean", "p50", "p99", "p99.9", "max");
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            const LatencyHistogram& h = all.phases[p];
+            if (h.max() == 0) continue;
+            std::printf("%-20s %9.2f %9.2f %9.2f %9.2f %9.2f\n", tickPhaseName(p), h.sum() / 1e3 / (double)h.count(),
+                        h.percentile(0.50) / 1e3, h.percentile(0.99) / 1e3, h.percentile(0.999) / 1e3, h.max() / 1e3);
+        }
+        std::printf("\n%-8s %10s %9s %9s %9s\n", "worker", "ticks", "tick p50", "tick p99", "tick max");
+        for (size_t i = 0; i < workers.size(); i++) {
+            const LatencyHistogram& h = workers[i]->phases[PHASE_TICK];
+            std::printf("%-8zu %10llu %9.2f %9.2f %9.2f\n", i, (unsigned long long)h.count(), h.percentile(0.50) / 1e3,
+                        h.percentile(0.99) / 1e3, h.max() / 1e3);
+        }
+    }
+    return 0;
+}
@@ -1,27 +1,31 @@
 #include "ServiceServer.hpp"
 #include "../../common/network/PacketUtils.hpp"
 #include "../../common/network/PacketStructs.hpp"
+#include "../../common/utils/Log.hpp"
 #include <iostream>
+#include <netinet/in.h>
 
-UserDAO* ServiceServer::CreateAndConnectDAO() {
-    DatabaseServer* db = new DatabaseServer("gummydatabase", "postgres", "Hehehe123");
-    
-    if (!db->connect()) {
-        std::cerr << "ServiceServer: Could not connect to database!" << std::endl;
-    } else {
-        std::cout << "ServiceServer: Database connected successfully." << std::endl;
-    }
-
-    return new UserDAO(db);
+namespace {
+// Ingame servers run next to the service; match reports from anywhere else are refused.
+bool IsLoopbackPeer(int fd) {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (getpeername(fd, (sockaddr*)&addr, &len) != 0 || addr.sin_family != AF_INET) return false;
+    return (ntohl(addr.sin_addr.s_addr) >> 24) == 127;
+}
 }
 
-ServiceServer::ServiceServer() 
+ServiceServer::ServiceServer(UserDAO* userDao, MatchDAO* matchDao) 
     : mIsRunning(false),
-      mAuthServer(CreateAndConnectDAO())
+      mAuthServer(userDao),
+      mMatchDao(matchDao),
+      mConnectionCount(0),
+      mConnectionsAccepted(0)
 {}
 
 ServiceServer::~ServiceServer() {
     Stop();
+    delete mMatchDao;
 }
 
 void ServiceServer::Stop() {
@@ -32,7 +36,9 @@ void ServiceServer::Stop() {
 void ServiceServer::Run(int port) {
     try {
         mServiceServerSocket.Bind(port);
-        mServiceServerSocket.Listen();
+        // Clients reconnect all at once after an outage or a launch; a short backlog turns
+        // that into SYN retries measured in seconds.
+        mServiceServerSocket.Listen(SOMAXCONN);
         mIsRunning = true;
         std::cout << "ServiceServer Listening on port " << port << std::endl;
 
@@ -41,7 +47,9 @@ void ServiceServer::Run(int port) {
             if (clientSocket == nullptr) {
                 continue;
             }
-            std::cout << "ServiceServer Accepted connection from client." << std::endl;
+            LOG_INFO("connection_accepted", "fd", clientSocket->GetFd());
+            mConnectionCount.fetch_add(1, std::memory_order_relaxed);
+            mConnectionsAccepted.fetch_add(1, std::memory_order_relaxed);
             std::thread clientThread(&ServiceServer::HandleClient, this, clientSocket);
             clientThread.detach();
         }
@@ -52,19 +60,20 @@ void ServiceServer::Run(int port) {
 
 void ServiceServer::HandleClient(TCPSocket* clientSocket) {
     bool connected = true;
+    long sessionUserId = -1;
     std::vector<char> headerBuffer(sizeof(Header));
 
     while (connected && mIsRunning) {
         int bytesRead = clientSocket->Receive(headerBuffer.data(), headerBuffer.size());
         if (bytesRead <= 0) {
-            std::cout << "Thread Client disconnected or error occurred." << std::endl;
+            LOG_INFO("connection_closed", "fd", clientSocket->GetFd(), "user", sessionUserId);
             connected = false;
             break;
         }
 
         Header header;
         if (!PacketUtils::ReadHeader(headerBuffer.data(), bytesRead, header)) {
-            std::cout << "Thread Client failed to read header." << std::endl;
+            LOG_WARN("bad_header", "fd", clientSocket->GetFd(), "bytes", bytesRead);
             connected = false;
             break;
         }
@@ -73,7 +82,7 @@ void ServiceServer::HandleClient(TCPSocket* clientSocket) {
         if (header.length > 0) {
             bytesRead = clientSocket->Receive(payloadBuffer.data(), payloadBuffer.size());
             if (bytesRead <= 0) {
-                std::cerr << "Thread Client disconnected or error occurred while reading payload." << std::endl;
+                LOG_WARN("payload_read_failed", "fd", clientSocket->GetFd(), "type", (int)header.type, "length", header.length);
                 connected = false;
                 break;
             }
@@ -82,25 +91,27 @@ void ServiceServer::HandleClient(TCPSocket* clientSocket) {
         Packet packet;
         packet.header = header;
         packet.payload = payloadBuffer;
+        Metrics::countPacket(Metrics::PACKETS_IN, header.type, sizeof(Header) + header.length);
 
         switch (header.type) {
             // User try to LOGIN or REGISTER -------------------------------------------------------------------------------------------------------------
             case PacketType::REQ_AUTHENTICATE: {
                 ReqAuthenticate req = packet.GetPayload<ReqAuthenticate>();
+                req.username[sizeof(req.username) - 1] = '\0';
+                req.password[sizeof(req.password) - 1] = '\0';
                 UserData outUser;
                 ResAuthenticate res;
                 if (req.isLogin) {
                     if (mAuthServer.login(req.username, req.password, outUser)) {
                         res.isLogin = true;
                         res.isSuccess = true;
-                        strcpy(res.message, "Login successful.");
+                        sessionUserId = outUser.id;
                         std::snprintf(res.message, sizeof(res.message), "Login successful. Welcome, %s!", outUser.username.c_str());
                     } else {
                         res.isLogin = true;
                         res.isSuccess = false;
                         std::snprintf(res.message, sizeof(res.message), "Login failed. Invalid credentials.");     
                     }
-                    PacketUtils::SendPacket(clientSocket, PacketType::RES_AUTHENTICATE, res);
                 } else {
                     long outUserId;
                     if (mAuthServer.reg(req.username, req.password, outUserId)) {
@@ -119,7 +130,7 @@ void ServiceServer::HandleClient(TCPSocket* clientSocket) {
             // -------------------------------------------------------------------------------------------------------------------------------------------
             // User LOGOUT -------------------------------------------------------------------------------------------------------------------------------
             case PacketType::REQ_LOGOUT: {
-                std::cout << "Client requested logout." << std::endl;
+                LOG_INFO("logout", "fd", clientSocket->GetFd(), "user", sessionUserId);
                 connected = false; 
             }
             break;
@@ -127,9 +138,12 @@ void ServiceServer::HandleClient(TCPSocket* clientSocket) {
             // User CHANGE PASSWORD ----------------------------------------------------------------------------------------------------------------------
             case PacketType::REQ_CHANGE_PASSWORD: {
                 ReqChangePassword req = packet.GetPayload<ReqChangePassword>();
-                long userId;
+                req.newPassword[sizeof(req.newPassword) - 1] = '\0';
                 ResChangePassword res;
-                if (mAuthServer.changePassword(userId, req.newPassword)) {
+                if (sessionUserId < 0) {
+                    res.isSuccess = false;
+                    std::snprintf(res.message, sizeof(res.message), "Password change failed. Not logged in.");
+                } else if (mAuthServer.changePassword(sessionUserId, req.newPassword)) {
                     res.isSuccess = true;
                     std::snprintf(res.message, sizeof(res.message), "Password change successful.");
                 } else {
@@ -140,12 +154,37 @@ void ServiceServer::HandleClient(TCPSocket* clientSocket) {
             }
             break;
             // -------------------------------------------------------------------------------------------------------------------------------------------
+            // Ingame server MATCH LOG PATH --------------------------------------------------------------------------------------------------------------
+            case PacketType::REQ_MATCH_LOG_PATH: {
+                ReqMatchLogPath req = packet.GetPayload<ReqMatchLogPath>();
+                req.logPath[sizeof(req.logPath) - 1] = '\0';
+                if (!IsLoopbackPeer(clientSocket->GetFd())) {
+                    LOG_WARN("match_log_path_rejected", "fd", clientSocket->GetFd(), "match", req.matchId);
+                } else if (!mMatchDao) {
+                    LOG_WARN("match_log_path_dropped", "match", req.matchId, "path", req.logPath);
+                } else if (mMatchDao->updateLogPath(req.matchId, req.logPath)) {
+                    LOG_INFO("match_log_path", "match", req.matchId, "path", req.logPath);
+                } else {
+                    LOG_WARN("match_log_path_failed", "match", req.matchId, "path", req.logPath);
+                }
+                connected = false;
+            }
+            break;
+            // -------------------------------------------------------------------------------------------------------------------------------------------
             default:
-                std::cerr << "Thread Client received unknown packet type: " << static_cast<int>(header.type) << std::endl;
+                LOG_WARN("unknown_packet", "fd", clientSocket->GetFd(), "type", (int)header.type);
                 break;
         }
     }
 
     clientSocket->Close();
     delete clientSocket;
+    mConnectionCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ServiceServer::WriteMetrics(PrometheusText& out) const {
+    out.Family("gummy_service_connections", "gauge", "Open client connections.");
+    out.Sample("gummy_service_connections", "", mConnectionCount.load(std::memory_order_relaxed));
+    out.Family("gummy_service_connections_accepted_total", "counter", "Client connections accepted.");
+    out.Sample("gummy_service_connections_accepted_total", "", (double)mConnectionsAccepted.load(std::memory_order_relaxed));
 }
\ No newline at end of file
@@ -5,7 +5,9 @@
 #include <thread>
 #include <atomic>
 #include "../../common/network/TCPSocket.hpp"
+#include "../../common/metrics/MetricsServer.hpp"
 #include "../logic/AuthServer.hpp" 
+#include "../database/MatchDAO.hpp"
 
 class ServiceServer {
 private:
@@ -13,19 +15,27 @@ private:
     std::atomic<bool> mIsRunning;
     
     AuthServer mAuthServer;
+    MatchDAO* mMatchDao;   // null without a database
+
+    std::atomic<int> mConnectionCount;
+    std::atomic<uint64_t> mConnectionsAccepted;
 
     void HandleClient(TCPSocket* clientSocket);
 
 public:
-    ServiceServer();
+    // Takes ownership of userDao (PostgresUserDAO, or MemoryUserDAO without a database)
+    // and of matchDao, which may be null.
+    explicit ServiceServer(UserDAO* userDao, MatchDAO* matchDao = nullptr);
     ~ServiceServer();
 
-    UserDAO* CreateAndConnectDAO();
     // The main loop that waits for connections
     void Run(int port);
     
     // Signal to stop the server
     void Stop();
+
+    // gummy_service_* connection metrics; safe to call from any thread.
+    void WriteMetrics(PrometheusText& out) const;
 };
 
 #endif
\ No newline at end of file
@@ -23,3 +23,7 @@ bool DatabaseServer::connect() {
 pqxx::connection* DatabaseServer::getConnection() {
     return conn.get();
 }
+
+std::mutex& DatabaseServer::getMutex() {
+    return mtx;
+}
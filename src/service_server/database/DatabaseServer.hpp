@@ -4,6 +4,7 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <mutex>
 #include <iostream>
 #include <pqxx/pqxx> 
 
@@ -11,6 +12,7 @@ class DatabaseServer {
 private:
     std::unique_ptr<pqxx::connection> conn;
     std::string connection_string;
+    std::mutex mtx;
 
 public:
     DatabaseServer(const std::string& db_name, const std::string& user, const std::string& password);
@@ -18,6 +20,10 @@ public:
     bool connect();
 
     pqxx::connection* getConnection();
+
+    // A pqxx::connection must not be used by two threads at once; every DAO holds this
+    // for the duration of its transaction.
+    std::mutex& getMutex();
 };
 
 #endif // DATABASE_SERVER_HPP
\ No newline at end of file
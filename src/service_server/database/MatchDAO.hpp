@@ -0,0 +1,17 @@
+#ifndef MATCHDAO_HPP
+#define MATCHDAO_HPP
+
+#pragma once
+#include <string>
+
+// Match storage behind ServiceServer. PostgresMatchDAO is the only implementation; the
+// server runs without one under --memory-db. Called from every client thread at once.
+class MatchDAO {
+public:
+    virtual ~MatchDAO() = default;
+
+    // Stores the path of the match input recording (see MatchRecorder) in "Match".log_path.
+    virtual bool updateLogPath(long matchId, const std::string& logPath) = 0;
+};
+
+#endif // MATCHDAO_HPP
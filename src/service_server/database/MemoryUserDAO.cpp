@@ -0,0 +1,102 @@
+#include "MemoryUserDAO.hpp"
+
+MemoryUserDAO::MemoryUserDAO() {}
+
+UserData* MemoryUserDAO::find(long userId) {
+    if (userId < 1 || userId > (long)users.size() || deleted[userId - 1]) {
+        return nullptr;
+    }
+    return &users[userId - 1];
+}
+
+void MemoryUserDAO::unindexName(const std::string& username, long userId) {
+    auto range = idsByName.equal_range(username);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == userId) {
+            idsByName.erase(it);
+            return;
+        }
+    }
+}
+
+bool MemoryUserDAO::deleteUser(const u_int32_t userid) {
+    std::lock_guard<std::mutex> lock(mtx);
+    UserData* user = find(userid);
+    if (user) {
+        unindexName(user->username, user->id);
+        deleted[user->id - 1] = true;
+    }
+    // DELETE of a missing row is not an error either.
+    return true;
+}
+
+long MemoryUserDAO::createUser(const std::string& username, const std::string& password) {
+    // Same limits as the VARCHAR columns.
+    if (username.size() > 32 || password.size() > 256) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    long id = (long)users.size() + 1;
+    users.push_back(UserData{id, username, 300, password});
+    deleted.push_back(false);
+    idsByName.emplace(username, id);
+    return id;
+}
+
+std::optional<UserData> MemoryUserDAO::authenticate(const std::string& username, const std::string& password) {
+    std::lock_guard<std::mutex> lock(mtx);
+    const UserData* match = nullptr;
+    int matches = 0;
+    auto range = idsByName.equal_range(username);
+    for (auto it = range.first; it != range.second; ++it) {
+        const UserData& user = users[it->second - 1];
+        if (user.password == password) {
+            match = &user;
+            matches++;
+        }
+    }
+    if (matches == 1) {
+        return *match;
+    }
+    return std::nullopt;
+}
+
+bool MemoryUserDAO::updateElo(long userId, int newElo) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (UserData* user = find(userId)) {
+        user->elo = newElo;
+    }
+    return true;
+}
+
+bool MemoryUserDAO::updatePassword(long userId, const std::string& newPassword) {
+    if (newPassword.size() > 256) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    if (UserData* user = find(userId)) {
+        user->password = newPassword;
+    }
+    return true;
+}
+
+bool MemoryUserDAO::updateUsername(long userId, const std::string& newUsername) {
+    if (newUsername.size() > 32) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    if (UserData* user = find(userId)) {
+        unindexName(user->username, userId);
+        user->username = newUsername;
+        idsByName.emplace(newUsername, userId);
+    }
+    return true;
+}
+
+std::optional<UserData> MemoryUserDAO::getUserById(long userId) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (UserData* user = find(userId)) {
+        return *user;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,43 @@
+#ifndef MEMORY_USERDAO_HPP
+#define MEMORY_USERDAO_HPP
+
+#pragma once
+#include "UserDAO.hpp"
+#include <mutex>
+#include <string>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// In-process stand-in for PostgresUserDAO: same rules as the "User" table in Schema.sql
+// (ids from 1, elo 300, usernames not unique, login needs exactly one match), nothing
+// persisted. For running the service server without a database, and for load tests.
+class MemoryUserDAO : public UserDAO {
+private:
+    std::mutex mtx;
+    std::vector<UserData> users;        // users[id - 1]
+    std::vector<bool> deleted;
+    std::unordered_multimap<std::string, long> idsByName;
+
+    UserData* find(long userId);
+    void unindexName(const std::string& username, long userId);
+
+public:
+    MemoryUserDAO();
+
+    bool deleteUser(const u_int32_t userid) override;
+
+    long createUser(const std::string& username, const std::string& password) override;
+
+    std::optional<UserData> authenticate(const std::string& username, const std::string& password) override;
+
+    bool updateElo(long userId, int newElo) override;
+
+    bool updatePassword(long userId, const std::string& newPassword) override;
+
+    bool updateUsername(long userId, const std::string& newUsername) override;
+
+    std::optional<UserData> getUserById(long userId) override;
+};
+
+#endif // MEMORY_USERDAO_HPP
@@ -0,0 +1,69 @@
+#include "MeteredUserDAO.hpp"
+#include <chrono>
+
+namespace {
+const char* const kOpNames[] = {"delete_user", "create_user", "authenticate", "update_elo",
+                                "update_password", "update_username", "get_user_by_id"};
+
+// A call fails when it returns false, -1 or no row.
+bool Failed(bool ok) { return !ok; }
+bool Failed(long id) { return id == -1; }
+bool Failed(const std::optional<UserData>& row) { return !row; }
+}
+
+MeteredUserDAO::MeteredUserDAO(UserDAO* inner) : inner(inner), failures(OP_COUNT) {}
+
+MeteredUserDAO::~MeteredUserDAO() {
+    delete inner;
+}
+
+template <typename F>
+auto MeteredUserDAO::timed(Op op, F&& call) -> decltype(call()) {
+    const auto start = std::chrono::steady_clock::now();
+    auto result = call();
+    latency[op].record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start).count());
+    if (Failed(result)) failures.add(op);
+    return result;
+}
+
+bool MeteredUserDAO::deleteUser(const u_int32_t userid) {
+    return timed(OP_DELETE_USER, [&] { return inner->deleteUser(userid); });
+}
+
+long MeteredUserDAO::createUser(const std::string& username, const std::string& password) {
+    return timed(OP_CREATE_USER, [&] { return inner->createUser(username, password); });
+}
+
+std::optional<UserData> MeteredUserDAO::authenticate(const std::string& username, const std::string& password) {
+    return timed(OP_AUTHENTICATE, [&] { return inner->authenticate(username, password); });
+}
+
+bool MeteredUserDAO::updateElo(long userId, int newElo) {
+    return timed(OP_UPDATE_ELO, [&] { return inner->updateElo(userId, newElo); });
+}
+
+bool MeteredUserDAO::updatePassword(long userId, const std::string& newPassword) {
+    return timed(OP_UPDATE_PASSWORD, [&] { return inner->updatePassword(userId, newPassword); });
+}
+
+bool MeteredUserDAO::updateUsername(long userId, const std::string& newUsername) {
+    return timed(OP_UPDATE_USERNAME, [&] { return inner->updateUsername(userId, newUsername); });
+}
+
+std::optional<UserData> MeteredUserDAO::getUserById(long userId) {
+    return timed(OP_GET_USER_BY_ID, [&] { return inner->getUserById(userId); });
+}
+
+void MeteredUserDAO::WriteMetrics(PrometheusText& out) const {
+    out.Family("gummy_service_dao_seconds", "histogram", "UserDAO call latency, by operation.");
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (latency[op].count() == 0) continue;
+        out.Histogram("gummy_service_dao_seconds", std::string("op=\"") + kOpNames[op] + "\"", latency[op]);
+    }
+    out.Family("gummy_service_dao_failures_total", "counter", "UserDAO calls that returned an error or no row, by operation.");
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (latency[op].count() == 0) continue;
+        out.Sample("gummy_service_dao_failures_total", std::string("op=\"") + kOpNames[op] + "\"", (double)failures.sum(op));
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef METERED_USERDAO_HPP
+#define METERED_USERDAO_HPP
+
+#pragma once
+#include "UserDAO.hpp"
+#include "../../common/metrics/MetricsServer.hpp"
+#include <string>
+#include <optional>
+
+// Times every call into another UserDAO (which it owns) for gummy_service_dao_seconds.
+// Each call records into the calling thread's shard, so the DAO stays as concurrent as
+// the one it wraps.
+class MeteredUserDAO : public UserDAO {
+private:
+    enum Op {
+        OP_DELETE_USER,
+        OP_CREATE_USER,
+        OP_AUTHENTICATE,
+        OP_UPDATE_ELO,
+        OP_UPDATE_PASSWORD,
+        OP_UPDATE_USERNAME,
+        OP_GET_USER_BY_ID,
+        OP_COUNT
+    };
+
+    UserDAO* inner;
+    Metrics::Histogram latency[OP_COUNT];
+    Metrics::CounterSet failures;
+
+    template <typename F>
+    auto timed(Op op, F&& call) -> decltype(call());
+
+public:
+    explicit MeteredUserDAO(UserDAO* inner);
+    ~MeteredUserDAO() override;
+
+    bool deleteUser(const u_int32_t userid) override;
+
+    long createUser(const std::string& username, const std::string& password) override;
+
+    std::optional<UserData> authenticate(const std::string& username, const std::string& password) override;
+
+    bool updateElo(long userId, int newElo) override;
+
+    bool updatePassword(long userId, const std::string& newPassword) override;
+
+    bool updateUsername(long userId, const std::string& newUsername) override;
+
+    std::optional<UserData> getUserById(long userId) override;
+
+    void WriteMetrics(PrometheusText& out) const;
+};
+
+#endif // METERED_USERDAO_HPP
@@ -0,0 +1,21 @@
+#include "PostgresMatchDAO.hpp"
+#include "../../common/utils/Log.hpp"
+
+PostgresMatchDAO::PostgresMatchDAO(DatabaseServer* database) : db(database) {}
+
+bool PostgresMatchDAO::updateLogPath(long matchId, const std::string& logPath) {
+    try {
+        std::lock_guard<std::mutex> lock(db->getMutex());
+        pqxx::work W(*db->getConnection());
+
+        std::string sql = "UPDATE \"Match\" SET log_path = " + W.quote(logPath) +
+                          " WHERE match_id = " + std::to_string(matchId);
+
+        pqxx::result R = W.exec(sql);
+        W.commit();
+        return R.affected_rows() == 1;
+    } catch (const std::exception &e) {
+        LOG_WARN("db_update_log_path_failed", "match", matchId, "error", e.what());
+        return false;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef POSTGRES_MATCHDAO_HPP
+#define POSTGRES_MATCHDAO_HPP
+
+#pragma once
+#include "MatchDAO.hpp"
+#include "DatabaseServer.hpp"
+#include <string>
+
+class PostgresMatchDAO : public MatchDAO {
+private:
+    DatabaseServer* db;
+
+public:
+    PostgresMatchDAO(DatabaseServer* database);
+
+    bool updateLogPath(long matchId, const std::string& logPath) override;
+};
+
+#endif // POSTGRES_MATCHDAO_HPP
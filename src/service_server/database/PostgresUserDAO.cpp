@@ -1,22 +1,25 @@
-#include "UserDAO.hpp"
+#include "PostgresUserDAO.hpp"
+#include "../../common/utils/Log.hpp"
 
-UserDAO::UserDAO(DatabaseServer* database) : db(database) {}
+PostgresUserDAO::PostgresUserDAO(DatabaseServer* database) : db(database) {}
 
-bool UserDAO::deleteUser(const u_int32_t userid) {
+bool PostgresUserDAO::deleteUser(const u_int32_t userid) {
     try {
+        std::lock_guard<std::mutex> lock(db->getMutex());
         pqxx::work W(*db->getConnection());
         std::string sql = "DELETE FROM \"User\" WHERE user_id = " + std::to_string(userid) + ";";
         W.exec(sql);
         W.commit();
         return true;
     } catch (const std::exception &e) {
-        std::cerr << "Delete Error: " << e.what() << std::endl;
+        LOG_WARN("db_delete_user_failed", "user", userid, "error", e.what());
         return false;
     }
 }
 
-long UserDAO::createUser(const std::string& username, const std::string& password) {
+long PostgresUserDAO::createUser(const std::string& username, const std::string& password) {
     try {
+        std::lock_guard<std::mutex> lock(db->getMutex());
         pqxx::work W(*db->getConnection());
         std::string sql = "INSERT INTO \"User\" (username, password) VALUES (" + 
                           W.quote(username) + ", " + 
@@ -26,13 +29,14 @@ long UserDAO::createUser(const std::string& username, const std::string& passwor
         W.commit();
         return row[0].as<long>();
     } catch (const std::exception &e) {
-        std::cerr << "Register Error: " << e.what() << std::endl;
+        LOG_WARN("db_create_user_failed", "error", e.what());
         return -1;
     }
 }
 
-std::optional<UserData> UserDAO::authenticate(const std::string& username, const std::string& password) {
+std::optional<UserData> PostgresUserDAO::authenticate(const std::string& username, const std::string& password) {
     try {
+        std::lock_guard<std::mutex> lock(db->getMutex());
         pqxx::work W(*db->getConnection());
         std::string sql = "SELECT user_id, username, elo, COALESCE(info, '') "
                           "FROM \"User\" "
@@ -51,13 +55,14 @@ std::optional<UserData> UserDAO::authenticate(const std::string& username, const
         }
         return std::nullopt;
     } catch (const std::exception &e) {
-        std::cerr << "Login Error: " << e.what() << std::endl;
+        LOG_WARN("db_authenticate_failed", "error", e.what());
         return std::nullopt;
     }
 }
 
-bool UserDAO::updateElo(long userId, int newElo) {
+bool PostgresUserDAO::updateElo(long userId, int newElo) {
     try {
+        std::lock_guard<std::mutex> lock(db->getMutex());
         pqxx::work W(*db->getConnection());
         
         std::string sql = "UPDATE \"User\" SET elo = " + std::to_string(newElo) + 
@@ -67,13 +72,14 @@ bool UserDAO::updateElo(long userId, int newElo) {
         W.commit();
         return true;
     } catch (const std::exception &e) {
-        std::cerr << "Update Elo Error: " << e.what() << std::endl;
+        LOG_WARN("db_update_elo_failed", "user", userId, "error", e.what());
         return false;
     }
 }
 
-bool UserDAO::updatePassword(long userId, const std::string& newPassword) {
+bool PostgresUserDAO::updatePassword(long userId, const std::string& newPassword) {
     try {
+        std::lock_guard<std::mutex> lock(db->getMutex());
         pqxx::work W(*db->getConnection());
         
         std::string sql = "UPDATE \"User\" SET password = " + W.quote(newPassword) + 
@@ -83,13 +89,14 @@ bool UserDAO::updatePassword(long userId, const std::string& newPassword) {
         W.commit();
         return true;
     } catch (const std::exception &e) {
-        std::cerr << "Update Password Error: " << e.what() << std::endl;
+        LOG_WARN("db_update_password_failed", "user", userId, "error", e.what());
         return false;
     }
 }
 
-bool UserDAO::updateUsername(long userId, const std::string& newUsername) {
+bool PostgresUserDAO::updateUsername(long userId, const std::string& newUsername) {
     try {
+        std::lock_guard<std::mutex> lock(db->getMutex());
         pqxx::work W(*db->getConnection());
         
         std::string sql = "UPDATE \"User\" SET username = " + W.quote(newUsername) + 
@@ -99,13 +106,14 @@ bool UserDAO::updateUsername(long userId, const std::string& newUsername) {
         W.commit();
         return true;
     } catch (const std::exception &e) {
-        std::cerr << "Update Username Error: " << e.what() << std::endl;
+        LOG_WARN("db_update_username_failed", "user", userId, "error", e.what());
         return false;
     }
 }
 
-std::optional<UserData> UserDAO::getUserById(long userId) {
+std::optional<UserData> PostgresUserDAO::getUserById(long userId) {
     try {
+        std::lock_guard<std::mutex> lock(db->getMutex());
         pqxx::work W(*db->getConnection());
         std::string sql = "SELECT user_id, username, elo, COALESCE(password, '') FROM \"User\" WHERE user_id = " + std::to_string(userId);
         pqxx::result R = W.exec(sql);
@@ -0,0 +1,33 @@
+#ifndef POSTGRES_USERDAO_HPP
+#define POSTGRES_USERDAO_HPP
+
+#pragma once
+#include "UserDAO.hpp"
+#include "DatabaseServer.hpp"
+#include <string>
+#include <optional>
+#include <iostream>
+
+class PostgresUserDAO : public UserDAO {
+private:
+    DatabaseServer* db;
+
+public:
+    PostgresUserDAO(DatabaseServer* database);
+
+    bool deleteUser(const u_int32_t userid) override;
+
+    long createUser(const std::string& username, const std::string& password) override;
+
+    std::optional<UserData> authenticate(const std::string& username, const std::string& password) override;
+
+    bool updateElo(long userId, int newElo) override;
+
+    bool updatePassword(long userId, const std::string& newPassword) override;
+
+    bool updateUsername(long userId, const std::string& newUsername) override;
+    
+    std::optional<UserData> getUserById(long userId) override;
+};
+
+#endif // POSTGRES_USERDAO_HPP
@@ -2,10 +2,9 @@
 #define USERDAO_HPP
 
 #pragma once
-#include "DatabaseServer.hpp"
 #include <string>
 #include <optional>
-#include <iostream>
+#include <sys/types.h>
 
 // Updated UserData struct to include 'elo' and 'info'
 struct UserData {
@@ -15,26 +14,27 @@ struct UserData {
     std::string password;
 };
 
+// User storage behind AuthServer. PostgresUserDAO is the real one; MemoryUserDAO keeps
+// everything in process for local runs and load tests. Implementations are called from
+// every client thread at once.
 class UserDAO {
-private:
-    DatabaseServer* db;
-
 public:
-    UserDAO(DatabaseServer* database);
+    virtual ~UserDAO() = default;
 
-    bool deleteUser(const u_int32_t userid);
+    virtual bool deleteUser(const u_int32_t userid) = 0;
 
-    long createUser(const std::string& username, const std::string& password);
+    // Returns the new user_id, or -1 on error.
+    virtual long createUser(const std::string& username, const std::string& password) = 0;
 
-    std::optional<UserData> authenticate(const std::string& username, const std::string& password);
+    virtual std::optional<UserData> authenticate(const std::string& username, const std::string& password) = 0;
 
-    bool updateElo(long userId, int newElo);
+    virtual bool updateElo(long userId, int newElo) = 0;
 
-    bool updatePassword(long userId, const std::string& newPassword);
+    virtual bool updatePassword(long userId, const std::string& newPassword) = 0;
 
-    bool updateUsername(long userId, const std::string& newUsername);
+    virtual bool updateUsername(long userId, const std::string& newUsername) = 0;
     
-    std::optional<UserData> getUserById(long userId);
+    virtual std::optional<UserData> getUserById(long userId) = 0;
 };
 
-#endif // USERDAO_HPP
\ No newline at end of file
+#endif // USERDAO_HPP
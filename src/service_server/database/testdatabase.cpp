@@ -1,6 +1,6 @@
 #include <iostream>
 #include "DatabaseServer.hpp"
-#include "UserDAO.hpp"
+#include "PostgresUserDAO.hpp"
 
 int main() {
     // 1. Create the DatabaseServer instance
@@ -10,7 +10,7 @@ int main() {
     if (db->connect()) {
         
         // 3. Pass the connected server to the DAO
-        UserDAO userDao(db);
+        PostgresUserDAO userDao(db);
 
         // 4. Perform operations
         long userId = userDao.createUser("testuser", "testpass");
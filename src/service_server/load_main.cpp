@@ -0,0 +1,799 @@
+#include "core/ServiceServer.hpp"
+#include "database/MemoryUserDAO.hpp"
+#include "../common/network/Packet.hpp"
+#include "../common/network/PacketStructs.hpp"
+#include "../common/network/PacketUtils.hpp"
+#include "../common/network/TCPSocket.hpp"
+#include "../common/utils/Log.hpp"
+#include "../common/utils/ProcStat.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Login-storm load generator for the service server. Opens --connections connections
+// (all at once, or --connect-rate per second), logs every one of them in, then sends
+// REQ_AUTHENTICATE login/register and REQ_CHANGE_PASSWORD at --rate requests/s spread
+// over those connections for --duration seconds.
+//
+// Usage: service_load [--host H] [--port P] [--in-process] [--connections N]
+//                     [--connect-rate R] [--rate R] [--mix LOGIN,REGISTER,CHANGE]
+//                     [--users N] [--threads T] [--duration S] [--warmup S]
+//                     [--timeout S] [--server-pid PID]... [--out FILE]
+//
+// --in-process runs a ServiceServer backed by MemoryUserDAO on P inside this process, so
+// nothing else is needed (it shares the machine with the load, as a local server would).
+// Otherwise point it at `service_server [port] [--memory-db]`.
+//
+// The schedule is open-loop: latency counts from when a request was due, so time spent
+// waiting for a free connection is included. --rate 0 is closed-loop instead: every
+// connection sends its next request as soon as the last one is answered.
+//
+// Reported per operation: p50/p99/p99.9/max latency and ok/rejected/failed/timeout
+// counts, for the storm (connect + first login) and the steady phase separately.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+enum Op { OP_CONNECT, OP_LOGIN, OP_REGISTER, OP_CHANGE_PASSWORD, OP_COUNT };
+const char* const kOpNames[OP_COUNT] = {"connect", "login", "register", "change_password"};
+
+constexpr std::chrono::milliseconds kReconnectDelay(100);
+constexpr std::chrono::milliseconds kScanInterval(20);
+
+struct LoadConfig {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    bool inProcess = false;
+    int connections = 1000;
+    double connectRate = 0.0;
+    double rate = 2000.0;
+    int mix[3] = {80, 10, 10};
+    int users = 1000;
+    int threads = 4;
+    double duration = 10.0;
+    double warmup = 2.0;
+    double timeout = 5.0;
+    std::vector<int> serverPids;
+    std::string outPath;
+};
+
+std::atomic<bool> g_stop(false);
+std::atomic<int> g_stormLeft(0);
+// Steady-phase window in Clock ticks; set by the main thread once the storm is over.
+std::atomic<int64_t> g_scheduleStart(INT64_MAX);
+std::atomic<int64_t> g_measureStart(INT64_MAX);
+std::atomic<int64_t> g_measureEnd(INT64_MAX);
+
+int64_t Ticks(Clock::time_point t) {
+    return t.time_since_epoch().count();
+}
+
+Clock::time_point FromTicks(int64_t ticks) {
+    return Clock::time_point(Clock::duration(ticks));
+}
+
+Clock::duration Seconds(double s) {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+}
+
+double Ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+struct OpStats {
+    std::vector<double> latencyMs; // answered requests (ok or rejected)
+    uint64_t ok = 0;
+    uint64_t rejected = 0;         // answered with isSuccess = false
+    uint64_t failed = 0;           // refused, reset or closed, or an unexpected answer
+    uint64_t timedOut = 0;
+
+    uint64_t Total() const { return ok + rejected + failed + timedOut; }
+    uint64_t Errors() const { return rejected + failed + timedOut; }
+
+    void Merge(const OpStats& other) {
+        latencyMs.insert(latencyMs.end(), other.latencyMs.begin(), other.latencyMs.end());
+        ok += other.ok;
+        rejected += other.rejected;
+        failed += other.failed;
+        timedOut += other.timedOut;
+    }
+};
+
+enum Outcome { OUT_OK, OUT_REJECTED, OUT_FAILED, OUT_TIMEOUT };
+
+struct Conn {
+    enum State { CLOSED, CONNECTING, IDLE, BUSY };
+    int fd = -1;
+    State state = CLOSED;
+    int account = 0;
+    bool loggedIn = false;
+    bool storm = true;              // first connect + login not finished yet
+    Op op = OP_CONNECT;
+    Clock::time_point due;          // when this request (or connect) was scheduled
+    Clock::time_point sent;         // when it went out, for the timeout
+    Clock::time_point reconnectAt;
+    std::vector<char> out;
+    size_t outPos = 0;
+    std::vector<char> in;
+    bool wantWrite = false;
+};
+
+struct Worker {
+    int index = 0;
+    const LoadConfig* config = nullptr;
+    std::string runTag;
+    int epollFd = -1;
+    std::vector<Conn> conns;
+    std::vector<int> idle;
+    std::deque<std::pair<Clock::time_point, Op>> pending; // due, but no free connection yet
+    std::mt19937 rng;
+    uint64_t registered = 0;
+    uint64_t unsent = 0;
+    OpStats storm[OP_COUNT];
+    OpStats steady[OP_COUNT];
+
+    void Run();
+
+private:
+    Op PickOp();
+    void StartConnect(int id, Clock::time_point due);
+    void OnConnected(int id, Clock::time_point now);
+    void SendRequest(int id, Op op, Clock::time_point due);
+    void Flush(int id);
+    void OnReadable(int id, Clock::time_point now);
+    void MakeIdle(int id);
+    void Record(Conn& c, Op op, Clock::time_point due, Outcome outcome, Clock::time_point now);
+    void Fail(int id, Outcome outcome, Clock::time_point now);
+    void Watch(int id, bool write);
+};
+
+std::string AccountName(const std::string& tag, int i) {
+    return "l" + tag + "_" + std::to_string(i);
+}
+
+std::string AccountPassword(int i) {
+    return "load" + std::to_string(i);
+}
+
+Op Worker::PickOp() {
+    const int total = config->mix[0] + config->mix[1] + config->mix[2];
+    int r = std::uniform_int_distribution<int>(0, total - 1)(rng);
+    if (r < config->mix[0]) return OP_LOGIN;
+    r -= config->mix[0];
+    return (r < config->mix[1]) ? OP_REGISTER : OP_CHANGE_PASSWORD;
+}
+
+void Worker::Watch(int id, bool write) {
+    Conn& c = conns[id];
+    epoll_event ev{};
+    ev.events = EPOLLIN | (write ? EPOLLOUT : 0u);
+    ev.data.u64 = (uint64_t)id;
+    if (c.wantWrite != write) {
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+        c.wantWrite = write;
+    }
+}
+
+void Worker::StartConnect(int id, Clock::time_point due) {
+    Conn& c = conns[id];
+    c.due = due;
+    c.sent = Clock::now();
+    c.op = OP_CONNECT;
+    c.in.clear();
+    c.loggedIn = false;
+    c.state = Conn::CONNECTING;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config->port);
+    inet_pton(AF_INET, config->host.c_str(), &addr.sin_addr);
+
+    c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (c.fd < 0) {
+        Fail(id, OUT_FAILED, Clock::now());
+        return;
+    }
+    int one = 1;
+    setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.u64 = (uint64_t)id;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+    c.wantWrite = true;
+
+    if (connect(c.fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        OnConnected(id, Clock::now());
+    } else if (errno != EINPROGRESS) {
+        Fail(id, OUT_FAILED, Clock::now());
+    }
+}
+
+void Worker::OnConnected(int id, Clock::time_point now) {
+    Conn& c = conns[id];
+    Record(c, OP_CONNECT, c.due, OUT_OK, now);
+    // Every connection logs in first, as the game client does.
+    SendRequest(id, OP_LOGIN, now);
+}
+
+void Worker::SendRequest(int id, Op op, Clock::time_point due) {
+    Conn& c = conns[id];
+    Packet packet;
+    if (op == OP_CHANGE_PASSWORD) {
+        // Sets the password it already has, so logins elsewhere keep working.
+        ReqChangePassword req{};
+        const std::string password = AccountPassword(c.account);
+        std::snprintf(req.currentPassword, sizeof(req.currentPassword), "%s", password.c_str());
+        std::snprintf(req.newPassword, sizeof(req.newPassword), "%s", password.c_str());
+        packet = Packet(PacketType::REQ_CHANGE_PASSWORD);
+        packet.SetPayload(req);
+    } else {
+        ReqAuthenticate req{};
+        req.isLogin = (op == OP_LOGIN);
+        if (op == OP_LOGIN) {
+            std::snprintf(req.username, sizeof(req.username), "%s", AccountName(runTag, c.account).c_str());
+            std::snprintf(req.password, sizeof(req.password), "%s", AccountPassword(c.account).c_str());
+        } else {
+            std::snprintf(req.username, sizeof(req.username), "r%sw%dn%llu", runTag.c_str(), index,
+                          (unsigned long long)registered++);
+            std::snprintf(req.password, sizeof(req.password), "register");
+        }
+        packet = Packet(PacketType::REQ_AUTHENTICATE);
+        packet.SetPayload(req);
+    }
+
+    c.out.clear();
+    PacketUtils::SerializePacket(packet, c.out);
+    c.outPos = 0;
+    c.op = op;
+    c.due = due;
+    c.sent = Clock::now();
+    c.state = Conn::BUSY;
+    Flush(id);
+}
+
+void Worker::Flush(int id) {
+    Conn& c = conns[id];
+    while (c.outPos < c.out.size()) {
+        const ssize_t n = send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            Fail(id, OUT_FAILED, Clock::now());
+            return;
+        }
+        c.outPos += (size_t)n;
+    }
+    Watch(id, c.outPos < c.out.size());
+}
+
+void Worker::OnReadable(int id, Clock::time_point now) {
+    Conn& c = conns[id];
+    char buffer[4096];
+    bool closed = false;
+    while (true) {
+        const ssize_t n = recv(c.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            c.in.insert(c.in.end(), buffer, buffer + n);
+            continue;
+        }
+        closed = !(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        break;
+    }
+
+    size_t used = 0;
+    Header header;
+    while (PacketUtils::ReadHeader(c.in.data() + used, c.in.size() - used, header) &&
+           c.in.size() - used >= sizeof(Header) + header.length) {
+        Packet packet;
+        packet.header = header;
+        packet.payload.assign(c.in.begin() + used + sizeof(Header), c.in.begin() + used + sizeof(Header) + header.length);
+        used += sizeof(Header) + header.length;
+
+        const bool isAuth = c.op == OP_LOGIN || c.op == OP_REGISTER;
+        const PacketType expected = isAuth ? PacketType::RES_AUTHENTICATE : PacketType::RES_CHANGE_PASSWORD;
+        if (c.state != Conn::BUSY || header.type != expected) {
+            Fail(id, OUT_FAILED, now);
+            return;
+        }
+
+        bool success = false;
+        if (isAuth && packet.payload.size() >= sizeof(ResAuthenticate)) {
+            success = packet.GetPayload<ResAuthenticate>().isSuccess;
+        } else if (!isAuth && packet.payload.size() >= sizeof(ResChangePassword)) {
+            success = packet.GetPayload<ResChangePassword>().isSuccess;
+        } else {
+            Fail(id, OUT_FAILED, now);
+            return;
+        }
+
+        const Op op = c.op;
+        Record(c, op, c.due, success ? OUT_OK : OUT_REJECTED, now);
+        if (op == OP_LOGIN) {
+            c.loggedIn = success;
+            if (c.storm) {
+                c.storm = false;
+                g_stormLeft--;
+            }
+        }
+        c.state = Conn::IDLE;
+        MakeIdle(id);
+    }
+    c.in.erase(c.in.begin(), c.in.begin() + used);
+    if (closed) {
+        Fail(id, OUT_FAILED, now);
+    }
+}
+
+void Worker::MakeIdle(int id) {
+    if (!pending.empty()) {
+        const auto next = pending.front();
+        pending.pop_front();
+        SendRequest(id, next.second, next.first);
+        return;
+    }
+    const auto now = Clock::now();
+    const bool scheduling = now >= FromTicks(g_scheduleStart) && now < FromTicks(g_measureEnd);
+    if (config->rate <= 0.0 && scheduling) {
+        SendRequest(id, PickOp(), now);
+        return;
+    }
+    idle.push_back(id);
+}
+
+void Worker::Record(Conn& c, Op op, Clock::time_point due, Outcome outcome, Clock::time_point now) {
+    OpStats* stats = nullptr;
+    if (c.storm) {
+        stats = &storm[op];
+    } else if (Ticks(due) >= g_measureStart && Ticks(due) < g_measureEnd) {
+        stats = &steady[op];
+    }
+    if (!stats) return;
+
+    switch (outcome) {
+        case OUT_OK: stats->ok++; break;
+        case OUT_REJECTED: stats->rejected++; break;
+        case OUT_FAILED: stats->failed++; break;
+        case OUT_TIMEOUT: stats->timedOut++; break;
+    }
+    if (outcome == OUT_OK || outcome == OUT_REJECTED) {
+        stats->latencyMs.push_back(Ms(now - due));
+    }
+}
+
+void Worker::Fail(int id, Outcome outcome, Clock::time_point now) {
+    Conn& c = conns[id];
+    if (c.state == Conn::CONNECTING || c.state == Conn::BUSY) {
+        Record(c, c.op, c.due, outcome, now);
+    }
+    if (c.storm) {
+        c.storm = false;
+        g_stormLeft--;
+    }
+    if (c.fd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+        close(c.fd);
+        c.fd = -1;
+    }
+    if (c.state == Conn::IDLE) {
+        idle.erase(std::remove(idle.begin(), idle.end(), id), idle.end());
+    }
+    c.state = Conn::CLOSED;
+    c.loggedIn = false;
+    c.reconnectAt = now + kReconnectDelay;
+}
+
+void Worker::Run() {
+    epollFd = epoll_create1(0);
+    const int count = (int)conns.size();
+    const double connectRate = config->connectRate / config->threads;
+    const double rate = config->rate / config->threads;
+    const auto timeout = Seconds(config->timeout);
+
+    const auto start = Clock::now();
+    int opened = 0;
+    auto nextScan = start;
+    bool scheduled = false;
+    Clock::time_point nextDue;
+    std::vector<epoll_event> events(256);
+
+    while (!g_stop) {
+        auto now = Clock::now();
+        const auto scheduleStart = FromTicks(g_scheduleStart);
+        const auto measureEnd = FromTicks(g_measureEnd);
+
+        // Storm: open connections, all at once or paced.
+        while (opened < count) {
+            const auto due = (connectRate > 0.0) ? start + Seconds(opened / connectRate) : start;
+            if (due > now) break;
+            StartConnect(opened++, due);
+        }
+
+        // Steady phase: queue requests as they come due and hand them to free connections.
+        if (now >= scheduleStart && !scheduled) {
+            scheduled = true;
+            nextDue = scheduleStart + Seconds(rate > 0.0 ? index / config->rate : 0.0);
+            if (rate <= 0.0) {
+                std::vector<int> ready;
+                ready.swap(idle);
+                for (int id : ready) SendRequest(id, PickOp(), now);
+            }
+        }
+        if (scheduled && rate > 0.0) {
+            while (nextDue <= now && nextDue < measureEnd) {
+                pending.emplace_back(nextDue, PickOp());
+                nextDue += Seconds(1.0 / rate);
+            }
+            while (!pending.empty() && !idle.empty()) {
+                const int id = idle.back();
+                idle.pop_back();
+                const auto next = pending.front();
+                pending.pop_front();
+                SendRequest(id, next.second, next.first);
+            }
+        }
+
+        // Timeouts and reconnects.
+        if (now >= nextScan) {
+            nextScan = now + kScanInterval;
+            bool outstanding = false;
+            for (int id = 0; id < opened; id++) {
+                Conn& c = conns[id];
+                if ((c.state == Conn::BUSY || c.state == Conn::CONNECTING) && now - c.sent > timeout) {
+                    Fail(id, OUT_TIMEOUT, now);
+                } else if (c.state == Conn::CLOSED && now >= c.reconnectAt && now < measureEnd) {
+                    StartConnect(id, now);
+                }
+                if (c.state == Conn::BUSY && c.due < measureEnd) outstanding = true;
+            }
+            // Done once the window is over and everything sent in it is answered.
+            if (now >= measureEnd && !outstanding) break;
+        }
+
+        // Sleep until the next thing is due, or a socket is ready.
+        auto wake = nextScan;
+        if (opened < count && connectRate > 0.0) wake = std::min(wake, start + Seconds(opened / connectRate));
+        if (scheduled && rate > 0.0 && nextDue < measureEnd) wake = std::min(wake, nextDue);
+        if (!scheduled) wake = std::min(wake, scheduleStart);
+        const int waitMs = (int)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count());
+
+        const int n = epoll_wait(epollFd, events.data(), (int)events.size(), waitMs);
+        now = Clock::now();
+        for (int i = 0; i < n; i++) {
+            const int id = (int)events[i].data.u64;
+            Conn& c = conns[id];
+            if (c.fd < 0) continue;
+
+            if (c.state == Conn::CONNECTING) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0 || (events[i].events & (EPOLLERR | EPOLLHUP))) {
+                    Fail(id, OUT_FAILED, now);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    OnConnected(id, now);
+                }
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && c.state == Conn::BUSY) {
+                Flush(id);
+                if (c.fd < 0) continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                OnReadable(id, now);
+            }
+        }
+    }
+
+    for (const auto& entry : pending) {
+        if (Ticks(entry.first) >= g_measureStart && Ticks(entry.first) < g_measureEnd) unsent++;
+    }
+    for (Conn& c : conns) {
+        if (c.storm) g_stormLeft--;
+        c.storm = false;
+        if (c.fd >= 0) close(c.fd);
+        c.fd = -1;
+    }
+    close(epollFd);
+}
+
+// Registers the accounts the connections log in as. Returns false if the server is
+// unreachable or refuses a registration.
+bool RegisterAccounts(const LoadConfig& config, const std::string& runTag) {
+    std::atomic<int> next(0);
+    std::atomic<bool> ok(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < config.threads; t++) {
+        threads.emplace_back([&] {
+            std::unique_ptr<TCPSocket> socket;
+            // An in-process or freshly started server may not be listening yet.
+            for (int attempt = 0; attempt < 50 && !socket && !g_stop; attempt++) {
+                try {
+                    socket.reset(new TCPSocket());
+                    socket->Connect(config.host, config.port);
+                } catch (const std::exception&) {
+                    socket.reset();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+            if (!socket) {
+                ok = false;
+                return;
+            }
+            for (int i = next++; i < config.users && ok && !g_stop; i = next++) {
+                ReqAuthenticate req{};
+                req.isLogin = false;
+                std::snprintf(req.username, sizeof(req.username), "%s", AccountName(runTag, i).c_str());
+                std::snprintf(req.password, sizeof(req.password), "%s", AccountPassword(i).c_str());
+                ResAuthenticate res{};
+                if (!PacketUtils::SendPacket(socket.get(), PacketType::REQ_AUTHENTICATE, req) ||
+                    !PacketUtils::ReceivePacketPayload(socket.get(), res) || !res.isSuccess) {
+                    ok = false;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    return ok && !g_stop;
+}
+
+double Percentile(std::vector<double>& v, double q) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t i = std::min(v.size() - 1, (size_t)(q * (double)(v.size() - 1) + 0.5));
+    return v[i];
+}
+
+struct Summary {
+    double p50 = 0.0, p99 = 0.0, p999 = 0.0, max = 0.0;
+};
+
+Summary Summarize(OpStats& stats) {
+    Summary s;
+    s.p50 = Percentile(stats.latencyMs, 0.50);
+    s.p99 = Percentile(stats.latencyMs, 0.99);
+    s.p999 = Percentile(stats.latencyMs, 0.999);
+    s.max = stats.latencyMs.empty() ? 0.0 : stats.latencyMs.back();
+    return s;
+}
+
+void PrintRow(const char* name, OpStats& stats) {
+    if (stats.Total() == 0) return;
+    const Summary s = Summarize(stats);
+    std::printf("  %-16s p50 %8.2f  p99 %8.2f  p99.9 %8.2f  max %8.2f ms  n %-8llu errors %6.3f%% "
+                "(rejected %llu, failed %llu, timeout %llu)\n",
+                name, s.p50, s.p99, s.p999, s.max, (unsigned long long)stats.Total(),
+                100.0 * (double)stats.Errors() / (double)stats.Total(), (unsigned long long)stats.rejected,
+                (unsigned long long)stats.failed, (unsigned long long)stats.timedOut);
+}
+
+std::string JsonRow(const char* name, OpStats& stats) {
+    const Summary s = Summarize(stats);
+    char row[512];
+    std::snprintf(row, sizeof(row),
+                  "\"%s\": {\"p50\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f, \"total\": %llu, "
+                  "\"ok\": %llu, \"rejected\": %llu, \"failed\": %llu, \"timeout\": %llu}",
+                  name, s.p50, s.p99, s.p999, s.max, (unsigned long long)stats.Total(), (unsigned long long)stats.ok,
+                  (unsigned long long)stats.rejected, (unsigned long long)stats.failed,
+                  (unsigned long long)stats.timedOut);
+    return row;
+}
+
+bool ParseArgs(int argc, char** argv, LoadConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--host") == 0 && hasValue) {
+            config.host = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && hasValue) {
+            config.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--in-process") == 0) {
+            config.inProcess = true;
+        } else if (std::strcmp(argv[i], "--connections") == 0 && hasValue) {
+            config.connections = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--connect-rate") == 0 && hasValue) {
+            config.connectRate = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--rate") == 0 && hasValue) {
+            config.rate = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--mix") == 0 && hasValue) {
+            if (std::sscanf(argv[++i], "%d,%d,%d", &config.mix[0], &config.mix[1], &config.mix[2]) != 3 ||
+                config.mix[0] < 0 || config.mix[1] < 0 || config.mix[2] < 0 ||
+                config.mix[0] + config.mix[1] + config.mix[2] <= 0) {
+                std::cerr << "service_load: --mix wants three non-negative weights, e.g. 80,10,10" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--users") == 0 && hasValue) {
+            config.users = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            config.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--duration") == 0 && hasValue) {
+            config.duration = std::max(1.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            config.warmup = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--timeout") == 0 && hasValue) {
+            config.timeout = std::max(0.1, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--server-pid") == 0 && hasValue) {
+            config.serverPids.push_back(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            config.outPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--host H] [--port P] [--in-process] [--connections N] [--connect-rate R] [--rate R]"
+                         " [--mix LOGIN,REGISTER,CHANGE] [--users N] [--threads T] [--duration S] [--warmup S]"
+                         " [--timeout S] [--server-pid PID]... [--out FILE]" << std::endl;
+            return false;
+        }
+    }
+    if (config.port <= 0) {
+        std::cerr << "service_load: invalid port" << std::endl;
+        return false;
+    }
+    config.threads = std::min(config.threads, config.connections);
+    return true;
+}
+
+void HandleSigInt(int) {
+    g_stop = true;
+}
+}
+
+int main(int argc, char** argv) {
+    LoadConfig config;
+    if (!ParseArgs(argc, argv, config)) return 1;
+    std::signal(SIGINT, HandleSigInt);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Each connection is a descriptor here, and two with --in-process.
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+    const rlim_t needed = (rlim_t)config.connections * (config.inProcess ? 2 : 1) + 64;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < needed) {
+        std::cerr << "service_load: descriptor limit " << files.rlim_cur << " is below the " << needed
+                  << " this run needs (ulimit -n)" << std::endl;
+        return 1;
+    }
+
+    if (config.inProcess) {
+        // The server logs every connection; results are printed with printf.
+        std::cout.setstate(std::ios::failbit);
+        Log::setLevel(Log::LEVEL_WARN);
+        // Deliberately never stopped or freed: Run() blocks in accept and its client
+        // threads are detached. Both end with the process.
+        ServiceServer* server = new ServiceServer(new MemoryUserDAO());
+        std::thread([server, &config] { server->Run(config.port); }).detach();
+    }
+
+    // Accounts from a previous run may still exist in PostgreSQL; tag this run's names.
+    char tag[16];
+    std::snprintf(tag, sizeof(tag), "%x", (unsigned)((uint32_t)getpid() * 2654435761u ^ (uint32_t)time(nullptr)) & 0xffffffu);
+    const std::string runTag = tag;
+
+    std::printf("registering %d accounts on %s:%d%s\n", config.users, config.host.c_str(), config.port,
+                config.inProcess ? " (in-process, memory storage)" : "");
+    std::fflush(stdout);
+    if (!RegisterAccounts(config, runTag)) {
+        std::cerr << "service_load: could not register the test accounts on " << config.host << ":" << config.port
+                  << std::endl;
+        return 1;
+    }
+
+    std::vector<Worker> workers(config.threads);
+    for (int t = 0; t < config.threads; t++) {
+        Worker& w = workers[t];
+        w.index = t;
+        w.config = &config;
+        w.runTag = runTag;
+        w.rng.seed(0x5eed + t);
+        w.conns.resize(config.connections / config.threads + (t < config.connections % config.threads ? 1 : 0));
+        for (size_t i = 0; i < w.conns.size(); i++) {
+            w.conns[i].account = (int)((i * config.threads + t) % (size_t)config.users);
+        }
+    }
+
+    std::vector<double> cpuStart;
+    for (int pid : config.serverPids) cpuStart.push_back(ProcStat::CpuSeconds(pid));
+
+    const std::string load = config.rate > 0.0 ? std::to_string((int)config.rate) + " req/s" : "closed loop";
+    std::printf("storm: %d connections%s, then %s for %.1f s (+%.1f s warmup), mix %d/%d/%d login/register/change\n",
+                config.connections, config.connectRate > 0.0 ? " paced" : " at once", load.c_str(), config.duration, config.warmup, config.mix[0], config.mix[1], config.mix[2]);
+    std::fflush(stdout);
+
+    g_stormLeft = config.connections;
+    const auto stormStart = Clock::now();
+    std::vector<std::thread> threads;
+    for (auto& w : workers) threads.emplace_back([&w] { w.Run(); });
+
+    while (g_stormLeft > 0 && !g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto stormEnd = Clock::now();
+    const auto measureStart = stormEnd + Seconds(config.warmup);
+    g_measureEnd = Ticks(measureStart + Seconds(config.duration));
+    g_measureStart = Ticks(measureStart);
+    g_scheduleStart = Ticks(stormEnd);
+
+    for (auto& thread : threads) thread.join();
+    const double measured = std::max(1e-3, std::min(config.duration,
+        std::chrono::duration<double>(Clock::now() - measureStart).count()));
+
+    double cpuTotal = 0.0;
+    int cpuCount = 0;
+    for (size_t i = 0; i < config.serverPids.size(); i++) {
+        const double end = ProcStat::CpuSeconds(config.serverPids[i]);
+        if (cpuStart[i] < 0.0 || end < 0.0) continue;
+        cpuTotal += (end - cpuStart[i]) / std::chrono::duration<double>(Clock::now() - stormStart).count();
+        cpuCount++;
+    }
+
+    OpStats storm[OP_COUNT], steady[OP_COUNT], steadyAll;
+    uint64_t unsent = 0;
+    for (auto& w : workers) {
+        for (int op = 0; op < OP_COUNT; op++) {
+            storm[op].Merge(w.storm[op]);
+            steady[op].Merge(w.steady[op]);
+            if (op != OP_CONNECT) steadyAll.Merge(w.steady[op]);
+        }
+        unsent += w.unsent;
+    }
+
+    std::printf("\nstorm: %d connections connected and logged in after %.1f ms\n", config.connections,
+                Ms(stormEnd - stormStart));
+    PrintRow(kOpNames[OP_CONNECT], storm[OP_CONNECT]);
+    PrintRow(kOpNames[OP_LOGIN], storm[OP_LOGIN]);
+
+    std::printf("steady: %.1f s, %llu requests, %.1f answered/s\n", measured, (unsigned long long)steadyAll.Total(),
+                (double)steadyAll.latencyMs.size() / measured);
+    for (int op = OP_LOGIN; op < OP_COUNT; op++) PrintRow(kOpNames[op], steady[op]);
+    PrintRow("all", steadyAll);
+    PrintRow("reconnect", steady[OP_CONNECT]);
+    if (unsent > 0) {
+        std::printf("  %llu requests due in the window never got a free connection (offered load too high)\n",
+                    (unsigned long long)unsent);
+    }
+    if (cpuCount > 0) {
+        std::printf("server cpu: %.2f cores\n", cpuTotal);
+    }
+
+    if (!config.outPath.empty()) {
+        std::ofstream out(config.outPath);
+        std::ostringstream json;
+        json << "{\n  \"connections\": " << config.connections << ",\n  \"rate\": " << config.rate
+             << ",\n  \"in_process\": " << (config.inProcess ? "true" : "false")
+             << ",\n  \"storm_ms\": " << Ms(stormEnd - stormStart) << ",\n  \"measured_s\": " << measured
+             << ",\n  \"unsent\": " << unsent << ",\n  \"server_cpu_cores\": " << cpuTotal
+             << ",\n  \"storm\": {" << JsonRow(kOpNames[OP_CONNECT], storm[OP_CONNECT]) << ", "
+             << JsonRow(kOpNames[OP_LOGIN], storm[OP_LOGIN]) << "},\n  \"steady\": {";
+        for (int op = OP_LOGIN; op < OP_COUNT; op++) json << JsonRow(kOpNames[op], steady[op]) << ", ";
+        json << JsonRow("all", steadyAll) << ", " << JsonRow("reconnect", steady[OP_CONNECT]) << "}\n}\n";
+        if (!out || !(out << json.str())) {
+            std::cerr << "service_load: failed to write " << config.outPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -4,7 +4,6 @@
 #pragma once
 #include "../../common/network/Packet.hpp"
 #include "../database/UserDAO.hpp"
-#include "../database/DatabaseServer.hpp"
 #include <iostream>
 #include <vector>
 #include <cstring>
@@ -1,6 +1,15 @@
 #include "core/ServiceServer.hpp"
+#include "database/PostgresUserDAO.hpp"
+#include "database/PostgresMatchDAO.hpp"
+#include "database/MemoryUserDAO.hpp"
+#include "database/MeteredUserDAO.hpp"
+#include "../common/metrics/AllocationCounter.hpp"
+#include "../common/utils/Log.hpp"
 #include <iostream>
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
 
 // Global pointer for signal handling to stop server gracefully
 ServiceServer* g_Server = nullptr;
@@ -12,21 +21,86 @@ void SignalHandler(int signum) {
     }
 }
 
-int main() {
+DatabaseServer* CreateAndConnectDatabase() {
+    DatabaseServer* db = new DatabaseServer("gummydatabase", "postgres", "Hehehe123");
+
+    if (!db->connect()) {
+        std::cerr << "ServiceServer: Could not connect to database!" << std::endl;
+    } else {
+        std::cout << "ServiceServer: Database connected successfully." << std::endl;
+    }
+
+    return db;
+}
+
+int main(int argc, char** argv) {
+    // Usage: service_server [port] [--memory-db] [--metrics-port PORT]
+    //                      [--log-level debug|info|warn|error|off] [--log-file FILE]
+    //   --memory-db keeps users in process (MemoryUserDAO) instead of PostgreSQL; match
+    //   log paths reported by ingame servers are then dropped.
+    //   --metrics-port serves Prometheus metrics on 127.0.0.1 (off by default).
+    //   The event log goes to stderr unless --log-file is given.
+    int port = 8080;
+    bool memoryDb = false;
+    int metricsPort = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--memory-db") == 0) {
+            memoryDb = true;
+        } else if (std::strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) {
+            metricsPort = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            Log::Level level;
+            if (!Log::parseLevel(argv[++i], level)) {
+                std::cerr << "Unknown log level " << argv[i] << std::endl;
+                return 1;
+            }
+            Log::setLevel(level);
+        } else if (std::strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) {
+            if (!Log::openFile(argv[++i])) {
+                std::cerr << "Cannot open log file " << argv[i] << std::endl;
+                return 1;
+            }
+        } else {
+            port = std::atoi(argv[i]);
+            if (port <= 0) port = 8080;
+        }
+    }
+
     // Register signal handler for Ctrl+C
     signal(SIGINT, SignalHandler);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Every client holds a descriptor; the default soft limit of 1024 is too low.
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
 
     std::cout << "Initializing Service Server..." << std::endl;
-    
-    // NOTE: Ensure ServiceServer.cpp constructor initializes AuthServer/UserDAO/DatabaseServer 
-    // with valid credentials (e.g., "gummydatabase", "postgres", "Hehehe123")
-    ServiceServer server;
+
+    // NOTE: CreateAndConnectDatabase uses the local database credentials
+    // (e.g., "gummydatabase", "postgres", "Hehehe123")
+    DatabaseServer* db = memoryDb ? nullptr : CreateAndConnectDatabase();
+    MeteredUserDAO* dao = new MeteredUserDAO(db ? static_cast<UserDAO*>(new PostgresUserDAO(db)) : new MemoryUserDAO());
+    ServiceServer server(dao, db ? new PostgresMatchDAO(db) : nullptr);
     g_Server = &server;
 
-    // Run the server on port 8080
+    MetricsServer metrics;
+    if (metricsPort > 0) {
+        metrics.Start(metricsPort, [&server, dao](PrometheusText& out) {
+            server.WriteMetrics(out);
+            dao->WriteMetrics(out);
+            Metrics::WritePacketMetrics(out);
+            Metrics::WriteAllocationMetrics(out);
+        });
+    }
+
+    // Run the server on the given port (default 8080)
     // This function blocks until the server is stopped
-    server.Run(8080);
+    server.Run(port);
+    metrics.Stop();
 
     std::cout << "Server stopped. Goodbye!" << std::endl;
     return 0;
-}
\ No newline at end of file
+}